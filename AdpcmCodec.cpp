@@ -0,0 +1,133 @@
+#include "AdpcmCodec.hpp"
+#include <algorithm>
+#include <cstring>
+
+static const int16_t STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t INDEX_TABLE[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+// (ステップ番号, 符号の下位3bit) → 差分の大きさ / 次のステップ番号。
+// デコードの1サンプルを表引き2回にして、ボイスごとの展開コストを下げる
+struct StepTables {
+    int32_t diff[89][8];
+    uint8_t next[89][8];
+    StepTables() {
+        for (int i = 0; i < 89; ++i) {
+            for (int c = 0; c < 8; ++c) {
+                int32_t s = STEP_TABLE[i];
+                int32_t d = s >> 3;
+                if (c & 4) d += s;
+                if (c & 2) d += s >> 1;
+                if (c & 1) d += s >> 2;
+                diff[i][c] = d;
+                next[i][c] = (uint8_t)std::clamp(i + INDEX_TABLE[c], 0, 88);
+            }
+        }
+    }
+};
+static const StepTables TABLES;
+
+// 符号 code を1つ戻す (エンコーダも同じ式で予測値を追う)
+static inline void step(int32_t& pred, int32_t& index, uint8_t code) {
+    int32_t d = TABLES.diff[index][code & 7];
+    pred  = std::clamp(pred + ((code & 8) ? -d : d), -32768, 32767);
+    index = TABLES.next[index][code & 7];
+}
+
+size_t AdpcmCodec::encodedBytes(uint32_t frames, int channels) {
+    size_t blocks = (frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+    return blocks * blockBytes(channels);
+}
+
+void AdpcmCodec::encode(const int16_t* pcm, uint32_t frames, int channels, uint8_t* out) {
+    std::memset(out, 0, encodedBytes(frames, channels));
+    int32_t index[2] = {0, 0};
+    const size_t bb = blockBytes(channels);
+
+    for (uint32_t b0 = 0, blk = 0; b0 < frames; b0 += BLOCK_FRAMES, ++blk) {
+        uint8_t* block = out + blk * bb;
+        uint8_t* body  = block + channels * 4;
+        int32_t  pred[2];
+        // ブロック先頭で予測値を原音に合わせ直す (ステップ番号は前のブロックから引き継ぐ)
+        for (int c = 0; c < channels; ++c) {
+            pred[c] = pcm[(size_t)b0 * channels + c];
+            int16_t p = (int16_t)pred[c];
+            std::memcpy(block + c * 4, &p, 2);
+            block[c * 4 + 2] = (uint8_t)index[c];
+        }
+
+        uint32_t n = std::min(BLOCK_FRAMES, frames - b0);
+        for (uint32_t f = 0; f < n; ++f) {
+            for (int c = 0; c < channels; ++c) {
+                int32_t diff = pcm[(size_t)(b0 + f) * channels + c] - pred[c];
+                uint8_t code = 0;
+                if (diff < 0) {
+                    code = 8;
+                    diff = -diff;
+                }
+                int32_t s = STEP_TABLE[index[c]];
+                if (diff >= s)      { code |= 4; diff -= s; }
+                if (diff >= s >> 1) { code |= 2; diff -= s >> 1; }
+                if (diff >= s >> 2) { code |= 1; }
+                step(pred[c], index[c], code);
+
+                uint32_t nib = f * channels + c;
+                body[nib >> 1] |= (nib & 1) ? (uint8_t)(code << 4) : code;
+            }
+        }
+    }
+}
+
+void AdpcmCodec::decode(const uint8_t* data, int channels, Cursor& c, int16_t* out, uint32_t frames) {
+    const size_t bb = blockBytes(channels);
+    while (frames > 0) {
+        uint32_t inBlock = c.frame % BLOCK_FRAMES;
+        const uint8_t* block = data + (size_t)(c.frame / BLOCK_FRAMES) * bb;
+        if (inBlock == 0) {
+            for (int k = 0; k < channels; ++k) {
+                int16_t p;
+                std::memcpy(&p, block + k * 4, 2);
+                c.pred[k]  = p;
+                c.index[k] = std::min<int32_t>(block[k * 4 + 2], 88);
+            }
+        }
+        const uint8_t* body = block + channels * 4;
+        uint32_t n = std::min(frames, BLOCK_FRAMES - inBlock);
+
+        if (channels == 1) {
+            int32_t pred = c.pred[0], index = c.index[0];
+            for (uint32_t f = inBlock; f < inBlock + n; ++f) {
+                uint8_t b = body[f >> 1];
+                step(pred, index, (f & 1) ? (uint8_t)(b >> 4) : (uint8_t)(b & 0x0F));
+                if (out) *out++ = (int16_t)pred;
+            }
+            c.pred[0]  = pred;
+            c.index[0] = index;
+        } else {
+            // ステレオ: 1 バイト = L / R の1フレーム
+            for (uint32_t f = inBlock; f < inBlock + n; ++f) {
+                uint8_t b = body[f];
+                step(c.pred[0], c.index[0], (uint8_t)(b & 0x0F));
+                step(c.pred[1], c.index[1], (uint8_t)(b >> 4));
+                if (out) {
+                    *out++ = (int16_t)c.pred[0];
+                    *out++ = (int16_t)c.pred[1];
+                }
+            }
+        }
+        c.frame += n;
+        frames  -= n;
+    }
+}
+
+void AdpcmCodec::seek(const uint8_t* data, int channels, Cursor& c, uint32_t frame) {
+    c.frame = frame - frame % BLOCK_FRAMES;
+    decode(data, channels, c, nullptr, frame - c.frame);
+    // frame がブロック先頭なら何もデコードしていないが、次の decode がヘッダを読む
+}
@@ -0,0 +1,43 @@
+#ifndef ADPCMCODEC_HPP
+#define ADPCMCODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// ============================================================
+//  AdpcmCodec — キー音をメモリ上で圧縮して持つための IMA ADPCM (4bit)
+//
+//  めったに鳴らない音・BGM レーンだけの音を int16 の約 1/4 で持ち、
+//  ミキサーのボイスが鳴らしながら少しずつデコードする。
+//
+//  【形式】BLOCK_FRAMES フレームごとのブロックの並び (最後のブロックも同じ大きさ)
+//    ヘッダ : チャンネルごとに { int16 予測値, uint8 ステップ番号, uint8 0 }
+//    本体   : BLOCK_FRAMES × channels 個の 4bit 符号 (インターリーブ順、下位ニブルが先)
+//  ブロックごとに予測値を原音に合わせ直すので誤差は溜まらず、
+//  ブロック先頭から始めれば任意の位置へシークできる (BGM の事前ミックス用)。
+//
+//  SDL に依存しないため tools/ のベンチマークからもそのまま使える。
+// ============================================================
+class AdpcmCodec {
+public:
+    static constexpr uint32_t BLOCK_FRAMES = 256;
+
+    // デコードの途中状態。ボイスごとに1つ持つ
+    struct Cursor {
+        uint32_t frame    = 0;
+        int32_t  pred[2]  = {0, 0};
+        int32_t  index[2] = {0, 0};
+    };
+
+    static size_t blockBytes(int channels) { return (size_t)channels * 4 + (size_t)BLOCK_FRAMES * channels / 2; }
+    static size_t encodedBytes(uint32_t frames, int channels);
+
+    // pcm (インターリーブ int16、channels は 1 か 2) を out (encodedBytes 分) へ
+    static void encode(const int16_t* pcm, uint32_t frames, int channels, uint8_t* out);
+    // c.frame から frames フレームを out へ書き、c を進める
+    static void decode(const uint8_t* data, int channels, Cursor& c, int16_t* out, uint32_t frames);
+    // c を frame の位置に合わせる (ブロック先頭から空デコードする)
+    static void seek(const uint8_t* data, int channels, Cursor& c, uint32_t frame);
+};
+
+#endif // ADPCMCODEC_HPP
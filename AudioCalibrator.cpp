@@ -0,0 +1,96 @@
+#include "AudioCalibrator.hpp"
+#include "AudioMixer.hpp"
+#include "AdpcmCodec.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+static constexpr int WARMUP    = 4;
+static constexpr int CALLBACKS = 32;
+static constexpr int RETRIGGERS_PER_CALLBACK = 8;
+
+std::vector<AudioCalibrator::Candidate> AudioCalibrator::candidates(const Limits& limits) {
+    std::vector<Candidate> out;
+    std::vector<int> buffers;
+    for (int b = 128; b <= 4096; b *= 2) {
+        if (b >= limits.minBuffer && b <= limits.maxBuffer) buffers.push_back(b);
+    }
+    if (buffers.empty()) buffers.push_back(std::max(limits.minBuffer, 128));
+
+    for (int rate : {48000, 44100, 32000, 22050}) {
+        if (rate > limits.maxRate && rate != 22050) continue; // 22050 は常に候補に残す
+        for (int ch : {2, 1}) {
+            if (ch > limits.maxChannels && ch != 1) continue;
+            for (int b : buffers) out.push_back(Candidate{rate, ch, b});
+        }
+    }
+    std::stable_sort(out.begin(), out.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.latencyMs() != b.latencyMs()) return a.latencyMs() < b.latencyMs();
+        if (a.rate != b.rate) return a.rate > b.rate;
+        return a.channels > b.channels;
+    });
+    return out;
+}
+
+AudioCalibrator::Measurement AudioCalibrator::measure(const Candidate& c, double loadLimit) {
+    Measurement m;
+    m.c        = c;
+    m.periodUs = c.buffer * 1e6 / c.rate;
+
+    // AudioMixer は固定長の配列を抱えていて大きいので、スタックには置かない
+    auto mixer = std::make_unique<AudioMixer>();
+    mixer->configure(c.rate, c.channels);
+
+    // 全コールバック分鳴り続けるノイズ (同じ音を位相をずらして使い回す)
+    const uint32_t len    = (uint32_t)c.buffer * (uint32_t)c.channels * (WARMUP + CALLBACKS + 2);
+    const uint32_t frames = len / (uint32_t)c.channels;
+    std::vector<int16_t> pcm((size_t)len * 2);
+    uint32_t seed = 0x12345678u;
+    for (auto& s : pcm) {
+        seed = seed * 1664525u + 1013904223u;
+        s = (int16_t)((int32_t)(seed >> 16) - 32768) / 3;
+    }
+    std::vector<uint8_t> adpcm(AdpcmCodec::encodedBytes(frames, c.channels));
+    AdpcmCodec::encode(pcm.data(), frames, c.channels, adpcm.data());
+
+    uint32_t id = 0;
+    auto fire = [&]() {
+        if (id % 4 == 0) {
+            mixer->triggerAdpcm(adpcm.data(), len, id, 0.2f, AudioMixer::PRIORITY_BGM);
+        } else {
+            size_t offset = ((size_t)id * 7919 % frames) * (size_t)c.channels;
+            mixer->trigger(pcm.data() + offset, len, id, 0.2f, AudioMixer::PRIORITY_BGM);
+        }
+        id++;
+    };
+    for (int v = 0; v < AudioMixer::MAX_VOICES; v++) fire();
+
+    std::vector<int16_t> out((size_t)c.buffer * (size_t)c.channels);
+    std::vector<double>  us;
+    us.reserve(CALLBACKS);
+    for (int i = 0; i < WARMUP + CALLBACKS; i++) {
+        for (int k = 0; k < RETRIGGERS_PER_CALLBACK; k++) fire(); // 満杯なので毎回奪い合いになる
+        mixer->mix(out.data(), c.buffer);
+        if (i >= WARMUP) us.push_back(mixer->getStats().lastCallbackUs);
+    }
+    // 1 回だけの外れ値 (OS のスケジューリング) は除く
+    std::sort(us.begin(), us.end());
+    m.worstUs = us.size() >= 2 ? us[us.size() - 2] : us.back();
+    m.ok      = m.worstUs <= m.periodUs * loadLimit;
+    return m;
+}
+
+AudioCalibrator::Measurement AudioCalibrator::choose(const Limits& limits, std::vector<Measurement>* tested) {
+    Measurement best;
+    bool haveBest = false;
+    for (const Candidate& c : candidates(limits)) {
+        Measurement m = measure(c, limits.loadLimit);
+        if (tested) tested->push_back(m);
+        if (m.ok) return m;
+        if (!haveBest || m.worstUs / m.periodUs < best.worstUs / best.periodUs) {
+            best     = m;
+            haveBest = true;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,55 @@
+#ifndef AUDIOCALIBRATOR_HPP
+#define AUDIOCALIBRATOR_HPP
+
+#include <vector>
+
+// ============================================================
+//  AudioCalibrator — 起動時のオーディオ形式 (レート / チャンネル / バッファ) の自動選択
+//
+//  【旧実装の問題点】
+//    Mix_OpenAudio(22050, 1ch, 512) 固定で、速い機器でも遅延を詰められず、
+//    遅い機器でも途切れを避けるためにバッファを増やす手段が無かった。
+//
+//  【方法】
+//    候補を遅延 (バッファ長 ms) の短い順に並べ、AudioMixer を実際にその形式で
+//    構成して最悪ケースの合成負荷 (MAX_VOICES 本が鳴りっぱなし、1/4 は ADPCM、
+//    毎コールバック 8 発のトリガーでボイスの奪い合いが起きる状態) を掛ける。
+//    コールバック時間の上位 (外れ値 1 回を除いた最大) が周期の loadLimit 以下に
+//    収まった最初の候補を選ぶ。同じ遅延なら高いレート・ステレオを先に試す。
+//    デバイスは開かない (Switch では開き直しが失敗しうるため、開くのは選んだ後の1回だけ)。
+//    実機での途切れは AudioMixer::Stats::underruns で数え、次回起動時の
+//    minBuffer に反映する (SoundManager 参照)。
+//
+//  SDL に依存しないため tools/ からもそのまま使える。
+// ============================================================
+class AudioCalibrator {
+public:
+    struct Candidate {
+        int rate     = 22050;
+        int channels = 1;
+        int buffer   = 512; // フレーム数
+        double latencyMs() const { return buffer * 1000.0 / rate; }
+    };
+    struct Limits {
+        int    maxRate     = 48000;
+        int    maxChannels = 2;
+        int    minBuffer   = 256;
+        int    maxBuffer   = 2048;
+        double loadLimit   = 0.3; // コールバック時間 / 周期 の上限 (描画など他のスレッドの分を残す)
+    };
+    struct Measurement {
+        Candidate c;
+        double    worstUs  = 0.0; // 外れ値 1 回を除いた最大のコールバック時間
+        double    periodUs = 0.0;
+        bool      ok       = false;
+    };
+
+    // 試す順 (遅延が短い順。同じなら高レート・多チャンネルが先)
+    static std::vector<Candidate> candidates(const Limits& limits);
+    static Measurement measure(const Candidate& c, double loadLimit);
+    // 条件を満たす最初の候補。どれも満たさなければ余裕が最も大きい候補 (ok = false)。
+    // tested を渡すと計測した分を順に入れる
+    static Measurement choose(const Limits& limits, std::vector<Measurement>* tested = nullptr);
+};
+
+#endif // AUDIOCALIBRATOR_HPP
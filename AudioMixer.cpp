@@ -0,0 +1,519 @@
+#include "AudioMixer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#define MIXER_USE_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIXER_USE_SSE2 1
+#endif
+
+// ============================================================
+//  積算カーネル
+//    accumulate: dst[i] += src[i] * gain   (int16 → float)
+//    store     : out[i]  = sat16(src[i])   (float → int16、飽和)
+//  SIMD 版は 8 サンプル単位で処理し、端数はスカラーで片付ける。
+// ============================================================
+
+static void accumulateScalar(float* dst, const int16_t* src, int n, float gain) {
+    for (int i = 0; i < n; i++) dst[i] += (float)src[i] * gain;
+}
+
+// フェードアウト: フレームごとに gain から step ずつ下げながら積算する (チョークの数 ms 分だけ)
+static void accumulateRamp(float* dst, const int16_t* src, int n, float gain, float step, int channels) {
+    for (int i = 0; i < n; i += channels) {
+        for (int c = 0; c < channels; c++) dst[i + c] += (float)src[i + c] * gain;
+        gain = std::max(0.0f, gain - step);
+    }
+}
+
+static void storeScalar(int16_t* out, const float* src, int n) {
+    for (int i = 0; i < n; i++) {
+        float v = src[i];
+        if (v >  32767.0f) v =  32767.0f;
+        if (v < -32768.0f) v = -32768.0f;
+        out[i] = (int16_t)v;
+    }
+}
+
+#if defined(MIXER_USE_NEON)
+static void accumulateSimd(float* dst, const int16_t* src, int n, float gain) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t s  = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(dst + i,     vmlaq_n_f32(vld1q_f32(dst + i),     lo, gain));
+        vst1q_f32(dst + i + 4, vmlaq_n_f32(vld1q_f32(dst + i + 4), hi, gain));
+    }
+    accumulateScalar(dst + i, src + i, n - i, gain);
+}
+
+static void storeSimd(int16_t* out, const float* src, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t lo = vcvtq_s32_f32(vld1q_f32(src + i));
+        int32x4_t hi = vcvtq_s32_f32(vld1q_f32(src + i + 4));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))); // 飽和パック
+    }
+    storeScalar(out + i, src + i, n - i);
+}
+#elif defined(MIXER_USE_SSE2)
+static void accumulateSimd(float* dst, const int16_t* src, int n, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i s  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // 符号拡張: 上位16bitに複製してから算術シフト
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        __m128 a = _mm_add_ps(_mm_loadu_ps(dst + i),     _mm_mul_ps(_mm_cvtepi32_ps(lo), g));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(_mm_cvtepi32_ps(hi), g));
+        _mm_storeu_ps(dst + i,     a);
+        _mm_storeu_ps(dst + i + 4, b);
+    }
+    accumulateScalar(dst + i, src + i, n - i, gain);
+}
+
+static void storeSimd(int16_t* out, const float* src, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_cvttps_epi32(_mm_loadu_ps(src + i));
+        __m128i hi = _mm_cvttps_epi32(_mm_loadu_ps(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi)); // 飽和パック
+    }
+    storeScalar(out + i, src + i, n - i);
+}
+#else
+static void accumulateSimd(float* dst, const int16_t* src, int n, float gain) { accumulateScalar(dst, src, n, gain); }
+static void storeSimd(int16_t* out, const float* src, int n) { storeScalar(out, src, n); }
+#endif
+
+void AudioMixer::accumulate(float* dst, const int16_t* src, int n, float gain) {
+    accumulateSimd(dst, src, n, gain);
+}
+
+void AudioMixer::store(int16_t* out, const float* src, int n) {
+    storeSimd(out, src, n);
+}
+
+const char* AudioMixer::kernelName() {
+#if defined(MIXER_USE_NEON)
+    return "NEON";
+#elif defined(MIXER_USE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// ============================================================
+//  configure / trigger (メインスレッド)
+// ============================================================
+
+void AudioMixer::configure(int rate, int ch) {
+    sampleRate = (rate > 0) ? rate : 22050;
+    channels   = (ch == 2) ? 2 : 1;
+    fadeFrames = std::max(1, sampleRate * CHOKE_FADE_MS / 1000);
+    resetVoices();
+}
+
+bool AudioMixer::push(const Trigger& t) {
+    if (!queue.push(t)) {
+        droppedTriggers.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool AudioMixer::trigger(const int16_t* pcm, uint32_t samples, uint32_t soundId,
+                         float gain, Priority priority, uint32_t onsetFrames, uint16_t chokeGroup,
+                         uint32_t probeId) {
+    if (!pcm || samples == 0) return false;
+    return push({pcm, samples, soundId, gain, priority, false, 0.0, onsetFrames, nullptr, nullptr, chokeGroup, probeId});
+}
+
+bool AudioMixer::schedule(const int16_t* pcm, uint32_t samples, uint32_t soundId,
+                          float gain, Priority priority, double songMs, uint32_t onsetFrames,
+                          uint16_t chokeGroup) {
+    if (!pcm || samples == 0) return false;
+    return push({pcm, samples, soundId, gain, priority, true, songMs, onsetFrames, nullptr, nullptr, chokeGroup, 0});
+}
+
+bool AudioMixer::triggerAdpcm(const uint8_t* data, uint32_t samples, uint32_t soundId,
+                              float gain, Priority priority, uint32_t onsetFrames, uint16_t chokeGroup,
+                              uint32_t probeId) {
+    if (!data || samples == 0) return false;
+    return push({nullptr, samples, soundId, gain, priority, false, 0.0, onsetFrames, data, nullptr, chokeGroup, probeId});
+}
+
+bool AudioMixer::scheduleAdpcm(const uint8_t* data, uint32_t samples, uint32_t soundId,
+                               float gain, Priority priority, double songMs, uint32_t onsetFrames,
+                               uint16_t chokeGroup) {
+    if (!data || samples == 0) return false;
+    return push({nullptr, samples, soundId, gain, priority, true, songMs, onsetFrames, data, nullptr, chokeGroup, 0});
+}
+
+bool AudioMixer::triggerStream(StreamSource* stream, uint32_t soundId, float gain, Priority priority,
+                               uint16_t chokeGroup, uint32_t probeId) {
+    if (!stream || stream->totalSamples() == 0) return false;
+    return push({nullptr, stream->totalSamples(), soundId, gain, priority, false, 0.0, 0, nullptr, stream, chokeGroup, probeId});
+}
+
+bool AudioMixer::scheduleStream(StreamSource* stream, uint32_t soundId, float gain, Priority priority,
+                                double songMs) {
+    if (!stream || stream->totalSamples() == 0) return false;
+    return push({nullptr, stream->totalSamples(), soundId, gain, priority, true, songMs, 0, nullptr, stream, 0, 0});
+}
+
+static int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AudioMixer::setSongClock(double songMsNow) {
+    songEpochNs.store(steadyNowNs() - (int64_t)(songMsNow * 1e6), std::memory_order_relaxed);
+    songClockValid.store(true, std::memory_order_release);
+}
+
+void AudioMixer::clearSongClock() {
+    songClockValid.store(false, std::memory_order_release);
+}
+
+void AudioMixer::startOfflineClock(double songMsAtStart) {
+    offline         = true;
+    offlineStartMs  = songMsAtStart;
+    offlineFrames   = 0;
+    bufferClockInit = false;
+}
+
+bool AudioMixer::getSongTimeMs(double& outMs) const {
+    if (offline) {
+        outMs = offlineStartMs + (double)offlineFrames * 1000.0 / sampleRate;
+        return true;
+    }
+    if (!songClockValid.load(std::memory_order_acquire)) return false;
+    outMs = (double)(steadyNowNs() - songEpochNs.load(std::memory_order_relaxed)) / 1e6;
+    return true;
+}
+
+// ============================================================
+//  ボイス管理 (オーディオスレッド)
+// ============================================================
+
+void AudioMixer::startVoice(const Trigger& t, uint32_t delayFrames) {
+    // ストリームは読み位置を1つしか持たないので、同じ音の前のボイスを止めて頭から鳴らす
+    if (t.stream) {
+        for (int i = 0; i < activeCount; ) {
+            if (voices[i].stream == t.stream) removeVoice(i);
+            else i++;
+        }
+        t.stream->restart();
+    }
+    // 聞こえ始める位置 (無音を切った分を含む) まで前のボイスを鳴らしておく
+    cutVoices(t, delayFrames + t.onsetFrames);
+
+    int idx;
+    if (activeCount < MAX_VOICES) {
+        idx = activeCount++;
+    } else {
+        // ★満杯: 優先度が最も低いボイスの中で最も古いものを奪う。
+        //   旧実装の round-robin victim と違い、プレイヤーのキー音が
+        //   BGM より先に切られることはない。絞っている途中のボイスは最初に奪う。
+        idx = 0;
+        for (int i = 1; i < MAX_VOICES; i++) {
+            const Voice& a = voices[i];
+            const Voice& b = voices[idx];
+            bool aFading = a.fadeAt != NO_FADE, bFading = b.fadeAt != NO_FADE;
+            if (aFading != bFading) {
+                if (aFading) idx = i;
+                continue;
+            }
+            if (a.priority < b.priority || (a.priority == b.priority && (int32_t)(a.serial - b.serial) < 0))
+                idx = i;
+        }
+        // 新しい音の方が優先度が低いなら、既存を奪わずに捨てる
+        if (voices[idx].fadeAt == NO_FADE && voices[idx].priority > t.priority) return;
+        stats.stolenVoices++;
+    }
+
+    Voice& v   = voices[idx];
+    v.pcm      = t.pcm;
+    v.samples  = t.samples;
+    v.pos      = 0;
+    v.delay    = delayFrames + t.onsetFrames; // 複数バッファに跨る遅延も mix() が扱う
+    v.soundId  = t.soundId;
+    v.serial   = nextSerial++;
+    v.gain     = t.gain;
+    v.priority = t.priority;
+    v.adpcm    = t.adpcm;
+    v.cursor   = AdpcmCodec::Cursor();
+    v.stream   = t.stream;
+    v.choke    = t.choke;
+    v.fadeAt   = NO_FADE;
+    v.probe    = t.probe;
+}
+
+// ============================================================
+//  cutVoices — 同じ音の同時発音数の上限とチョークグループ
+//  旧実装は同じレーンを連打すると同じサンプルのボイスが際限なく重なり、
+//  密な譜面ではそれだけでボイスが埋まって奪い合いになっていた。
+//  上限を超えた分・同じグループの前のボイスは、新しいボイスが聞こえ始める
+//  位置から CHOKE_FADE_MS で絞る (ボイス自体はフェードが終わると空く)。
+// ============================================================
+
+void AudioMixer::cutVoices(const Trigger& t, uint32_t delayFrames) {
+    const int limit = polyphony.load(std::memory_order_relaxed);
+    if (limit > 0 && t.priority != PRIORITY_STREAM && !t.stream) {
+        for (;;) {
+            int count = 0, oldest = -1;
+            for (int i = 0; i < activeCount; i++) {
+                const Voice& v = voices[i];
+                if (v.soundId != t.soundId || v.fadeAt != NO_FADE || v.priority == PRIORITY_STREAM || v.stream)
+                    continue;
+                count++;
+                if (oldest < 0 || (int32_t)(v.serial - voices[oldest].serial) < 0) oldest = i;
+            }
+            if (count < limit) break; // 新しいボイスを足して limit 以内
+            fadeOut(oldest, delayFrames);
+            stats.polyCuts++;
+        }
+    }
+
+    if (t.choke == 0) return;
+    for (int i = 0; i < activeCount; ) {
+        if (voices[i].choke == t.choke && voices[i].fadeAt == NO_FADE) {
+            stats.chokeCuts++;
+            if (fadeOut(i, delayFrames)) continue; // swap で詰めたので i はそのまま
+        }
+        i++;
+    }
+}
+
+bool AudioMixer::fadeOut(int idx, uint32_t delayFrames) {
+    Voice& v = voices[idx];
+    // 新しいボイスより先に鳴り始めていない (= 一度も聞こえない) ボイスはそのまま消す
+    if (v.delay >= delayFrames) {
+        removeVoice(idx);
+        return true;
+    }
+    v.fadeAt  = v.pos + (delayFrames - v.delay) * (uint32_t)channels;
+    v.samples = std::min(v.samples, v.fadeAt + (uint32_t)fadeFrames * (uint32_t)channels);
+    return false;
+}
+
+void AudioMixer::removeVoice(int idx) {
+    voices[idx] = voices[--activeCount];
+}
+
+void AudioMixer::resetVoices() {
+    activeCount  = 0;
+    pendingCount = 0;
+    offline      = false;
+    queue.reset();
+}
+
+// ============================================================
+//  dispatchPending — キューを吸い出し、このバッファで始まるイベントを開始する
+//
+//  バッファ先頭の曲内時刻は「前回 + バッファ長」で進め、実時計との差を
+//  ゆっくり吸収する (PLL)。コールバックの呼ばれ方の揺れがそのまま
+//  発音タイミングに乗らないようにするため。
+// ============================================================
+
+void AudioMixer::dispatchPending(int frames) {
+    const double msPerFrame = 1000.0 / sampleRate;
+    const bool   clockValid = offline || songClockValid.load(std::memory_order_acquire);
+
+    if (offline) {
+        // オフライン描画: 書いたフレーム数がそのまま曲内時刻 (揺れが無いので PLL は通さない)
+        bufferStartMs   = offlineStartMs + (double)offlineFrames * msPerFrame;
+        bufferLengthMs  = frames * msPerFrame;
+        bufferClockInit = true;
+    } else if (clockValid) {
+        double measured = (double)(steadyNowNs() - songEpochNs.load(std::memory_order_relaxed)) / 1e6;
+        double expected = bufferStartMs + bufferLengthMs;
+        if (!bufferClockInit || std::abs(measured - expected) > 30.0) {
+            bufferStartMs   = measured; // 初回・シーク・大きな停止の後は即座に合わせる
+            bufferClockInit = true;
+        } else {
+            bufferStartMs = expected + (measured - expected) * 0.02;
+        }
+        bufferLengthMs = frames * msPerFrame;
+    } else {
+        bufferClockInit = false;
+    }
+    const double bufferEndMs = bufferStartMs + frames * msPerFrame;
+
+    Trigger t;
+    while (queue.pop(t)) {
+        if (!t.timed || !clockValid) {
+            startVoice(t, 0);
+        } else if (pendingCount < MAX_PENDING) {
+            pending[pendingCount++] = t;
+        } else {
+            startVoice(t, 0); // 待ち行列が溢れたら遅れてでも鳴らす
+        }
+    }
+
+    for (int i = 0; i < pendingCount; ) {
+        const Trigger& p = pending[i];
+        if (!clockValid || p.songMs < bufferEndMs) {
+            uint32_t delay = 0;
+            if (clockValid && p.songMs > bufferStartMs) {
+                delay = (uint32_t)((p.songMs - bufferStartMs) / msPerFrame);
+                if (delay >= (uint32_t)frames) delay = frames - 1;
+            } else if (clockValid && p.songMs < bufferStartMs - msPerFrame) {
+                stats.lateEvents++;
+            }
+            startVoice(p, delay);
+            stats.scheduledEvents++;
+            pending[i] = pending[--pendingCount];
+        } else {
+            i++;
+        }
+    }
+}
+
+// ============================================================
+//  trackDeviceClock — 途切れ (アンダーラン) の推定
+//  デバイスはコールバック1回分 (period) を渡されるたびに、それを実時間で鳴らす。
+//  渡した分の残り (lead) を「+period - 前回からの経過時間」で追い、0 を割ったら
+//  その間デバイスに鳴らす音が無かった = 途切れたとみなす。
+//  デバイス側のキューは 2 周期分までと見て、溜まりすぎないよう頭打ちにする
+//  (コールバックがまとめて呼ばれた直後の長い間隔を途切れと誤認しないため)。
+// ============================================================
+
+void AudioMixer::trackDeviceClock(int frames) {
+    const double periodUs = frames * 1e6 / sampleRate;
+    const int64_t now = steadyNowNs();
+    if (lastCallbackNs == 0) {
+        deviceLeadUs = periodUs;
+    } else {
+        double gapUs = (double)(now - lastCallbackNs) / 1000.0;
+        stats.maxGapUs = std::max(stats.maxGapUs, gapUs);
+        deviceLeadUs += periodUs - gapUs;
+        if (deviceLeadUs < 0.0) {
+            stats.underruns++;
+            deviceLeadUs = periodUs;
+        }
+        deviceLeadUs = std::min(deviceLeadUs, periodUs * 2.0);
+    }
+    lastCallbackNs = now;
+}
+
+// ============================================================
+//  mix — オーディオコールバック本体 (アロケーションなし)
+// ============================================================
+
+void AudioMixer::mix(int16_t* out, int frames) {
+    auto t0 = std::chrono::steady_clock::now();
+    const int64_t callbackNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t0.time_since_epoch()).count();
+    // resetStats() の要求はここで受ける。公開し終えるまで要求は下ろさない (その間の getStats() は 0 を返す)
+    const bool resetting = statsResetRequested.load(std::memory_order_acquire);
+    if (resetting) stats = Stats();
+    if (!offline) trackDeviceClock(frames); // オフライン描画にはデバイスが無い
+
+    dispatchPending(frames);
+
+    // このコールバックで混ぜるボイス数 (ベンチマーク指標の分子)
+    const int voicesMixed = activeCount;
+    int adpcmMixed = 0;
+    for (int i = 0; i < activeCount; i++) adpcmMixed += voices[i].adpcm != nullptr;
+
+    const bool simd = !forceScalar;
+    int total   = frames * channels;
+    int done    = 0;
+
+    while (done < total) {
+        int block = std::min(total - done, MAX_BLOCK_SAMPLES);
+        std::memset(accum, 0, sizeof(float) * block);
+
+        for (int i = 0; i < activeCount; ) {
+            Voice& v = voices[i];
+            // 開始オフセット: このブロック内で鳴り始める位置まで飛ばす
+            int offset = 0;
+            if (v.delay > 0) {
+                uint32_t delaySamples = v.delay * (uint32_t)channels;
+                if (delaySamples >= (uint32_t)block) {
+                    v.delay -= (uint32_t)(block / channels);
+                    i++;
+                    continue;
+                }
+                offset  = (int)delaySamples;
+                v.delay = 0;
+            }
+            int n = (int)std::min<uint32_t>((uint32_t)(block - offset), v.samples - v.pos);
+            if (v.probe) {
+                // 打鍵の遅延計測: このコールバックで初めて音になった
+                if (latencyProbe) latencyProbe->markMix(v.probe, callbackNs);
+                v.probe = 0;
+            }
+            // ★ADPCM・ストリームのボイスは pcm が nullptr。nullptr + pos は未定義動作なので、
+            //   元の種類で分けてから位置を足す
+            const int16_t* src;
+            if (v.adpcm) {
+                // 圧縮ボイス: このブロックで使う分だけ展開してから同じカーネルで積算する
+                AdpcmCodec::decode(v.adpcm, channels, v.cursor, voiceScratch, (uint32_t)(n / channels));
+                src = voiceScratch;
+            } else if (v.stream) {
+                v.stream->read(v.pos, voiceScratch, (uint32_t)n);
+                src = voiceScratch;
+            } else {
+                src = v.pcm + v.pos;
+            }
+            // 止めるボイスは fadeAt までそのまま、そこから先は絞りながら
+            int flat = n;
+            if (v.fadeAt != NO_FADE) flat = (int)std::min<uint32_t>((uint32_t)n, v.fadeAt > v.pos ? v.fadeAt - v.pos : 0);
+            if (simd) accumulateSimd(accum + offset, src, flat, v.gain);
+            else      accumulateScalar(accum + offset, src, flat, v.gain);
+            if (flat < n) {
+                uint32_t into = (v.pos + (uint32_t)flat - v.fadeAt) / (uint32_t)channels; // フェード開始からのフレーム数
+                float    step = v.gain / (float)fadeFrames;
+                accumulateRamp(accum + offset + flat, src + flat, n - flat,
+                               std::max(0.0f, v.gain - step * (float)into), step, channels);
+            }
+            v.pos += n;
+            if (v.pos >= v.samples) removeVoice(i); // swap で詰めるので i は進めない
+            else i++;
+        }
+
+        if (simd) storeSimd(out + done, accum, block);
+        else      storeScalar(out + done, accum, block);
+        done += block;
+    }
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    stats.activeVoices   = (uint32_t)activeCount;
+    stats.peakVoices     = std::max(stats.peakVoices, (uint32_t)activeCount);
+    stats.lastCallbackUs = us;
+    stats.peakCallbackUs = std::max(stats.peakCallbackUs, us);
+    stats.droppedTriggers = droppedTriggers.load(std::memory_order_relaxed);
+    stats.callbacks++;
+    if (offline) offlineFrames += (uint64_t)frames;
+    stats.sumVoices     += voicesMixed;
+    stats.sumCallbackUs += us;
+    stats.sumAdpcmVoices += adpcmMixed;
+    if (voicesMixed > 0 && us > 0.0) {
+        double rate = (double)voicesMixed / (us / 1000.0);
+        stats.voicesPerMs += (rate - stats.voicesPerMs) * 0.05;
+    }
+    publishStats();
+    if (resetting) statsResetRequested.store(false, std::memory_order_release);
+}
+
+void AudioMixer::publishStats() {
+    statsBuf[statsBack] = stats;
+    statsBack = statsShared.exchange(statsBack | STATS_FRESH, std::memory_order_acq_rel) & ~STATS_FRESH;
+}
+
+AudioMixer::Stats AudioMixer::getStats() const {
+    if (statsResetRequested.load(std::memory_order_acquire)) return Stats();
+    if (statsShared.load(std::memory_order_relaxed) & STATS_FRESH)
+        statsFront = statsShared.exchange(statsFront, std::memory_order_acq_rel) & ~STATS_FRESH;
+    return statsBuf[statsFront];
+}
@@ -0,0 +1,261 @@
+#ifndef AUDIOMIXER_HPP
+#define AUDIOMIXER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <algorithm>
+#include "SpscQueue.hpp"
+#include "AdpcmCodec.hpp"
+#include "LatencyProbe.hpp"
+
+// ============================================================
+//  AudioMixer — キー音専用ソフトウェアミキサー
+//
+//  【旧実装の問題点】
+//    SDL_mixer の 256 チャンネルにキー音を1音ずつ Mix_PlayChannel していた。
+//    チャンネルが埋まると round-robin の "victim" を Mix_HaltChannel で止め、
+//    トリガーのたびに Mix_Volume を呼んでいた。BGM の密な譜面ではプールが
+//    すぐ飽和し、鳴らしたい音ではなく「たまたま順番が来た音」が切られていた。
+//
+//  【構成】
+//    - ボイスはフラット配列 voices[0, activeCount) に詰めて持つ (終了時は末尾と swap)
+//    - メインスレッド → オーディオスレッドは SpscQueue で Trigger を渡す (ロックなし)
+//    - 満杯時は「優先度が低い → 古い」順にボイスを奪う
+//    - int16 → float の積算と float → int16 の飽和変換は NEON / SSE2 カーネル
+//    - mix() 内でのヒープ確保はゼロ (積算バッファはメンバの固定長配列)
+//    - ADPCM で持つ音 (AdpcmCodec) はボイスが鳴らしながらブロックごとに展開する
+//    - ディスクから流す長い音 (StreamSource) は1本につき1ボイス。再発音で前のボイスを止める
+//    - 同じ音の同時発音数の上限 (setPolyphony) とチョークグループ (レーンごと) を超えた
+//      古いボイスは CHOKE_FADE_MS で絞って止める (プチッと切らない)
+//
+//  【サンプル精度スケジューリング】
+//    BGM キー音はフレーム単位 (0〜16ms のジッター) ではなく、曲内時刻 (ms) 付きで
+//    先行してキューに積む。コールバックは「このバッファが曲内の何 ms に当たるか」を
+//    ソングクロックから求め、該当するイベントをバッファ内の正確なサンプル位置から
+//    鳴らし始める。プレイヤーの打鍵音は同じ経路を「即時 (ASAP)」で通る。
+//
+//  SDL に依存しないため、オフラインベンチマーク (tools/) からもそのまま使える。
+//  PCM はデバイスと同じチャンネル数のインターリーブ int16 を前提とする。
+// ============================================================
+class AudioMixer {
+public:
+    static constexpr int MAX_VOICES        = 256;
+    static constexpr int MAX_BLOCK_SAMPLES = 2048; // 1回の積算で扱うサンプル数 (frames × channels)
+    static constexpr int QUEUE_CAPACITY    = 1024;
+    static constexpr int MAX_PENDING       = 1024; // 発音待ちのスケジュール済みイベント
+    static constexpr int CHOKE_FADE_MS     = 8;    // 同時発音数・チョークで止めるボイスのフェード
+
+    enum Priority : uint8_t {
+        PRIORITY_BGM    = 0,
+        PRIORITY_PLAYER = 1,
+        PRIORITY_STREAM = 2, // 事前ミックス済み BGM トラックなど、奪われてはならない長尺ボイス
+    };
+
+    // 【追加】ボイスが鳴らしながら中身を取りに行く音源 (実装は SoundStream)。
+    //         ミキサーはディスクの読み方を知らなくてよいよう、この3つだけを使う
+    class StreamSource {
+    public:
+        virtual ~StreamSource() = default;
+        virtual uint32_t totalSamples() const = 0;
+        // 頭から鳴らし直す (ボイスの開始時。オーディオスレッド)
+        virtual void restart() = 0;
+        // 発音開始からのサンプル位置 pos から n サンプルを dst へ (オーディオスレッド)
+        virtual void read(uint32_t pos, int16_t* dst, uint32_t n) = 0;
+    };
+
+    struct Stats {
+        uint32_t activeVoices  = 0;   // 直近コールバック終了時のボイス数
+        uint32_t peakVoices    = 0;
+        uint64_t stolenVoices  = 0;   // 満杯時に奪ったボイスの累計
+        uint64_t droppedTriggers = 0; // キュー満杯で捨てたトリガーの累計
+        double   lastCallbackUs = 0.0;
+        double   peakCallbackUs = 0.0;
+        double   voicesPerMs    = 0.0; // ボイス処理効率 (EMA): 1ms のコールバック時間で何ボイス混ぜられるか
+        uint64_t scheduledEvents = 0;  // 時刻指定で開始したボイスの累計
+        uint64_t lateEvents      = 0;  // 時刻を過ぎてから届いた (= バッファ先頭で鳴らした) イベント
+        uint64_t callbacks       = 0;
+        double   sumVoices       = 0.0; // 平均ボイス数 = sumVoices / callbacks
+        double   sumCallbackUs   = 0.0; // 平均コールバック時間 = sumCallbackUs / callbacks
+        double   sumAdpcmVoices  = 0.0; // うち ADPCM をデコードしながら鳴らしたボイス
+        uint64_t polyCuts        = 0;   // 同じ音の同時発音数の上限で止めたボイスの累計
+        uint64_t chokeCuts       = 0;   // チョークグループで止めたボイスの累計
+        // 【追加】デバイス側の途切れの推定: コールバックの間隔が、それまでに渡した音の長さを
+        //         使い切るほど開いた回数 (mix() が実時間で呼ばれている時だけ意味がある)
+        uint64_t underruns       = 0;
+        double   maxGapUs        = 0.0; // コールバック間隔の最大
+
+        double avgVoices()     const { return callbacks ? sumVoices / callbacks : 0.0; }
+        double avgAdpcmVoices() const { return callbacks ? sumAdpcmVoices / callbacks : 0.0; }
+        double avgCallbackUs() const { return callbacks ? sumCallbackUs / callbacks : 0.0; }
+    };
+
+    void configure(int sampleRate, int channels);
+    int  getSampleRate() const { return sampleRate; }
+    int  getChannels()   const { return channels; }
+
+    // --- メインスレッド側 ---
+    // pcm はボイスが鳴り終わる (または stopAll される) まで有効でなければならない
+    // 即時 (次のコールバックのバッファ先頭) に鳴らす
+    // onsetFrames: 先頭の無音を切り落としたキー音は、その分だけ遅らせて鳴らす
+    // chokeGroup : 0 以外なら、同じグループで鳴っている前のボイスを絞って止める (プレイヤーのレーン)
+    // probeId    : 0 以外なら、このボイスを初めて混ぜた時刻を LatencyProbe に記録する
+    bool trigger(const int16_t* pcm, uint32_t samples, uint32_t soundId,
+                 float gain, Priority priority, uint32_t onsetFrames = 0, uint16_t chokeGroup = 0,
+                 uint32_t probeId = 0);
+    // 曲内時刻 songMs ちょうどのサンプルから鳴らす (ソングクロック未設定時は即時)
+    bool schedule(const int16_t* pcm, uint32_t samples, uint32_t soundId,
+                  float gain, Priority priority, double songMs, uint32_t onsetFrames = 0,
+                  uint16_t chokeGroup = 0);
+    // 【追加】AdpcmCodec で圧縮した音。samples は展開後のサンプル数。
+    //         ボイスが鳴らしながら自分の分だけデコードする
+    bool triggerAdpcm(const uint8_t* data, uint32_t samples, uint32_t soundId,
+                      float gain, Priority priority, uint32_t onsetFrames = 0, uint16_t chokeGroup = 0,
+                      uint32_t probeId = 0);
+    bool scheduleAdpcm(const uint8_t* data, uint32_t samples, uint32_t soundId,
+                       float gain, Priority priority, double songMs, uint32_t onsetFrames = 0,
+                       uint16_t chokeGroup = 0);
+    // 【追加】ディスクから流す音。stream はボイスが鳴り終わる (または stopAll される) まで有効なこと
+    bool triggerStream(StreamSource* stream, uint32_t soundId, float gain, Priority priority,
+                       uint16_t chokeGroup = 0, uint32_t probeId = 0);
+    bool scheduleStream(StreamSource* stream, uint32_t soundId, float gain, Priority priority, double songMs);
+
+    // 【追加】同じ soundId を同時に鳴らせる数 (0 = 無制限)。超えた分は古いボイスから止める。
+    //         事前ミックス済みトラック (PRIORITY_STREAM) は数えない
+    void setPolyphony(int maxPerSound) { polyphony.store(std::max(0, maxPerSound), std::memory_order_relaxed); }
+    // 【追加】打鍵の遅延計測 (probeId 付きのボイスの MIX 段階を書く)。オーディオを止めている間に設定すること
+    void setLatencyProbe(LatencyProbe* probe) { latencyProbe = probe; }
+
+    // ソングクロック: 「今この瞬間が曲内の songMsNow」であることをミキサーに教える。
+    // ゲームループの cur_ms と同じ時計で渡すこと。
+    void setSongClock(double songMsNow);
+    void clearSongClock();
+    // 今この瞬間の曲内時刻。ソングクロック未設定なら false (どのスレッドからでも呼べる)
+    bool getSongTimeMs(double& outMs) const;
+
+    // 【追加】オフライン描画用のソングクロック: 実時間ではなく mix() で書いたフレーム数で進む。
+    //         最初の mix() のバッファ先頭が曲内 songMsAtStart になる (PLL もアンダーランの推定もしない)。
+    //         オーディオスレッドが動いていない時だけ呼ぶこと (ChartRenderer 参照)
+    void startOfflineClock(double songMsAtStart);
+    bool isOfflineClock() const { return offline; }
+
+    // --- オーディオスレッド側 (または呼び出し側がオーディオを止めている間) ---
+    // out を frames 分上書きする
+    void mix(int16_t* out, int frames);
+    // 全ボイスとキューを破棄する。オーディオスレッドが止まっている時だけ呼ぶこと
+    void resetVoices();
+    // コールバックを意図的に止めていた後に呼ぶ (その間隔を途切れとして数えない)
+    void markDiscontinuity() { lastCallbackNs = 0; }
+
+    // ★修正: 統計はオーディオスレッドが書き、メインスレッド (HUD は毎フレーム) が読む。
+    //   コールバックは自分専用の stats を更新し、mix() の最後にトリプルバッファで公開する。
+    //   getStats() は最後に公開された値のコピーを返す (読むのは1スレッドだけにすること)。
+    //   resetStats() は要求を立てるだけで、次の mix() の先頭でオーディオスレッドが 0 に戻す
+    Stats getStats() const;
+    void resetStats() { statsResetRequested.store(true, std::memory_order_release); }
+
+    // 積算カーネル (BGM の事前ミックスなどミキサー外からも使う)
+    //   accumulate: dst[i] += src[i] * gain / store: out[i] = 飽和(src[i])
+    static void accumulate(float* dst, const int16_t* src, int n, float gain);
+    static void store(int16_t* out, const float* src, int n);
+
+    // ベンチマーク用: SIMD カーネルを無効化してスカラー経路を使う
+    void setForceScalar(bool v) { forceScalar = v; }
+    static const char* kernelName();
+
+private:
+    struct Trigger {
+        const int16_t* pcm;
+        uint32_t       samples;
+        uint32_t       soundId;
+        float          gain;
+        Priority       priority;
+        bool           timed;   // false = ASAP
+        double         songMs;
+        uint32_t       onsetFrames;
+        const uint8_t* adpcm;   // nullptr 以外なら pcm の代わりにこちらを鳴らす
+        StreamSource*  stream;  // 同上
+        uint16_t       choke;
+        uint32_t       probe;   // LatencyProbe の打鍵 id (0 = 計測しない)
+    };
+
+    struct Voice {
+        const int16_t* pcm      = nullptr;
+        uint32_t       samples  = 0;  // インターリーブ後の総サンプル数
+        uint32_t       pos      = 0;
+        uint32_t       delay    = 0;  // 鳴り始めるまでの無音フレーム数 (バッファ内オフセット)
+        uint32_t       soundId  = 0;
+        uint32_t       serial   = 0;  // 発音順 (小さいほど古い)
+        float          gain     = 1.0f;
+        Priority       priority = PRIORITY_BGM;
+        const uint8_t*     adpcm = nullptr;
+        AdpcmCodec::Cursor cursor;
+        StreamSource*      stream = nullptr;
+        uint16_t choke  = 0;
+        uint32_t fadeAt = NO_FADE; // このサンプル位置から CHOKE_FADE_MS で絞って止める
+        uint32_t probe  = 0;       // 初めて混ぜたら LatencyProbe に書いて 0 に戻す
+    };
+    static constexpr uint32_t NO_FADE = UINT32_MAX;
+
+    bool push(const Trigger& t);
+    void startVoice(const Trigger& t, uint32_t delayFrames);
+    // 新しいボイス (delayFrames 後に鳴り始める) の上限・チョークに掛かる前のボイスを絞る
+    void cutVoices(const Trigger& t, uint32_t delayFrames);
+    // voices[idx] を、新しいボイスが鳴り始める delayFrames 後から絞って止める。消したら true
+    bool fadeOut(int idx, uint32_t delayFrames);
+    void removeVoice(int idx);
+    void dispatchPending(int frames);
+    void trackDeviceClock(int frames);
+
+    int sampleRate = 22050;
+    int channels   = 1;
+
+    Voice    voices[MAX_VOICES];
+    int      activeCount = 0;
+    uint32_t nextSerial  = 0;
+    std::atomic<int> polyphony{0};
+    int      fadeFrames  = 176;           // CHOKE_FADE_MS 分 (configure で決める)
+    LatencyProbe* latencyProbe = nullptr;
+
+    SpscQueue<Trigger, QUEUE_CAPACITY> queue;
+    std::atomic<uint64_t> droppedTriggers{0};
+
+    // スケジュール済みで、まだ開始時刻が来ていないイベント (オーディオスレッド専用)
+    Trigger pending[MAX_PENDING];
+    int     pendingCount = 0;
+
+    // ソングクロック: steady_clock (ns) 上で曲内 0ms に当たる時刻
+    std::atomic<int64_t> songEpochNs{0};
+    std::atomic<bool>    songClockValid{false};
+    // コールバック側で平滑化したバッファ先頭の曲内時刻 (PLL)
+    double bufferStartMs   = 0.0;
+    double bufferLengthMs  = 0.0;
+    bool   bufferClockInit = false;
+
+    // オフライン描画 (startOfflineClock)。resetVoices (configure) で解除
+    bool     offline       = false;
+    double   offlineStartMs = 0.0;
+    uint64_t offlineFrames = 0;
+
+    // 途切れの推定 (オーディオスレッド専用)
+    int64_t lastCallbackNs = 0;
+    double  deviceLeadUs   = 0.0; // デバイスに渡してまだ鳴っていない分の見積もり
+
+    alignas(16) float   accum[MAX_BLOCK_SAMPLES];
+    alignas(16) int16_t voiceScratch[MAX_BLOCK_SAMPLES]; // ADPCM・ストリームのボイスの展開先 (1ボイス分ずつ使い回す)
+
+    bool  forceScalar = false;
+    Stats stats; // オーディオスレッド専用 (公開は publishStats)
+
+    // 統計の受け渡し (トリプルバッファ)。書き手は statsBack に書いて statsShared と交換し、
+    // 読み手は STATS_FRESH が立っていれば statsFront と交換する
+    static constexpr uint32_t STATS_FRESH = 4;
+    Stats statsBuf[3];
+    uint32_t statsBack = 0;                       // オーディオスレッド
+    mutable std::atomic<uint32_t> statsShared{1}; // バッファ番号 | STATS_FRESH
+    mutable uint32_t statsFront = 2;              // 読み手
+    std::atomic<bool> statsResetRequested{false};
+    void publishStats();
+};
+
+#endif // AUDIOMIXER_HPP
@@ -5,7 +5,12 @@
 #include <string>
 #include <cstdint>
 #include <unordered_map>
-#include "BgaManager.hpp"
+
+// BGA のイベント (BgaManager と共有。譜面データは SDL に依存させない)
+struct BgaEvent {
+    long long y;
+    int id;
+};
 
 struct BMSNote {
     int64_t x, y, l;
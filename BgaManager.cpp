@@ -1,50 +1,154 @@
 #include "BgaManager.hpp"
 #include "Config.hpp"
+#include "Nv12Converter.hpp"
 #include <SDL2/SDL_image.h>
 #include <cstring>
+#include <cmath>
 #include <algorithm>
 #include <cstdio>
-
-static const long long BMP_LOOK_AHEAD = 300000;
+#include <chrono>
 
 // ============================================================
-//  init / loadBmp / preLoad
+//  init / preLoad — 画像は時刻 (ms) で先読みし、ワーカーでデコードする
 // ============================================================
 
 void BgaManager::init(size_t expectedSize) {
-    clear();
+    clearImages(); // 動画は開いたまま (リトライで同じ動画なら restartVideo で使い回す)
     textures.reserve(std::min((size_t)256, expectedSize));
+    startImageWorker();
 }
 
-void BgaManager::loadBmp(int id, const std::string& fullPath, SDL_Renderer* renderer) {
-    if (textures.count(id)) return;
-    SDL_Surface* surf = IMG_Load(fullPath.c_str());
-    if (!surf) return;
-
-    BgaTextureEntry entry;
-    entry.w   = surf->w;
-    entry.h   = surf->h;
-    entry.tex = SDL_CreateTextureFromSurface(renderer, surf);
-    SDL_FreeSurface(surf);
-    if (entry.tex) textures[id] = entry;
+void BgaManager::setEventTimes(const std::function<double(long long)>& msFromY) {
+    // ★パス表はワーカーが読むので、止めてから作り直す (譜面の読み込み時に1回だけ)
+    const bool running = imageThread.joinable();
+    stopImageWorker();
+
+    imagePaths.clear();
+    std::unordered_map<int, uint32_t> pathIndex;
+    auto pathOf = [&](int id) -> uint32_t {
+        auto found = pathIndex.find(id);
+        if (found != pathIndex.end()) return found->second;
+        uint32_t index = NO_PATH;
+        auto it = idToFilename.find(id);
+        if (it != idToFilename.end()) {
+            index = (uint32_t)imagePaths.size();
+            imagePaths.push_back(baseDir + it->second);
+        }
+        pathIndex.emplace(id, index);
+        return index;
+    };
+
+    imageCues.clear();
+    imageCues.reserve(bgaEvents.size() + layerEvents.size() + poorEvents.size());
+    for (const auto* events : {&bgaEvents, &layerEvents, &poorEvents})
+        for (const auto& ev : *events) imageCues.push_back({msFromY(ev.y), ev.id, pathOf(ev.id)});
+    // 同時刻はベース → レイヤー → ミスの順のまま
+    std::stable_sort(imageCues.begin(), imageCues.end(),
+                     [](const ImageCue& a, const ImageCue& b) { return a.ms < b.ms; });
+    imageCueIndex = 0;
+
+    if (running) startImageWorker();
 }
 
-void BgaManager::preLoad(long long startPulse, SDL_Renderer* renderer) {
+void BgaManager::preLoad(double curMs, SDL_Renderer* renderer) {
     if (isVideoMode) return;
-    int nextNeededId = -1;
-    auto scan = [&](const std::vector<BgaEvent>& events) {
-        for (const auto& ev : events) {
-            if (ev.y > startPulse + BMP_LOOK_AHEAD) break;
-            if (textures.find(ev.id) == textures.end()) {
-                nextNeededId = ev.id;
-                return true;
+
+    // 先読み範囲に入ったキューを、まだ要求していない画像だけワーカーへ (時刻順)
+    const double horizon = curMs + std::max(0, Config::BGA_IMAGE_LOOKAHEAD_MS);
+    const uint32_t gen   = imageGen.load(std::memory_order_relaxed);
+    while (imageCueIndex < imageCues.size() && imageCues[imageCueIndex].ms <= horizon) {
+        const ImageCue& cue = imageCues[imageCueIndex];
+        if (cue.path != NO_PATH && !textures.count(cue.id) && !requestedIds.count(cue.id)) {
+            if (!imageRequests.push({cue.id, gen, cue.path})) break; // 満杯: 次のフレームで続き
+            requestedIds.insert(cue.id);
+        }
+        imageCueIndex++;
+    }
+
+    uploadImages(renderer);
+}
+
+// デコード済みの画像をテクスチャにする。予算を超えたら次のフレームへ (最低1枚は進める)
+void BgaManager::uploadImages(SDL_Renderer* renderer) {
+    const auto   t0       = std::chrono::steady_clock::now();
+    const double budgetUs = std::max(0, Config::BGA_UPLOAD_BUDGET_US);
+    const uint32_t gen    = imageGen.load(std::memory_order_relaxed);
+    int uploaded = 0;
+
+    ImageResult res;
+    while (imageResults.pop(res)) {
+        if (res.surf) {
+            if (res.gen == gen && !textures.count(res.id)) {
+                BgaTextureEntry entry;
+                entry.w   = res.surf->w;
+                entry.h   = res.surf->h;
+                entry.tex = SDL_CreateTextureFromSurface(renderer, res.surf);
+                if (entry.tex) textures[res.id] = entry;
+                uploaded++;
             }
+            SDL_FreeSurface(res.surf);
         }
-        return false;
-    };
-    if (!scan(bgaEvents)) { if (!scan(layerEvents)) scan(poorEvents); }
-    if (nextNeededId != -1 && idToFilename.count(nextNeededId))
-        loadBmp(nextNeededId, baseDir + idToFilename[nextNeededId], renderer);
+        if (uploaded > 0 &&
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() >= budgetUs)
+            break;
+    }
+}
+
+// ============================================================
+//  imageWorker — IMG_Load と形式変換だけを行う (テクスチャはメインスレッド)
+// ============================================================
+
+void BgaManager::startImageWorker() {
+    if (imageThread.joinable()) return;
+    imageQuit.store(false, std::memory_order_relaxed);
+    imageThread = std::thread(&BgaManager::imageWorker, this);
+}
+
+void BgaManager::stopImageWorker() {
+    imageQuit.store(true, std::memory_order_release);
+    if (imageThread.joinable()) imageThread.join();
+    // 両側が止まったので、残った要求・結果を捨てる
+    ImageRequest req;
+    while (imageRequests.pop(req)) {}
+    ImageResult res;
+    while (imageResults.pop(res)) if (res.surf) SDL_FreeSurface(res.surf);
+}
+
+void BgaManager::imageWorker() {
+    ImageRequest req;
+    while (!imageQuit.load(std::memory_order_acquire)) {
+        if (!imageRequests.pop(req)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            continue;
+        }
+        if (req.gen != imageGen.load(std::memory_order_acquire)) continue; // 前の譜面の要求
+
+        ImageResult res;
+        res.id  = req.id;
+        res.gen = req.gen;
+        if (SDL_Surface* surf = IMG_Load(imagePaths[req.path].c_str())) {
+            // レンダラがそのまま受け取れる形式にしておく (メインスレッドでの変換を避ける)
+            Uint32 fmt = surf->format->Amask ? SDL_PIXELFORMAT_ARGB8888 : SDL_PIXELFORMAT_RGB888;
+            if (surf->format->format != fmt) {
+                if (SDL_Surface* conv = SDL_ConvertSurfaceFormat(surf, fmt, 0)) {
+                    SDL_FreeSurface(surf);
+                    surf = conv;
+                }
+            }
+            res.surf = surf;
+        }
+
+        // 結果キューが空くまで待つ (デコード済みで溜めておく枚数の上限)
+        while (!imageResults.push(res)) {
+            if (imageQuit.load(std::memory_order_acquire) ||
+                res.gen != imageGen.load(std::memory_order_acquire)) {
+                if (res.surf) SDL_FreeSurface(res.surf);
+                res.surf = nullptr;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+    }
 }
 
 // ============================================================
@@ -55,7 +159,7 @@ bool BgaManager::loadBgaFile(const std::string& path, SDL_Renderer* renderer) {
     std::string targetPath = path;
     if (targetPath.compare(0, 5, "sdmc:") == 0) targetPath.erase(0, 5);
 
-    if (isVideoMode) clear();
+    if (isVideoMode) closeVideo();
 
     // --- フォーマットを開く (フォールバックパス付き) ---
     int err = avformat_open_input(&pFormatCtx, targetPath.c_str(), NULL, NULL);
@@ -91,45 +195,23 @@ bool BgaManager::loadBgaFile(const std::string& path, SDL_Renderer* renderer) {
     int vH = pCodecPar->height;
 
     // --- 動画制約チェック ---
-    // Switch の CPU/メモリ帯域を守るため、縦 256px・30fps を超える動画は拒否する。
-    // BGA は装飾なので品質より安定動作を優先する。
+    // ★修正: 縦 256px・30fps の上限は撤廃。重い動画は videoWorker の適応デコードで画質を落とす。
+    //    メモリに載せたくない大きさの動画だけ拒否する。
     AVRational avgFps = pFormatCtx->streams[videoStreamIdx]->avg_frame_rate;
     double fps = (avgFps.den > 0) ? (double)avgFps.num / avgFps.den : 30.0;
+    if (fps <= 0.0 || fps > 240.0) fps = 30.0; // 壊れたヘッダ
 
-    if (vH > MAX_VIDEO_HEIGHT) {
-        fprintf(stderr, "BGA: rejected — height %d > %d limit\n", vH, MAX_VIDEO_HEIGHT);
-        avformat_close_input(&pFormatCtx); pFormatCtx = nullptr;
-        return false;
-    }
-    if (fps > (double)MAX_VIDEO_FPS + 0.5) {
-        fprintf(stderr, "BGA: rejected — fps %.1f > %d limit\n", fps, MAX_VIDEO_FPS);
+    if (vH > Config::BGA_VIDEO_MAX_HEIGHT) {
+        fprintf(stderr, "BGA: rejected — height %d > %d limit\n", vH, Config::BGA_VIDEO_MAX_HEIGHT);
         avformat_close_input(&pFormatCtx); pFormatCtx = nullptr;
         return false;
     }
     videoFps = fps;
 
     // --- コーデック初期化 ---
-    const AVCodec* pCodec = avcodec_find_decoder(pCodecPar->codec_id);
-    if (!pCodec) {
-        avformat_close_input(&pFormatCtx); pFormatCtx = nullptr;
-        return false;
-    }
-
-    pCodecCtx = avcodec_alloc_context3(pCodec);
-    avcodec_parameters_to_context(pCodecCtx, pCodecPar);
-
-    // ★ thread_count = 1: FFmpeg 内部スレッドを立てない。
-    //    videoWorker スレッドをコア2に固定するため、FFmpeg が追加スレッドを
-    //    立てると別コアに侵入してゲームスレッドに干渉する。
-    pCodecCtx->thread_count    = 1;
-    pCodecCtx->flags2         |= AV_CODEC_FLAG2_FAST;
-    pCodecCtx->workaround_bugs = 1;
-    // ループフィルタをスキップ: BGA は装飾なので多少ブロックノイズが出ても許容
-    // デコード時間を ~15% 削減できる
-    pCodecCtx->skip_loop_filter = AVDISCARD_NONREF;
-
-    if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
-        avcodec_free_context(&pCodecCtx); pCodecCtx = nullptr;
+    decodeLevel  = 0;
+    decodeLowres = 0;
+    if (!openDecoder(0)) {
         avformat_close_input(&pFormatCtx); pFormatCtx = nullptr;
         return false;
     }
@@ -150,14 +232,19 @@ bool BgaManager::loadBgaFile(const std::string& path, SDL_Renderer* renderer) {
     }
 
     // ★ SPSC スロット事前確保
-    // NV12 = Y(w×h) + UV(w×h/2) = w×h×3/2 バイト、ストライド = width (タイトパッキング)
-    size_t slotBytes = (size_t)videoTexW * videoTexH * 3 / 2;
+    // ★修正: 画素のバッファは持たない。デコーダのフレームを参照する AVFrame の殻だけ
     for (int i = 0; i < NUM_SLOTS; i++) {
-        slots[i].data.assign(slotBytes, 0);
+        if (!slots[i].frame) slots[i].frame = av_frame_alloc();
         slots[i].pts = -1.0;
+        slots[i].gen = 0;
     }
     qHead.store(0, std::memory_order_relaxed);
     qTail.store(0, std::memory_order_relaxed);
+    videoGen.store(0, std::memory_order_relaxed);
+    seekTargetSec.store(0.0, std::memory_order_relaxed);
+    videoLoop.store(Config::BGA_VIDEO_LOOP, std::memory_order_relaxed);
+    loopLengthSec = 0.0;
+    videoPath     = path;
 
     quitThread.store(false, std::memory_order_relaxed);
     isVideoMode = true;
@@ -168,6 +255,110 @@ bool BgaManager::loadBgaFile(const std::string& path, SDL_Renderer* renderer) {
     return true;
 }
 
+// ============================================================
+//  openDecoder / applyDecodeLevel — 適応デコード
+// ============================================================
+
+namespace {
+struct DecodeLevelDef {
+    AVDiscard loopFilter;
+    AVDiscard idct;
+    AVDiscard frame;
+    int       lowres;
+};
+// BgaManager.hpp の【追加】適応デコードの表と同じ並び
+const DecodeLevelDef DECODE_LEVEL_DEFS[BgaManager::DECODE_LEVELS] = {
+    {AVDISCARD_NONREF, AVDISCARD_DEFAULT, AVDISCARD_DEFAULT, 0},
+    {AVDISCARD_ALL,    AVDISCARD_NONREF,  AVDISCARD_DEFAULT, 0},
+    {AVDISCARD_ALL,    AVDISCARD_BIDIR,   AVDISCARD_NONREF,  0},
+    {AVDISCARD_ALL,    AVDISCARD_BIDIR,   AVDISCARD_NONREF,  1},
+    {AVDISCARD_ALL,    AVDISCARD_BIDIR,   AVDISCARD_NONREF,  2},
+    {AVDISCARD_ALL,    AVDISCARD_BIDIR,   AVDISCARD_NONKEY,  2},
+};
+}
+
+bool BgaManager::openDecoder(int lowres) {
+    const AVCodecParameters* par = pFormatCtx->streams[videoStreamIdx]->codecpar;
+    const AVCodec* codec = avcodec_find_decoder(par->codec_id);
+    if (!codec) return false;
+    if (pCodecCtx) avcodec_free_context(&pCodecCtx);
+
+    pCodecCtx = avcodec_alloc_context3(codec);
+    if (!pCodecCtx) return false;
+    avcodec_parameters_to_context(pCodecCtx, par);
+
+    // ★修正: スレッド数は Config::BGA_DECODE_THREADS (0 = 自動)。
+    //    Switch の既定は 1: videoWorker スレッドをコア2に固定しているため、FFmpeg が
+    //    追加スレッドを立てると別コアに侵入してゲームスレッドに干渉する。
+    pCodecCtx->thread_count    = std::max(0, Config::BGA_DECODE_THREADS);
+    pCodecCtx->flags2         |= AV_CODEC_FLAG2_FAST;
+    pCodecCtx->workaround_bugs = 1;
+    pCodecCtx->lowres          = std::min(lowres, (int)codec->max_lowres);
+    decodeLowres = pCodecCtx->lowres;
+    applyDecodeLevel(decodeLevel);
+
+    if (avcodec_open2(pCodecCtx, codec, NULL) < 0) {
+        avcodec_free_context(&pCodecCtx); pCodecCtx = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void BgaManager::applyDecodeLevel(int level) {
+    // skip_* はデコード中に書き換えてよい (フレーム / スライスごとに読まれる)
+    const DecodeLevelDef& d = DECODE_LEVEL_DEFS[std::clamp(level, 0, DECODE_LEVELS - 1)];
+    pCodecCtx->skip_loop_filter = d.loopFilter;
+    pCodecCtx->skip_idct        = d.idct;
+    pCodecCtx->skip_frame       = d.frame;
+}
+
+int BgaManager::levelLowres(int level) const {
+    const int maxLowres = pCodecCtx ? (int)pCodecCtx->codec->max_lowres : 0;
+    return std::min(DECODE_LEVEL_DEFS[std::clamp(level, 0, DECODE_LEVELS - 1)].lowres, maxLowres);
+}
+
+// ============================================================
+//  restartVideo / seekWorker — 開き直さない巻き戻し
+// ============================================================
+
+void BgaManager::restartVideo(double sec) {
+    if (!isVideoMode) return;
+    // 目標を書いてから世代を進める (ワーカーは世代の変化を見てから目標を読む)
+    seekTargetSec.store(sec, std::memory_order_relaxed);
+    videoGen.fetch_add(1, std::memory_order_release);
+    isReady.store(false, std::memory_order_release); // 新しい世代の最初のフレームまで前の絵は出さない
+}
+
+double BgaManager::knownDurationSec() const {
+    if (loopLengthSec > 0.0) return loopLengthSec;
+    const AVStream* st = pFormatCtx->streams[videoStreamIdx];
+    if (st->duration != AV_NOPTS_VALUE && st->duration > 0) return st->duration * av_q2d(st->time_base);
+    if (pFormatCtx->duration != AV_NOPTS_VALUE && pFormatCtx->duration > 0) return (double)pFormatCtx->duration / AV_TIME_BASE;
+    return 0.0; // 分からなければ折り返さない (1周目の EOF で分かる)
+}
+
+void BgaManager::seekWorker(double sec, double& loopBase, double& dropBefore) {
+    const AVStream* st = pFormatCtx->streams[videoStreamIdx];
+    double pos = std::max(0.0, sec); // 曲の開始前 (負の時刻) は先頭で待つ
+    loopBase   = 0.0;
+    const double dur = knownDurationSec();
+    if (videoLoop.load(std::memory_order_relaxed) && dur > 0.0 && pos >= dur) {
+        loopBase = std::floor(pos / dur) * dur;
+        pos     -= loopBase;
+    }
+
+    // AVSEEK_FLAG_BACKWARD: pos 以前で最も近いキーフレームへ。失敗する形式は先頭から読み直す
+    int64_t ts = (int64_t)(pos / av_q2d(st->time_base));
+    if (st->start_time != AV_NOPTS_VALUE) ts += st->start_time;
+    if (av_seek_frame(pFormatCtx, videoStreamIdx, ts, AVSEEK_FLAG_BACKWARD) < 0)
+        av_seek_frame(pFormatCtx, -1, 0, AVSEEK_FLAG_BACKWARD);
+    avcodec_flush_buffers(pCodecCtx);
+
+    // キーフレームから目標までは、デコードはするがスロットには書かない
+    const double halfFrame = (videoFps > 0.0) ? 0.5 / videoFps : 0.016;
+    dropBefore = loopBase + pos - halfFrame;
+}
+
 // ============================================================
 //  videoWorker — SPSC Producer、コア2固定 (Switch)
 // ============================================================
@@ -185,34 +376,215 @@ void BgaManager::videoWorker() {
     svcSetThreadCoreMask(-2, 2, (1U << 2));
 #endif
 
-    const int    w           = videoTexW;
-    const int    h           = videoTexH;
-    const size_t ySize       = (size_t)w * h;
-    const size_t uvSize      = (size_t)w * (h / 2);
     // フレーム間隔の半分をスリープ上限にすることで CPU の無駄食いを防ぐ
     const int    halfFrameMs = (videoFps > 0.0)
                                 ? std::max(1, (int)(500.0 / videoFps))
                                 : 16;
+    const double frameSec    = (videoFps > 0.0) ? 1.0 / videoFps : 1.0 / 30.0;
+    const AVStream* st       = pFormatCtx->streams[videoStreamIdx];
 
     // av_packet_alloc/free: FFmpeg 3.1以降の推奨API。av_init_packet は非推奨。
     AVPacket* packet = av_packet_alloc();
     if (!packet) return;
 
+    uint32_t gen        = videoGen.load(std::memory_order_acquire);
+    double   loopBase   = 0.0;    // ループした分の時間 (PTS に足す)
+    double   dropBefore = -1e9;   // これより前のフレームは読み捨てる (シーク直後)
+    double   passEnd    = 0.0;    // この周で出した最後のフレームの終わり (動画内時刻)
+    bool     atEnd      = false;  // ループしない動画を最後まで出した
+
+    // 【追加】適応デコードの計測。窓 = 出したフレームの動画内時刻で ADAPT_WINDOW_SEC 分
+    using Clock = std::chrono::steady_clock;
+    constexpr double ADAPT_WINDOW_SEC = 0.5;
+    constexpr double LOAD_HIGH        = 0.85; // 動画 1 秒のデコードにこれ以上掛かれば追いつけない
+    constexpr double LOAD_LOW         = 0.45; // これ未満が続けば1段戻す
+    constexpr double RAISE_HOLD_SEC   = 1.0;  // 段階を変えてから次に上げるまで (実時間)
+    constexpr double LOWER_HOLD_SEC   = 3.0;  // 余裕がこれだけ続いたら戻す
+    constexpr double CATCHUP_LAG_SEC  = 1.0;  // これ以上遅れたら時計の先へシークする
+    constexpr double CATCHUP_LEAD_SEC = 0.25;
+    const bool       adaptive    = Config::BGA_ADAPTIVE_DECODE;
+    const double     lagHigh     = std::max(0.1, 3.0 * frameSec);
+    double           decodeSec   = 0.0;   // 窓の間にデコーダの呼び出しで使った時間
+    double           windowStart = -1.0;  // 窓の最初のフレームの時刻 (< 0 = 未開始)
+    Clock::time_point lastChange = Clock::now();
+    Clock::time_point calmSince  = Clock::now();
+    bool             pendingSeek   = false; // 受信ループを抜けてから行う (デコーダを触るため)
+    bool             pendingReopen = false;
+    double           pendingTarget = 0.0;
+    decodeLevel = 0;
+
+    auto resetWindow = [&]() {
+        decodeSec   = 0.0;
+        windowStart = -1.0;
+        calmSince   = Clock::now();
+    };
+
+    // 世代が変わった (restartVideo) ら、出している途中のものを捨てて目標へ飛ぶ
+    auto checkRestart = [&]() {
+        uint32_t g = videoGen.load(std::memory_order_acquire);
+        if (g == gen) return false;
+        gen   = g;
+        atEnd = false;
+        pendingSeek = false; // 段階の変更は残す (開き直しは次のシークで一緒に行う)
+        if (pendingReopen) {
+            pendingReopen = false;
+            if (!openDecoder(levelLowres(decodeLevel)) && !openDecoder(0)) return true;
+        }
+        seekWorker(seekTargetSec.load(std::memory_order_relaxed), loopBase, dropBefore);
+        resetWindow();
+        return true;
+    };
+
+    // 【追加】窓ごとに負荷と遅れを見て段階を決める。シーク / 開き直しが要るなら true
+    auto adapt = [&](double frameTime) {
+        if (windowStart < 0.0) { windowStart = frameTime; decodeSec = 0.0; return false; }
+        const double span = frameTime - windowStart;
+        if (span < ADAPT_WINDOW_SEC) return false;
+
+        const double clock = sharedVideoElapsed.load(std::memory_order_acquire);
+        const double load  = decodeSec / span;
+        const double lag   = clock - frameTime; // 正 = 出したフレームがもう過去
+        windowStart = frameTime;
+        decodeSec   = 0.0;
+
+        if (lag > CATCHUP_LAG_SEC) {
+            pendingSeek   = true;
+            pendingTarget = clock + CATCHUP_LEAD_SEC;
+        }
+        if (!adaptive) return pendingSeek;
+
+        const Clock::time_point now = Clock::now();
+        const double sinceChange = std::chrono::duration<double>(now - lastChange).count();
+        int next = decodeLevel;
+        if (load > LOAD_HIGH || lag > lagHigh) {
+            calmSince = now;
+            if (sinceChange >= RAISE_HOLD_SEC && decodeLevel < DECODE_LEVELS - 1) next = decodeLevel + 1;
+        } else if (load < LOAD_LOW && lag < 0.0) {
+            // 解像度を戻す段は開き直しと巻き戻しが要るので、自動では戻さない
+            if (std::chrono::duration<double>(now - calmSince).count() >= LOWER_HOLD_SEC &&
+                sinceChange >= LOWER_HOLD_SEC && decodeLevel > 0 &&
+                levelLowres(decodeLevel - 1) == decodeLowres)
+                next = decodeLevel - 1;
+        } else {
+            calmSince = now;
+        }
+        if (next == decodeLevel) return pendingSeek;
+
+        fprintf(stderr, "BGA: decode level %d -> %d (load %.2f, lag %.0f ms)\n",
+                decodeLevel, next, load, lag * 1000.0);
+        decodeLevel = next;
+        lastChange  = now;
+        calmSince   = now;
+        if (levelLowres(next) != decodeLowres) {
+            pendingReopen = true;
+            if (!pendingSeek) {
+                pendingSeek   = true;
+                pendingTarget = clock + CATCHUP_LEAD_SEC;
+            }
+        } else {
+            applyDecodeLevel(next);
+        }
+        return pendingSeek;
+    };
+
+    // 【追加】受信ループの外で、決まったシーク / 開き直しを行う。行ったら true
+    auto applyPending = [&]() {
+        if (!pendingSeek) return false;
+        pendingSeek = false;
+        if (pendingReopen) {
+            pendingReopen = false;
+            fprintf(stderr, "BGA: reopening decoder at lowres %d\n", levelLowres(decodeLevel));
+            // 開けなければ元の解像度で開き直す (それも駄目なら動画を止める)
+            if (!openDecoder(levelLowres(decodeLevel)) && !openDecoder(0)) return true;
+        }
+        seekWorker(pendingTarget, loopBase, dropBefore);
+        resetWindow();
+        return true;
+    };
+
+    // 受け取ったフレームを1枚スロットへ。空きが出るまで待つ (旧実装はここで捨てていた)。
+    // 巻き戻し・終了が来たら false
+    auto emitFrame = [&]() {
+        int64_t pts = pFrame->best_effort_timestamp;
+        if (pts == AV_NOPTS_VALUE) pts = 0;
+        if (st->start_time != AV_NOPTS_VALUE) pts -= st->start_time;
+        double local = pts * av_q2d(st->time_base);
+        passEnd = std::max(passEnd, local + frameSec);
+        double frameTime = loopBase + local;
+        if (frameTime < dropBefore) return true; // decode-forward 中
+        if (adapt(frameTime)) return false;      // 受信ループを抜けてシーク / 開き直し
+
+        int tail, nextTail;
+        for (;;) {
+            if (quitThread.load(std::memory_order_relaxed)) return false;
+            if (videoGen.load(std::memory_order_acquire) != gen) return false;
+            tail     = qTail.load(std::memory_order_relaxed);
+            nextTail = (tail + 1) % NUM_SLOTS;
+            if (nextTail != qHead.load(std::memory_order_acquire)) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(halfFrameMs));
+        }
+
+        // ★修正: 画素はコピーせず、デコーダのフレームの参照をスロットへ移す。
+        //    このスロットは [head, tail) の外なので描画側は読んでいない。前に持っていた
+        //    参照 (表示済み・読み飛ばし済み) はここで外し、バッファをデコーダのプールへ返す
+        FrameSlot& slot = slots[tail];
+        av_frame_unref(slot.frame);
+        av_frame_move_ref(slot.frame, pFrame);
+        slot.pts = frameTime;
+        slot.gen = gen;
+
+        // ★ SPSC: tail を advance して Consumer に公開する
+        qTail.store(nextTail, std::memory_order_release);
+
+        // 最初の1フレームが書けたら準備完了フラグを立てる
+        if (!isReady.load(std::memory_order_relaxed))
+            isReady.store(true, std::memory_order_release);
+        return true;
+    };
+
+    // デコーダから出せるだけ受け取る
+    auto receiveAll = [&]() {
+        while (!quitThread.load(std::memory_order_relaxed)) {
+            const Clock::time_point t0 = Clock::now();
+            int ret = avcodec_receive_frame(pCodecCtx, pFrame);
+            decodeSec += std::chrono::duration<double>(Clock::now() - t0).count();
+            if (ret < 0) break; // EAGAIN / EOF / エラー
+            if (!emitFrame()) break;
+        }
+    };
+
     while (!quitThread.load(std::memory_order_relaxed)) {
+        checkRestart();
+        if (!pCodecCtx) break; // 開き直しに失敗した: 最後に出したフレームのまま止める
 
-        // --- キュー満杯チェック (mutex なし、acquire で tail を読む) ---
+        // --- キュー満杯 / 最後まで出し終えた → フレーム間隔の半分だけ待機 ---
         int tail     = qTail.load(std::memory_order_relaxed);
         int nextTail = (tail + 1) % NUM_SLOTS;
-        if (nextTail == qHead.load(std::memory_order_acquire)) {
-            // キューが満杯 → フレーム間隔の半分だけ待機
+        if (atEnd || nextTail == qHead.load(std::memory_order_acquire)) {
             std::this_thread::sleep_for(std::chrono::milliseconds(halfFrameMs));
             continue;
         }
 
         // --- パケット読み込み ---
         if (av_read_frame(pFormatCtx, packet) < 0) {
-            // EOF: BGA は1回再生で止まる (必要ならシークしてループもできる)
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // EOF: デコーダに溜まっている (B フレームの並べ替え待ちの) フレームを吐き出す
+            avcodec_send_packet(pCodecCtx, nullptr);
+            receiveAll();
+            if (videoGen.load(std::memory_order_acquire) != gen) continue;
+            if (applyPending()) continue; // 追いつくためのシークが先
+
+            if (videoLoop.load(std::memory_order_relaxed) && passEnd > 0.0) {
+                // 頭へ戻り、以降の PTS を1周分ずらす
+                if (loopLengthSec <= 0.0) loopLengthSec = passEnd;
+                double base = loopBase + loopLengthSec;
+                double drop;
+                seekWorker(0.0, loopBase, drop);
+                loopBase   = base;
+                dropBefore = -1e9;
+                passEnd    = 0.0;
+            } else {
+                atEnd = true; // 最後のフレームのまま、restartVideo を待つ
+            }
             continue;
         }
 
@@ -221,88 +593,15 @@ void BgaManager::videoWorker() {
             continue;
         }
 
-        if (avcodec_send_packet(pCodecCtx, packet) < 0) {
-            av_packet_unref(packet);
-            continue;
-        }
+        const Clock::time_point t0 = Clock::now();
+        const int sent = avcodec_send_packet(pCodecCtx, packet);
+        decodeSec += std::chrono::duration<double>(Clock::now() - t0).count();
         av_packet_unref(packet);
+        if (sent < 0) continue;
 
         // --- フレーム受信ループ (1パケットから複数フレームが出ることがある) ---
-        while (!quitThread.load(std::memory_order_relaxed)) {
-            int ret = avcodec_receive_frame(pCodecCtx, pFrame);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) break;
-            if (ret < 0) break;
-
-            // キュー再チェック (複数フレームデコード時に満杯になることがある)
-            tail     = qTail.load(std::memory_order_relaxed);
-            nextTail = (tail + 1) % NUM_SLOTS;
-            if (nextTail == qHead.load(std::memory_order_acquire)) {
-                // 満杯 → このフレームを捨てて次のパケットへ
-                break;
-            }
-
-            // --- PTS 計算 ---
-            int64_t pts = pFrame->best_effort_timestamp;
-            if (pts == AV_NOPTS_VALUE) pts = 0;
-            int64_t startTime = pFormatCtx->streams[videoStreamIdx]->start_time;
-            if (startTime != AV_NOPTS_VALUE) pts -= startTime;
-            double frameTime = pts * av_q2d(pFormatCtx->streams[videoStreamIdx]->time_base);
-
-            // --- NV12 変換 → slots[tail].data に直接書き込む ---
-            FrameSlot& slot = slots[tail];
-            slot.pts = frameTime;
-
-            uint8_t* dstY  = slot.data.data();
-            uint8_t* dstUV = dstY + ySize;
-
-            // Y 面コピー
-            // ストライドが width に一致する場合は単一 memcpy で最速処理
-            if (pFrame->linesize[0] == w) {
-                memcpy(dstY, pFrame->data[0], ySize);
-            } else {
-                for (int r = 0; r < h; r++)
-                    memcpy(dstY + r * w, pFrame->data[0] + r * pFrame->linesize[0], w);
-            }
-
-            // UV 面: YUV420P (planar U, V) → NV12 (interleaved UV) 変換
-            // pFrame->format == AV_PIX_FMT_NV12 の場合は data[1] がすでに UV interleaved
-            if (pFrame->format == AV_PIX_FMT_NV12) {
-                // デコーダがネイティブ NV12 を出力した場合 — コピーのみ
-                if (pFrame->linesize[1] == w) {
-                    memcpy(dstUV, pFrame->data[1], uvSize);
-                } else {
-                    for (int r = 0; r < h / 2; r++)
-                        memcpy(dstUV + r * w, pFrame->data[1] + r * pFrame->linesize[1], w);
-                }
-            } else {
-                // YUV420P → NV12: U/V をインターリーブ
-                // uint16_t で2バイト同時書き込みにより帯域を節約
-                if (pFrame->linesize[1] == w / 2 && pFrame->linesize[2] == w / 2) {
-                    // ストライド一致 → 内ループ展開なしで最速
-                    const uint8_t* sU   = pFrame->data[1];
-                    const uint8_t* sV   = pFrame->data[2];
-                    uint16_t*      dUV  = reinterpret_cast<uint16_t*>(dstUV);
-                    const size_t   n    = uvSize / 2; // UV ペア数
-                    for (size_t j = 0; j < n; j++)
-                        dUV[j] = (uint16_t)sU[j] | ((uint16_t)sV[j] << 8);
-                } else {
-                    for (int r = 0; r < h / 2; r++) {
-                        uint16_t*      dUV = reinterpret_cast<uint16_t*>(dstUV + r * w);
-                        const uint8_t* sU  = pFrame->data[1] + r * pFrame->linesize[1];
-                        const uint8_t* sV  = pFrame->data[2] + r * pFrame->linesize[2];
-                        for (int j = 0; j < w / 2; j++)
-                            dUV[j] = (uint16_t)sU[j] | ((uint16_t)sV[j] << 8);
-                    }
-                }
-            }
-
-            // ★ SPSC: tail を advance して Consumer に公開する
-            qTail.store(nextTail, std::memory_order_release);
-
-            // 最初の1フレームが書けたら準備完了フラグを立てる
-            if (!isReady.load(std::memory_order_relaxed))
-                isReady.store(true, std::memory_order_release);
-        }
+        receiveAll();
+        applyPending();
     }
 
     av_packet_free(&packet);
@@ -382,6 +681,11 @@ void BgaManager::render(long long currentPulse, SDL_Renderer* renderer, int x, i
         int head    = qHead.load(std::memory_order_relaxed);
         int tail    = qTail.load(std::memory_order_acquire);
         int bestIdx = -1;
+
+        // 【追加】restartVideo 前の世代のフレームは読み飛ばして解放する
+        const uint32_t gen = videoGen.load(std::memory_order_acquire);
+        while (head != tail && slots[head].gen != gen) head = (head + 1) % NUM_SLOTS;
+        qHead.store(head, std::memory_order_release);
         int scanIdx = head;
 
         while (scanIdx != tail) {
@@ -395,28 +699,33 @@ void BgaManager::render(long long currentPulse, SDL_Renderer* renderer, int x, i
 
         if (bestIdx >= 0) {
             // bestIdx のデータを SDL テクスチャへアップロードしてから head を advance する。
-            // 順序が逆だと Worker がまだ読み中のスロットを上書きするリスクがある。
-            const uint8_t* src    = slots[bestIdx].data.data();
-            const size_t   yBytes = (size_t)videoTexW * videoTexH;
-            const size_t   uvBytes = yBytes / 2;
+            // 順序が逆だと Worker がスロットの参照を外してバッファを再利用するリスクがある。
+            const AVFrame* f = slots[bestIdx].frame;
+
+            // 【追加】適応デコードで lowres が変わるとフレームの大きさが変わる → テクスチャを作り直す
+            if (f->width != videoTexW || f->height != videoTexH) {
+                SDL_DestroyTexture(videoTexture);
+                videoTexW    = f->width;
+                videoTexH    = f->height;
+                videoTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_NV12, SDL_TEXTUREACCESS_STREAMING,
+                                                 videoTexW, videoTexH);
+                if (!videoTexture) fprintf(stderr, "BGA: SDL_CreateTexture failed (%dx%d)\n", videoTexW, videoTexH);
+            }
 
             void* pixels; int pitch;
-            if (SDL_LockTexture(videoTexture, NULL, &pixels, &pitch) == 0) {
+            if (videoTexture && SDL_LockTexture(videoTexture, NULL, &pixels, &pitch) == 0) {
                 uint8_t* yDst  = (uint8_t*)pixels;
                 uint8_t* uvDst = yDst + (ptrdiff_t)pitch * videoTexH;
 
-                if (pitch == videoTexW) {
-                    // ★ ストライド一致 → Y / UV それぞれ1回の memcpy で完了
-                    //    行ごとループを廃止することで Switch の NEON 最適化が効きやすくなる
-                    memcpy(yDst,  src,          yBytes);
-                    memcpy(uvDst, src + yBytes, uvBytes);
+                // ★修正: デコーダの面から直接書く (これが1フレームで唯一のコピー)。
+                //    ストライドが一致すれば面ごとに1回、不一致なら行ごとに SIMD
+                Nv12Converter::copyPlane(f->data[0], f->linesize[0], yDst, pitch, videoTexW, videoTexH);
+                if (f->format == AV_PIX_FMT_NV12) {
+                    Nv12Converter::copyPlane(f->data[1], f->linesize[1], uvDst, pitch, videoTexW, videoTexH / 2);
                 } else {
-                    // ストライド不一致 (まれ) → 行ごとコピー
-                    for (int r = 0; r < videoTexH; r++)
-                        memcpy(yDst + (ptrdiff_t)r * pitch, src + r * videoTexW, videoTexW);
-                    const uint8_t* uvSrc = src + yBytes;
-                    for (int r = 0; r < videoTexH / 2; r++)
-                        memcpy(uvDst + (ptrdiff_t)r * pitch, uvSrc + r * videoTexW, videoTexW);
+                    // YUV420P → NV12: U/V をインターリーブしながら書く
+                    Nv12Converter::interleaveUV(f->data[1], f->linesize[1], f->data[2], f->linesize[2],
+                                                uvDst, pitch, videoTexW / 2, videoTexH / 2);
                 }
                 SDL_UnlockTexture(videoTexture);
             }
@@ -453,39 +762,57 @@ void BgaManager::render(long long currentPulse, SDL_Renderer* renderer, int x, i
 //  clear / cleanup
 // ============================================================
 
-void BgaManager::clear() {
+void BgaManager::closeVideo() {
     // ① デコードスレッドを停止する
     quitThread.store(true, std::memory_order_release);
     if (decodeThread.joinable()) decodeThread.join();
 
-    // ② テクスチャ解放
-    for (auto& pair : textures) if (pair.second.tex) SDL_DestroyTexture(pair.second.tex);
-    textures.clear();
     if (videoTexture) { SDL_DestroyTexture(videoTexture); videoTexture = nullptr; }
     videoTexW = 0; videoTexH = 0;
 
-    // ③ FFmpeg コンテキスト解放
+    // ② FFmpeg コンテキスト解放
     if (pFrame)     { av_frame_free(&pFrame);            pFrame     = nullptr; }
     if (pCodecCtx)  { avcodec_free_context(&pCodecCtx); pCodecCtx  = nullptr; }
     if (pFormatCtx) { avformat_close_input(&pFormatCtx); pFormatCtx = nullptr; }
 
-    // ④ SPSC スロット解放 (shrink_to_fit でメモリを OS に返す)
+    // ③ SPSC スロット解放 (参照しているデコーダのバッファもここで返る)
     for (int i = 0; i < NUM_SLOTS; i++) {
-        slots[i].data.clear();
-        slots[i].data.shrink_to_fit();
+        if (slots[i].frame) av_frame_free(&slots[i].frame);
         slots[i].pts = -1.0;
+        slots[i].gen = 0;
     }
     qHead.store(0, std::memory_order_relaxed);
     qTail.store(0, std::memory_order_relaxed);
 
-    // ⑤ 状態リセット
     isVideoMode = false;
     isReady.store(false, std::memory_order_release);
     quitThread.store(false, std::memory_order_relaxed);
     videoFps = 30.0;
+    videoPath.clear();
+}
+
+void BgaManager::clearImages() {
+    // 【追加】世代を進めて、ワーカーに残っている要求・届いている結果を捨てる
+    imageGen.fetch_add(1, std::memory_order_release);
+    ImageResult res;
+    while (imageResults.pop(res)) if (res.surf) SDL_FreeSurface(res.surf);
+    requestedIds.clear();
+    imageCues.clear();
+    imageCueIndex = 0;
+
+    for (auto& pair : textures) if (pair.second.tex) SDL_DestroyTexture(pair.second.tex);
+    textures.clear();
 
     currentEventIndex = 0; currentLayerIndex = 0; currentPoorIndex = 0;
     lastDisplayedId   = -1; lastLayerId = -1; lastPoorId = -1;
 }
 
-void BgaManager::cleanup() { clear(); }
+void BgaManager::clear() {
+    closeVideo();
+    clearImages();
+}
+
+void BgaManager::cleanup() {
+    stopImageWorker();
+    clear();
+}
@@ -7,7 +7,11 @@
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <functional>
+#include <unordered_set>
 #include "CommonTypes.hpp"
+#include "BMSData.hpp" // BgaEvent
+#include "SpscQueue.hpp"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -19,11 +23,6 @@ extern "C" {
 #include <switch.h>
 #endif
 
-struct BgaEvent {
-    long long y;
-    int id;
-};
-
 // ============================================================
 //  BgaManager — Switch 最適化版
 //
@@ -52,15 +51,54 @@ struct BgaEvent {
 //    → ストライドが width と一致する場合に2回の単一 memcpy で済む。
 //  修正: pitch == videoTexW の場合は Y/UV を各1回の memcpy で処理。
 //
-//  【動画制約】
-//    height <= 256px, fps <= 30fps の動画のみ受け付ける。
-//    これを超える動画は loadBgaFile() が false を返して拒否する。
+//  【追加】シーク・ループ・巻き戻し
+//    旧 videoWorker は EOF で 100ms スリープを繰り返すだけで、曲より短い動画は
+//    最後のフレームで止まり、リトライでも loadBgaFile で開き直していた。
+//    - restartVideo(sec): 世代 (videoGen) を進めるだけ。ワーカーはキーフレームへ
+//      シークして目標時刻まで読み捨てながらデコードし (decode-forward)、
+//      描画側は古い世代のスロットを読み飛ばして解放する。コンテナは開いたまま、
+//      スロットも確保し直さない。
+//    - ループ: EOF でデコーダに残ったフレームを吐き出してから先頭へシークし、
+//      以降の PTS に動画の長さを足す (描画側からは時刻が単調に進んで見える)。
+//
+//  【追加】スロットはデコーダのバッファへの参照 (ゼロコピー)
+//    旧実装はデコード結果を FrameSlot::data (NV12) にコピーし、render でもう一度
+//    テクスチャへコピーしていた。スロットは av_frame_move_ref でデコーダの
+//    フレームの参照を持つだけにし、render がその面から直接テクスチャへ書く
+//    (YUV420P の U/V インターリーブもこの時に行う)。1フレームのコピーはテクスチャ
+//    への1回だけになる。バッファはデコーダのプールに戻るまで参照カウントで守られる。
+//    - スロットの参照を外す (av_frame_unref) のは、そのスロットを次に書く直前の
+//      ワーカーだけ。[head, tail) にあるスロットは描画側のもので、ワーカーは触らない
+//    - 描画側はアップロードが終わってから head を進める (従来どおり)
+//
+//  【追加】適応デコード (旧: height > 256px / fps > 30 の動画は拒否)
+//    ワーカーが「動画 1 秒分のデコードに掛かった時間 (負荷)」と「描画側の時計
+//    (sharedVideoElapsed) に対する遅れ」を測り、追いつけなければ段階 (decodeLevel) を
+//    上げて画質を落とす。余裕が続けば1段ずつ戻す (解像度を戻す段は除く)。
+//      0: 従来 (非参照フレームのループフィルタを省く)
+//      1: ループフィルタを全て省き、非参照フレームの IDCT を省く
+//      2: 非参照フレームを捨てる / B フレームの IDCT を省く
+//      3, 4: lowres で 1/2, 1/4 の解像度でデコード (対応コーデックのみ。デコーダを開き直す)
+//      5: キーフレームだけ
+//    1 秒以上遅れたら、段階に関係なく時計の少し先へシークして追いつく。
+//    テクスチャの大きさは描画側が届いたフレームに合わせて作り直す。
+//    拒否するのは Config::BGA_VIDEO_MAX_HEIGHT を超える (メモリに載せたくない) 動画だけ。
+//
+//  【追加】画像 BGA の非同期デコード
+//    旧 preLoad はメインスレッドで IMG_Load + SDL_CreateTextureFromSurface を同期で行い、
+//    先読みもパルス (BPM で実時間が変わる) だったため、画像の多い譜面で引っかかりが出た。
+//    - 先読みは ms: setEventTimes で全イベントの時刻を求め、時刻順の「キュー」にする。
+//      preLoad(curMs) が curMs + Config::BGA_IMAGE_LOOKAHEAD_MS までの画像を要求する
+//    - 画像ワーカー (imageWorker) が IMG_Load とテクスチャ向け形式への変換を行い、
+//      SDL_Surface を結果キューに積む (要求・結果とも SpscQueue)
+//    - メインスレッドはテクスチャの作成 (アップロード) だけを、1フレーム
+//      Config::BGA_UPLOAD_BUDGET_US の予算内で行う (毎フレーム最低1枚は進める)
+//    譜面が変わったら imageGen を進め、古い要求・結果は捨てる。
 // ============================================================
 class BgaManager {
 public:
-    // 動画制約 (Switch の処理能力上限)
-    static constexpr int MAX_VIDEO_HEIGHT = 256;
-    static constexpr int MAX_VIDEO_FPS    = 30;
+    // 【追加】適応デコードの段階数 (0 〜 DECODE_LEVELS - 1)
+    static constexpr int DECODE_LEVELS = 6;
 
     BgaManager() = default;
     ~BgaManager() { cleanup(); }
@@ -68,23 +106,49 @@ public:
     void init(size_t expectedSize = 512);
     void setBgaDirectory(const std::string& dir) { baseDir = dir; }
     void registerPath(int id, const std::string& filename) { idToFilename[id] = filename; }
-    void loadBmp(int id, const std::string& fullPath, SDL_Renderer* renderer);
 
-    // 動画を開く。height>256 または fps>30 の動画は拒否して false を返す。
+    // 動画を開く。高さが Config::BGA_VIDEO_MAX_HEIGHT を超える動画は拒否して false を返す。
+    // ★修正: 重い動画も拒否せず、追いつけなければ適応デコードで画質を落とす
     bool loadBgaFile(const std::string& path, SDL_Renderer* renderer);
-
-    void preLoad(long long startPulse, SDL_Renderer* renderer);
+    // 【追加】同じ動画を開いたままか (リトライで開き直さずに restartVideo するため)
+    bool isVideoOpen(const std::string& path) const { return isVideoMode && path == videoPath; }
+    // 【追加】SPSC スロットを捨て、動画内時刻 sec (syncTime と同じ基準) から出し直す
+    void restartVideo(double sec = 0.0);
+    // 【追加】曲より短い動画を頭から繰り返す (既定は Config::BGA_VIDEO_LOOP)
+    void setVideoLoop(bool loop) { videoLoop.store(loop, std::memory_order_relaxed); }
+    // 動画だけを閉じる (画像・イベントはそのまま)
+    void closeVideo();
+
+    // ★修正: 毎フレーム呼ぶ。curMs から BGA_IMAGE_LOOKAHEAD_MS 先までの画像をワーカーに要求し、
+    //        デコード済みのものを予算内でテクスチャにする (旧: パルス先読み + 同期ロード)
+    void preLoad(double curMs, SDL_Renderer* renderer);
     void setEvents(const std::vector<BgaEvent>& events)      { bgaEvents   = events; currentEventIndex = 0; }
     void setLayerEvents(const std::vector<BgaEvent>& events)  { layerEvents = events; currentLayerIndex = 0; }
     void setPoorEvents(const std::vector<BgaEvent>& events)   { poorEvents  = events; currentPoorIndex  = 0; }
+    // 【追加】set*Events の後に呼ぶ: イベントの時刻 (ms) を求め、先読みの順番を作る
+    void setEventTimes(const std::function<double(long long)>& msFromY);
     void syncTime(double ms);
     void render(long long currentPulse, SDL_Renderer* renderer, int x, int y, double cur_ms = 0.0);
     void setMissTrigger(bool active) { showPoor = active; }
-    void clear();
+    void clear();        // 画像・イベント・動画をすべて解放
+    void clearImages();  // 画像とイベントの位置だけ (動画は開いたまま)
     void cleanup();
 
 private:
     void videoWorker();
+    // ワーカー: 動画内時刻 sec の手前のキーフレームへ飛び、sec より前のフレームを読み捨てる
+    void seekWorker(double sec, double& loopBase, double& dropBefore);
+    double knownDurationSec() const;
+    // 【追加】デコーダを (開き直して) 開く。lowres はコーデックの上限で切り詰める
+    bool openDecoder(int lowres);
+    // 【追加】段階の skip_* を pCodecCtx に設定する (lowres は openDecoder で)
+    void applyDecodeLevel(int level);
+    int  levelLowres(int level) const;
+    // 【追加】画像ワーカー
+    void imageWorker();
+    void startImageWorker();
+    void stopImageWorker();
+    void uploadImages(SDL_Renderer* renderer);
 
     // BMP/PNG テクスチャエントリ
     struct BgaTextureEntry {
@@ -102,6 +166,34 @@ private:
     int    lastDisplayedId   = -1, lastLayerId = -1, lastPoorId = -1;
     bool   showPoor          = false;
 
+    // 【追加】画像の非同期デコード
+    struct ImageCue {
+        double   ms;
+        int      id;
+        uint32_t path; // imagePaths の添字 (登録されていない ID は NO_PATH)
+    };
+    static constexpr uint32_t NO_PATH = UINT32_MAX;
+    // ★要求には文字列を載せず、imagePaths の添字だけを渡す (SpscQueue の push をアロケーションなしに保つ)
+    struct ImageRequest {
+        int      id   = -1;
+        uint32_t gen  = 0;
+        uint32_t path = NO_PATH;
+    };
+    struct ImageResult {
+        int          id   = -1;
+        uint32_t     gen  = 0;
+        SDL_Surface* surf = nullptr; // 読めなかったら nullptr
+    };
+    std::vector<ImageCue>            imageCues;      // 時刻順 (メインスレッドのみ)
+    std::vector<std::string>         imagePaths;     // フルパス。ワーカーを止めている間にだけ作り直す (以後は読み取り専用)
+    size_t                           imageCueIndex = 0;
+    std::unordered_set<int>          requestedIds;   // 要求済み (メインスレッドのみ)
+    SpscQueue<ImageRequest, 256>     imageRequests;  // メイン → ワーカー
+    SpscQueue<ImageResult, 16>       imageResults;   // ワーカー → メイン (デコード済みの上限)
+    std::atomic<uint32_t>            imageGen{0};
+    std::atomic<bool>                imageQuit{false};
+    std::thread                      imageThread;
+
     // 動画状態
     bool               isVideoMode = false;
     std::atomic<bool>  isReady{false};   // worker が最初の1フレームを書いた後 true になる
@@ -109,6 +201,11 @@ private:
     int                videoTexW    = 0;
     int                videoTexH    = 0;
     double             videoFps     = 30.0;
+    std::string        videoPath;
+    std::atomic<bool>  videoLoop{true};
+    double             loopLengthSec = 0.0; // ワーカーのみ: 1周目の EOF で分かった動画の長さ
+    int                decodeLevel   = 0;   // ワーカーのみ: 適応デコードの今の段階
+    int                decodeLowres  = 0;   // ワーカーのみ: 今のデコーダの lowres
 
     // FFmpeg コンテキスト
     AVFormatContext* pFormatCtx     = nullptr;
@@ -120,6 +217,9 @@ private:
     std::thread         decodeThread;
     std::atomic<bool>   quitThread{false};
     std::atomic<double> sharedVideoElapsed{0.0};
+    // 巻き戻し要求: seekTargetSec を書いてから videoGen を進める (描画スレッド → ワーカー)
+    std::atomic<uint32_t> videoGen{0};
+    std::atomic<double>   seekTargetSec{0.0};
 
     // ============================================================
     //  SPSC ロックフリーリングバッファ
@@ -129,14 +229,15 @@ private:
     //  → mutex 不要、キャッシュライン競合も最小
     //
     //  NUM_SLOTS = 6: 30fps なら約200ms 分のバッファ
-    //  各スロット: NV12 タイトパッキング (stride = width)
-    //             サイズ = width × height × 3/2
+    //  ★修正: 各スロットはデコーダのフレームへの参照 (コピーしない)。
+    //         参照を外すのは次にそのスロットへ書くワーカー
     // ============================================================
     static constexpr int NUM_SLOTS = 6;
 
     struct FrameSlot {
-        std::vector<uint8_t> data; // NV12 (Y plane + UV plane 連続)
+        AVFrame*             frame = nullptr; // YUV420P / NV12 (linesize はデコーダのまま)
         double               pts = -1.0;
+        uint32_t             gen = 0;      // 書いた時の videoGen。違えば描画側が読み飛ばす
     };
 
     FrameSlot          slots[NUM_SLOTS];
@@ -1,7 +1,6 @@
 #include "BmsonLoader.hpp"
 #include <fstream>
 #include <algorithm>
-#include "SoundManager.hpp"
 #include "json.hpp"
 #include <map>
 
@@ -0,0 +1,98 @@
+#ifndef BOXWAVFORMAT_HPP
+#define BOXWAVFORMAT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// ============================================================
+//  .boxwav コンテナ形式 (ゲーム本体と tools/boxwav_pack で共有)
+//
+//  【v1】(既存の配布物)
+//    uint32 count, uint32 d1, uint32 d2
+//    count × { char name[32], uint32 size, uint8 data[size] (WAV/OGG ファイルそのまま) }
+//    目次が無いので、索引を作るにはエントリを1つずつ seek して辿るしかない。
+//    パート数も分からないため name2.boxwav, name3.boxwav… を開けるまで試す。
+//
+//  【v2】
+//    先頭パート (name.boxwav) の先頭に HeaderV2 と全パート分の目次 (TocEntryV2 × entryCount)。
+//    2 パート目以降 (name2.boxwav…) はデータのみ。目次は1回の読み込みで済み、
+//    パート数もヘッダに書かれている。
+//    FORMAT_S16 のエントリは、ミキサーの出力形式 (sampleRate / channels の
+//    インターリーブ int16 リトルエンディアン) に変換済みの PCM をそのまま持つ。
+//    デバイスの形式と一致すればロード時の変換は不要 (コピーのみ)。
+//
+//  マジックの位置 (先頭 4 バイト) は v1 では count なので、count が 'BXW2' (= 約 8.4 億)
+//  になる v1 ファイルは存在しないものとして判別する。
+// ============================================================
+namespace BoxWav {
+
+constexpr uint32_t MAGIC_V2   = 0x32575842; // "BXW2" (リトルエンディアン)
+constexpr uint32_t VERSION_V2 = 2;
+constexpr size_t   NAME_LEN   = 32;
+
+enum Format : uint16_t {
+    FORMAT_FILE = 0, // 元のファイル (WAV/OGG/FLAC) をそのまま格納。ロード時にデコード
+    FORMAT_S16  = 1, // インターリーブ int16 LE。sampleRate / channels はエントリごとに記録
+};
+
+#pragma pack(push, 1)
+struct HeaderV2 {
+    uint32_t magic;       // MAGIC_V2
+    uint32_t version;     // VERSION_V2
+    uint32_t entryCount;
+    uint32_t partCount;   // 1 = name.boxwav のみ
+    uint32_t sampleRate;  // パック時に想定したミキサーの出力形式 (参考値)
+    uint16_t channels;
+    uint16_t reserved;
+    uint64_t tocOffset;   // 先頭パート内の目次の位置
+};
+
+struct TocEntryV2 {
+    char     name[NAME_LEN]; // NUL 終端とは限らない (v1 と同じく最大 32 文字)
+    uint32_t reserved0;      // 0 (旧 nameHash。索引は名前そのもので引くので読まない)
+    uint32_t part;           // 0 = name.boxwav, 1 = name2.boxwav, …
+    uint64_t offset;         // パート先頭からのバイト位置
+    uint32_t size;           // バイト数
+    uint32_t frames;         // FORMAT_S16 のみ有効
+    uint16_t format;         // Format
+    uint16_t channels;
+    uint32_t sampleRate;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(HeaderV2) == 32, "HeaderV2 layout");
+static_assert(sizeof(TocEntryV2) == 64, "TocEntryV2 layout");
+
+// ------------------------------------------------------------
+//  読み込み側の検証 (本体の SoundManager::loadIndexV2 と boxwav_pack の読み戻し確認で共有)
+// ------------------------------------------------------------
+
+// 先頭 sizeof(HeaderV2) バイトを読む。v2 でなければ false (呼び出し側は v1 として扱う)
+inline bool readHeaderV2(const uint8_t* bytes, HeaderV2& out) {
+    std::memcpy(&out, bytes, sizeof(out));
+    return out.magic == MAGIC_V2;
+}
+
+// v2 だが、このビルドでは読めないヘッダ (版違い・パート数 0)
+inline bool isSupportedV2(const HeaderV2& h) {
+    return h.version == VERSION_V2 && h.partCount > 0;
+}
+
+// base + ".boxwav", base + "2.boxwav", … (part は 0 始まり)
+inline std::string partPath(const std::string& base, uint32_t part) {
+    return part == 0 ? base + ".boxwav" : base + std::to_string(part + 1) + ".boxwav";
+}
+
+// 目次のエントリが使えるか。partSizes[p] はパート p のバイト数 (開けなかったパートは 0)。
+// 本体の BoxEntry::offset は uint32 なので、4GB を越える位置も弾く
+inline bool entryUsable(const TocEntryV2& e, const HeaderV2& h, const uint64_t* partSizes) {
+    if (e.part >= h.partCount || e.size == 0) return false;
+    if (e.offset > partSizes[e.part] || e.size > partSizes[e.part] - e.offset) return false;
+    return e.offset <= UINT32_MAX;
+}
+
+} // namespace BoxWav
+
+#endif // BOXWAVFORMAT_HPP
@@ -0,0 +1,129 @@
+#include "ChartRenderer.hpp"
+#include "ChartProjector.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <memory>
+
+std::vector<ChartRenderer::Event> ChartRenderer::eventsFromChart(BMSData& data, bool autoplay) {
+    ChartProjector projector;
+    projector.init(data);
+
+    std::vector<Event> events;
+    for (const auto& ch : data.sound_channels) {
+        uint32_t sId = std::hash<std::string>{}(ch.name); // PlayEngine と同じ ID
+        for (const auto& n : ch.notes) {
+            bool isBGM = (n.x < 1 || n.x > 8);
+            if (!isBGM && !autoplay) continue;
+            events.push_back({projector.getMsFromY(n.y), sId, isBGM ? 0 : (int)n.x});
+        }
+    }
+    // 同時刻は BGM → レーン順 (PlayEngine のノーツの並びと同じ)
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (a.ms != b.ms) return a.ms < b.ms;
+        return a.lane < b.lane;
+    });
+    return events;
+}
+
+// ============================================================
+//  render — ブロックごとに「先読み分を積む → mix()」を繰り返す
+//  演奏中のゲームループ (PlayEngine::update が積み、コールバックが mix する) と同じ順番。
+//  キューとスケジュール待ちが溢れないよう、1ブロックで積むのは半分までにする
+//  (積み残しは次のブロックで積む。時刻を過ぎていれば lateEvents に数えられる)。
+// ============================================================
+ChartRenderer::Result ChartRenderer::render(const std::vector<Event>& events, const SoundLookup& lookup,
+                                            const Options& opt, const Sink& sink) {
+    Result r;
+    const int ch    = (opt.channels == 2) ? 2 : 1;
+    const int block = std::clamp(opt.blockFrames, 16, AudioMixer::MAX_BLOCK_SAMPLES);
+    const double msPerFrame = 1000.0 / opt.rate;
+    const int maxPushPerBlock = std::min(AudioMixer::QUEUE_CAPACITY, AudioMixer::MAX_PENDING) / 2;
+
+    // 曲の長さ = 最後に鳴り終わる音 + tailMs
+    double startMs = 0.0, endMs = 0.0;
+    for (const Event& e : events) {
+        startMs = std::min(startMs, e.ms);
+        const Sound* s = lookup(e.soundId);
+        if (!s || s->samples == 0) continue;
+        endMs = std::max(endMs, e.ms + (s->onsetFrames + s->samples / (uint32_t)ch) * msPerFrame);
+    }
+    endMs += opt.tailMs;
+
+    // AudioMixer は固定長の配列を抱えていて大きいので、スタックには置かない
+    auto mixer = std::make_unique<AudioMixer>();
+    mixer->configure(opt.rate, ch);
+    mixer->setPolyphony(opt.polyphony);
+    mixer->startOfflineClock(startMs);
+
+    std::vector<int16_t> out((size_t)block * ch);
+    uint64_t hash = 1469598103934665603ull;
+    size_t next = 0;
+
+    const std::clock_t cpu0 = std::clock();
+    const auto wall0 = std::chrono::steady_clock::now();
+    for (;;) {
+        const double bufStart = startMs + (double)r.frames * msPerFrame;
+        if (bufStart >= endMs) break;
+        const double horizon = bufStart + block * msPerFrame + opt.lookaheadMs;
+
+        int pushed = 0;
+        while (next < events.size() && events[next].ms < horizon && pushed < maxPushPerBlock) {
+            const Event& e = events[next++];
+            const Sound* s = lookup(e.soundId);
+            if (!s || s->samples == 0) {
+                r.missing++;
+                continue;
+            }
+            const bool player = e.lane > 0;
+            const AudioMixer::Priority pr = player ? AudioMixer::PRIORITY_PLAYER : AudioMixer::PRIORITY_BGM;
+            const uint16_t choke = (player && opt.laneChoke) ? (uint16_t)e.lane : 0;
+            if (s->adpcm) mixer->scheduleAdpcm(s->adpcm, s->samples, e.soundId, opt.gain, pr, e.ms, s->onsetFrames, choke);
+            else          mixer->schedule(s->pcm, s->samples, e.soundId, opt.gain, pr, e.ms, s->onsetFrames, choke);
+            r.events++;
+            pushed++;
+        }
+
+        mixer->mix(out.data(), block);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(out.data());
+        for (size_t i = 0; i < out.size() * sizeof(int16_t); i++) hash = (hash ^ bytes[i]) * 1099511628211ull;
+        r.frames += (uint64_t)block;
+        if (sink && !sink(out.data(), (uint32_t)block)) break;
+    }
+    r.cpuSec   = (double)(std::clock() - cpu0) / CLOCKS_PER_SEC;
+    r.wallSec  = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+    r.audioSec = (double)r.frames / opt.rate;
+    r.hash     = hash;
+    r.stats    = mixer->getStats();
+    return r;
+}
+
+static void put16(std::ofstream& f, uint16_t x) { char b[2] = {(char)(x & 0xFF), (char)(x >> 8)}; f.write(b, 2); }
+static void put32(std::ofstream& f, uint32_t x) { put16(f, (uint16_t)(x & 0xFFFF)); put16(f, (uint16_t)(x >> 16)); }
+
+bool ChartRenderer::renderToWav(const std::vector<Event>& events, const SoundLookup& lookup,
+                                const Options& opt, const std::string& path, Result& out) {
+    std::ofstream f(path, std::ios::binary);
+    if (!f) return false;
+    const int ch = (opt.channels == 2) ? 2 : 1;
+
+    // サイズは書き終えてから埋める
+    f.write("RIFF", 4); put32(f, 0); f.write("WAVEfmt ", 8);
+    put32(f, 16); put16(f, 1); put16(f, (uint16_t)ch); put32(f, (uint32_t)opt.rate);
+    put32(f, (uint32_t)(opt.rate * ch * 2)); put16(f, (uint16_t)(ch * 2)); put16(f, 16);
+    f.write("data", 4); put32(f, 0);
+
+    // PCM はネイティブエンディアンの int16 (Switch / x86 はリトルエンディアン) をそのまま書く
+    out = render(events, lookup, opt, [&](const int16_t* pcm, uint32_t frames) {
+        f.write(reinterpret_cast<const char*>(pcm), (std::streamsize)frames * ch * sizeof(int16_t));
+        return (bool)f;
+    });
+    if (!f) return false;
+
+    const uint64_t dataBytes = out.frames * (uint64_t)ch * sizeof(int16_t);
+    if (dataBytes > UINT32_MAX - 36) return false;
+    f.seekp(4);  put32(f, (uint32_t)(36 + dataBytes));
+    f.seekp(40); put32(f, (uint32_t)dataBytes);
+    return (bool)f;
+}
@@ -0,0 +1,81 @@
+#ifndef CHARTRENDERER_HPP
+#define CHARTRENDERER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "AudioMixer.hpp"
+#include "BMSData.hpp"
+
+// ============================================================
+//  ChartRenderer — 譜面1曲分の音をオフラインで (実時間より速く) 書き出す
+//
+//  【目的】
+//    キー音のタイミングやミキサーの負荷を確かめるのに、これまでは実機で
+//    演奏して耳で聞くしかなかった。サウンドデバイス無しで毎回同じ結果になる
+//    基準の音と、「CPU 1 秒で何秒分の音を作れるか」のベンチマークが欲しい。
+//
+//  【方法】
+//    演奏中と同じ AudioMixer を使い、経路も同じにする:
+//      - BGM は PlayEngine と同じく BGM_LOOKAHEAD_MS 先までを schedule() で積む
+//      - プレイヤーのノーツはオートプレイ (判定ちょうど) で、レーンをチョークグループにして積む
+//      - 同じ音の同時発音数 (polyphony) も演奏中と同じ設定を使える
+//    ソングクロックだけは実時間ではなく AudioMixer::startOfflineClock (書いたフレーム数) で進む。
+//    ボイスの開始位置は実時間に依存しないので、同じ入力からは常に同じ PCM が出る。
+//
+//  SDL に依存しないため tools/chart_render からそのまま使える。
+// ============================================================
+class ChartRenderer {
+public:
+    // 1発音。lane 0 = BGM、1〜8 = オートプレイで叩くプレイヤーのレーン
+    struct Event {
+        double   ms      = 0.0;
+        uint32_t soundId = 0;
+        int      lane    = 0;
+    };
+    // デバイスと同じ形式 (Options の rate / channels) の音。pcm か adpcm のどちらか
+    struct Sound {
+        const int16_t* pcm         = nullptr;
+        const uint8_t* adpcm       = nullptr; // AdpcmCodec で圧縮した音
+        uint32_t       samples     = 0;       // インターリーブ後 (展開後) のサンプル数
+        uint32_t       onsetFrames = 0;       // 先頭の無音を切った分
+    };
+    struct Options {
+        int    rate        = 22050;
+        int    channels    = 1;
+        int    blockFrames = 512;           // 1回の mix() のフレーム数 (デバイスのバッファ長)
+        int    polyphony   = 2;             // Config::KEYSOUND_MAX_POLY と同じ意味 (0 = 無制限)
+        bool   laneChoke   = true;          // Config::LANE_CHOKE
+        float  gain        = 96.0f / 128.0f; // SoundManager のキー音の音量
+        double lookaheadMs = 50.0;          // PlayEngine の BGM_LOOKAHEAD_MS
+        double tailMs      = 1000.0;        // 最後の音が鳴り終わった後に足す無音
+    };
+    struct Result {
+        uint64_t frames   = 0;
+        uint32_t events   = 0;   // 積んだ発音
+        uint32_t missing  = 0;   // 音が無くて飛ばした発音
+        double   audioSec = 0.0;
+        double   cpuSec   = 0.0; // プロセスの CPU 時間
+        double   wallSec  = 0.0;
+        uint64_t hash     = 0;   // 出力 PCM の FNV-1a (回帰テストの比較用)
+        AudioMixer::Stats stats;
+        double speed() const { return cpuSec > 0.0 ? audioSec / cpuSec : 0.0; } // 音の秒数 / CPU 秒
+    };
+
+    using SoundLookup = std::function<const Sound*(uint32_t soundId)>;
+    // 書き出し先。false を返すと中断する
+    using Sink = std::function<bool(const int16_t* pcm, uint32_t frames)>;
+
+    // 譜面の全ノーツを発音にする (PlayEngine と同じ soundId・時刻。LN は始点だけ鳴らす)。
+    // autoplay = false ならプレイヤーのノーツは入れない (BGM だけ)
+    static std::vector<Event> eventsFromChart(BMSData& data, bool autoplay = true);
+
+    static Result render(const std::vector<Event>& events, const SoundLookup& lookup,
+                         const Options& opt, const Sink& sink);
+    // 16bit PCM の WAV ファイルに書き出す
+    static bool renderToWav(const std::vector<Event>& events, const SoundLookup& lookup,
+                            const Options& opt, const std::string& path, Result& out);
+};
+
+#endif // CHARTRENDERER_HPP
@@ -44,6 +44,44 @@ namespace Config {
     // --- 【追加】判定設定 ---
     inline int JUDGE_OFFSET = 0; // 判定オフセット(ms) 正の値で判定が遅くなる（ノーツが下がる）
     inline bool SHOW_FAST_SLOW = true; // 【追加】FAST/SLOW表示切り替えフラグ
+    inline bool PREDICT_DISPLAY_TIME = true; // 【追加】ノーツ・小節線・BGA を予測表示時刻で配置する
+    inline bool BGA_VIDEO_LOOP = true;       // 【追加】曲より短い BGA 動画を頭から繰り返す (0 = 最後のフレームで止める)
+    // 【追加】動画 BGA のデコード。重い動画も拒否せず、追いつけない時だけ画質を落とす
+    inline bool BGA_ADAPTIVE_DECODE = true;    // 0 = 段階を上げない (従来の画質のまま遅れる)
+    inline int BGA_VIDEO_MAX_HEIGHT = 1080;    // これより高い動画だけは開かない
+    inline int BGA_IMAGE_LOOKAHEAD_MS = 3000;  // 画像 BGA をこの時間 (ms) 先の分まで裏でデコードしておく
+    inline int BGA_UPLOAD_BUDGET_US = 2000;    // 1フレームで画像をテクスチャにする時間の上限 (最低1枚は進める)
+#ifdef __SWITCH__
+    inline int BGA_DECODE_THREADS = 1;         // FFmpeg のデコードスレッド数。0 = 自動。Switch はワーカーをコア2に閉じ込めるため 1
+#else
+    inline int BGA_DECODE_THREADS = 0;
+#endif
+    inline bool LATENCY_PROBE = false;       // 【追加】打鍵 → 音 → 画面の遅延を計測してオーバーレイと CSV に出す
+    inline bool PLAY_STATS_LOG = false;      // 演奏前後の計測値 (FramePacer / Mixer / ロード / 遅延) を標準出力に出す
+
+    // --- 【追加】サウンド設定 ---
+    inline bool BGM_PREMIX = true; // BGM レーンのキー音をロード時に1本のトラックへ事前ミックスする
+    inline int SOUND_CACHE_MB = 256; // 曲をまたいで保持するデコード済みキー音の上限 (MB)。0 で無効
+    inline int ASYNC_LOAD_LEAD_SEC = 20; // 最初の N 秒で使うキー音が揃ったら開始し、残りは演奏中に読む。0 で全て読んでから開始
+    inline int LOAD_DECODE_THREADS = 0; // キー音デコードのワーカー数。0 でコア数 - 1 (I/O は別に1本)
+    inline int SILENCE_TRIM_DB = -60; // キー音の前後でこれ以下 (dBFS) の無音を切り落とす。0 で無効
+    inline bool KEYSOUND_ADPCM = true; // BGM レーンだけの音・めったに鳴らない音を ADPCM (約 1/4) で持つ
+    inline int ADPCM_RARE_USES = 2;    // プレイヤーレーンの音もこの回数以下しか鳴らなければ圧縮する
+    inline int STREAM_SOUND_SEC = 8;   // これ以上長い PCM WAV のキー音は常駐させずディスクから流す。0 で無効
+    inline int KEYSOUND_MAX_POLY = 2;  // 同じキー音を同時に鳴らせる数。超えたら古い方を絞って止める。0 で無制限
+    inline bool LANE_CHOKE = true;     // プレイヤーのレーンごとに、新しい打鍵音で前の音を止める
+    // 【追加】オーディオ形式。AUDIO_AUTO なら起動時に計測して選び、結果を AUDIO_RATE / CHANNELS / BUFFER に書く
+    //         (キー音の WAV Memory はレート × チャンネル数に比例する。22050 / 1 が旧来の形式)
+    // ★上限の既定は 22050 / 1。48000 / 2 は同じ譜面で約 4.35 倍のメモリを使うのに MAX_WAV_MEMORY も
+    //   boxwav パック (tools/boxwav_pack の既定 22050 / 1) もそのままなので、上げる時は両方も合わせる
+    inline bool AUDIO_AUTO = true;
+    inline int AUDIO_MAX_RATE = 22050;
+    inline int AUDIO_MAX_CHANNELS = 1;
+    inline int AUDIO_RATE = 22050;     // AUDIO_AUTO = 0 の時はこの形式で開く
+    inline int AUDIO_CHANNELS = 1;
+    inline int AUDIO_BUFFER = 512;     // フレーム数
+    inline int AUDIO_MIN_BUFFER = 256; // 途切れが何曲も続いたら次回起動時からこれを広げる
+    inline int AUDIO_BUFFER_STREAK = 0; // 途切れた曲が続いた数 (正) / 途切れなかった曲が続いた数 (負)
 
     // --- 【追加】システム設定 ---
     inline int START_UP_OPTION = 1; // 0: Title, 1: Select (デフォルト選曲画面)
@@ -131,6 +169,33 @@ namespace Config {
                 else if (key == "DAN_GAUGE_START_PERCENT") DAN_GAUGE_START_PERCENT = std::stoi(val); 
                 else if (key == "JUDGE_OFFSET") JUDGE_OFFSET = std::stoi(val);
                 else if (key == "SHOW_FAST_SLOW") SHOW_FAST_SLOW = (std::stoi(val) != 0); 
+                else if (key == "PREDICT_DISPLAY_TIME") PREDICT_DISPLAY_TIME = (std::stoi(val) != 0);
+                else if (key == "BGA_VIDEO_LOOP") BGA_VIDEO_LOOP = (std::stoi(val) != 0);
+                else if (key == "BGA_ADAPTIVE_DECODE") BGA_ADAPTIVE_DECODE = (std::stoi(val) != 0);
+                else if (key == "BGA_VIDEO_MAX_HEIGHT") BGA_VIDEO_MAX_HEIGHT = std::stoi(val);
+                else if (key == "BGA_IMAGE_LOOKAHEAD_MS") BGA_IMAGE_LOOKAHEAD_MS = std::stoi(val);
+                else if (key == "BGA_UPLOAD_BUDGET_US") BGA_UPLOAD_BUDGET_US = std::stoi(val);
+                else if (key == "BGA_DECODE_THREADS") BGA_DECODE_THREADS = std::stoi(val);
+                else if (key == "LATENCY_PROBE") LATENCY_PROBE = (std::stoi(val) != 0);
+                else if (key == "PLAY_STATS_LOG") PLAY_STATS_LOG = (std::stoi(val) != 0);
+                else if (key == "BGM_PREMIX") BGM_PREMIX = (std::stoi(val) != 0);
+                else if (key == "SOUND_CACHE_MB") SOUND_CACHE_MB = std::stoi(val);
+                else if (key == "ASYNC_LOAD_LEAD_SEC") ASYNC_LOAD_LEAD_SEC = std::stoi(val);
+                else if (key == "LOAD_DECODE_THREADS") LOAD_DECODE_THREADS = std::stoi(val);
+                else if (key == "SILENCE_TRIM_DB") SILENCE_TRIM_DB = std::stoi(val);
+                else if (key == "KEYSOUND_ADPCM") KEYSOUND_ADPCM = (std::stoi(val) != 0);
+                else if (key == "ADPCM_RARE_USES") ADPCM_RARE_USES = std::stoi(val);
+                else if (key == "STREAM_SOUND_SEC") STREAM_SOUND_SEC = std::stoi(val);
+                else if (key == "KEYSOUND_MAX_POLY") KEYSOUND_MAX_POLY = std::stoi(val);
+                else if (key == "LANE_CHOKE") LANE_CHOKE = (std::stoi(val) != 0);
+                else if (key == "AUDIO_AUTO") AUDIO_AUTO = (std::stoi(val) != 0);
+                else if (key == "AUDIO_MAX_RATE") AUDIO_MAX_RATE = std::stoi(val);
+                else if (key == "AUDIO_MAX_CHANNELS") AUDIO_MAX_CHANNELS = std::stoi(val);
+                else if (key == "AUDIO_RATE") AUDIO_RATE = std::stoi(val);
+                else if (key == "AUDIO_CHANNELS") AUDIO_CHANNELS = std::stoi(val);
+                else if (key == "AUDIO_BUFFER") AUDIO_BUFFER = std::stoi(val);
+                else if (key == "AUDIO_MIN_BUFFER") AUDIO_MIN_BUFFER = std::stoi(val);
+                else if (key == "AUDIO_BUFFER_STREAK") AUDIO_BUFFER_STREAK = std::stoi(val);
                 else if (key == "START_UP_OPTION") START_UP_OPTION = std::stoi(val);
                 else if (key == "FOLDER_NOTES_MIN") FOLDER_NOTES_MIN = std::stoi(val);
                 else if (key == "FOLDER_NOTES_MAX") FOLDER_NOTES_MAX = std::stoi(val);
@@ -196,6 +261,33 @@ namespace Config {
         file << "DAN_GAUGE_START_PERCENT=" << DAN_GAUGE_START_PERCENT << "\n"; 
         file << "JUDGE_OFFSET=" << JUDGE_OFFSET << "\n";
         file << "SHOW_FAST_SLOW=" << (SHOW_FAST_SLOW ? 1 : 0) << "\n";
+        file << "PREDICT_DISPLAY_TIME=" << (PREDICT_DISPLAY_TIME ? 1 : 0) << "\n";
+        file << "BGA_VIDEO_LOOP=" << (BGA_VIDEO_LOOP ? 1 : 0) << "\n";
+        file << "BGA_ADAPTIVE_DECODE=" << (BGA_ADAPTIVE_DECODE ? 1 : 0) << "\n";
+        file << "BGA_VIDEO_MAX_HEIGHT=" << BGA_VIDEO_MAX_HEIGHT << "\n";
+        file << "BGA_IMAGE_LOOKAHEAD_MS=" << BGA_IMAGE_LOOKAHEAD_MS << "\n";
+        file << "BGA_UPLOAD_BUDGET_US=" << BGA_UPLOAD_BUDGET_US << "\n";
+        file << "BGA_DECODE_THREADS=" << BGA_DECODE_THREADS << "\n";
+        file << "LATENCY_PROBE=" << (LATENCY_PROBE ? 1 : 0) << "\n";
+        file << "PLAY_STATS_LOG=" << (PLAY_STATS_LOG ? 1 : 0) << "\n";
+        file << "BGM_PREMIX=" << (BGM_PREMIX ? 1 : 0) << "\n";
+        file << "SOUND_CACHE_MB=" << SOUND_CACHE_MB << "\n";
+        file << "ASYNC_LOAD_LEAD_SEC=" << ASYNC_LOAD_LEAD_SEC << "\n";
+        file << "LOAD_DECODE_THREADS=" << LOAD_DECODE_THREADS << "\n";
+        file << "SILENCE_TRIM_DB=" << SILENCE_TRIM_DB << "\n";
+        file << "KEYSOUND_ADPCM=" << (KEYSOUND_ADPCM ? 1 : 0) << "\n";
+        file << "ADPCM_RARE_USES=" << ADPCM_RARE_USES << "\n";
+        file << "STREAM_SOUND_SEC=" << STREAM_SOUND_SEC << "\n";
+        file << "KEYSOUND_MAX_POLY=" << KEYSOUND_MAX_POLY << "\n";
+        file << "LANE_CHOKE=" << (LANE_CHOKE ? 1 : 0) << "\n";
+        file << "AUDIO_AUTO=" << (AUDIO_AUTO ? 1 : 0) << "\n";
+        file << "AUDIO_MAX_RATE=" << AUDIO_MAX_RATE << "\n";
+        file << "AUDIO_MAX_CHANNELS=" << AUDIO_MAX_CHANNELS << "\n";
+        file << "AUDIO_RATE=" << AUDIO_RATE << "\n";
+        file << "AUDIO_CHANNELS=" << AUDIO_CHANNELS << "\n";
+        file << "AUDIO_BUFFER=" << AUDIO_BUFFER << "\n";
+        file << "AUDIO_MIN_BUFFER=" << AUDIO_MIN_BUFFER << "\n";
+        file << "AUDIO_BUFFER_STREAK=" << AUDIO_BUFFER_STREAK << "\n";
         file << "START_UP_OPTION=" << START_UP_OPTION << "\n";
         file << "FOLDER_NOTES_MIN=" << FOLDER_NOTES_MIN << "\n";
         file << "FOLDER_NOTES_MAX=" << FOLDER_NOTES_MAX << "\n";
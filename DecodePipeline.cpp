@@ -0,0 +1,107 @@
+#include "DecodePipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+// 空/満杯のキューを待つ間隔。ロード中だけのポーリングなので条件変数は使わない
+static void backoff() {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+int DecodePipeline::defaultWorkers() {
+    int hw = (int)std::thread::hardware_concurrency();
+    if (hw <= 0) hw = 2;
+    return std::clamp(hw - 1, 1, MAX_WORKERS);
+}
+
+void DecodePipeline::start(uint32_t count, int workerCount, FetchFn fetch, DecodeFn decode,
+                           DiscardFn discard) {
+    cancel();
+    fetchFn   = std::move(fetch);
+    decodeFn  = std::move(decode);
+    discardFn = std::move(discard);
+    jobCount  = count;
+    drained   = 0;
+    ioDone.store(false);
+    cancelled.store(false);
+    if (count == 0) return;
+
+    if (workerCount <= 0) workerCount = defaultWorkers();
+    workerCount = std::clamp(workerCount, 1, std::min<int>(MAX_WORKERS, (int)count));
+    for (int i = 0; i < workerCount; ++i) workers.push_back(std::make_unique<Worker>());
+    for (auto& w : workers) {
+        Worker* wp = w.get();
+        wp->thread = std::thread([this, wp] { workerLoop(*wp); });
+    }
+    ioThread = std::thread(&DecodePipeline::ioLoop, this);
+}
+
+void DecodePipeline::ioLoop() {
+    size_t next = 0; // ラウンドロビンの開始位置
+    for (uint32_t job = 0; job < jobCount; ++job) {
+        if (cancelled.load(std::memory_order_relaxed)) break;
+
+        Input in{job, Blob(), false};
+        in.ok = fetchFn(job, in.blob);
+
+        // 空きのあるワーカーへ。全員埋まっていればデコードが追いつくまで読み込みを止める
+        bool pushed = false;
+        while (!pushed) {
+            for (size_t k = 0; k < workers.size() && !pushed; ++k) {
+                pushed = workers[(next + k) % workers.size()]->input.push(in);
+                if (pushed) next = (next + k + 1) % workers.size();
+            }
+            if (pushed) break;
+            if (cancelled.load(std::memory_order_relaxed)) {
+                std::free(in.blob.owned);
+                break;
+            }
+            backoff();
+        }
+    }
+    ioDone.store(true, std::memory_order_release);
+}
+
+void DecodePipeline::workerLoop(Worker& w) {
+    Input in;
+    for (;;) {
+        if (!w.input.pop(in)) {
+            // ioDone を見てから空を確かめる (逆だと最後の1件を取りこぼす)
+            if (ioDone.load(std::memory_order_acquire) && w.input.empty()) break;
+            backoff();
+            continue;
+        }
+
+        void* value = nullptr;
+        if (in.ok && in.blob.data && !cancelled.load(std::memory_order_relaxed))
+            value = decodeFn(in.job, in.blob.data, in.blob.size);
+        std::free(in.blob.owned);
+
+        while (!w.completed.push(Result{in.job, value})) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                if (value && discardFn) discardFn(value);
+                break;
+            }
+            backoff();
+        }
+    }
+}
+
+void DecodePipeline::join() {
+    if (ioThread.joinable()) ioThread.join();
+    for (auto& w : workers)
+        if (w->thread.joinable()) w->thread.join();
+}
+
+void DecodePipeline::cancel() {
+    if (workers.empty() && !ioThread.joinable()) return;
+    cancelled.store(true);
+    join();
+
+    Result r;
+    for (auto& w : workers) {
+        while (w->completed.pop(r))
+            if (r.value && discardFn) discardFn(r.value);
+    }
+    workers.clear();
+}
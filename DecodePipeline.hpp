@@ -0,0 +1,125 @@
+#ifndef DECODEPIPELINE_HPP
+#define DECODEPIPELINE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "SpscQueue.hpp"
+
+// ============================================================
+//  DecodePipeline — キー音ロード用の I/O 1本 + デコード N 本のパイプライン
+//
+//  【旧実装の問題点】
+//    ロードは1スレッドで「読む → デコード → 次を読む」を繰り返していた。
+//    OGG / FLAC のデコードは CPU 律速なのに 1 コアしか使わず、その間 SD は遊び、
+//    逆に SD を待つ間は CPU が遊んでいた。
+//
+//  【構成】
+//    I/O スレッド (1本)  : 呼び出し側が決めた順 (= ファイル・オフセット順) に fetch() で
+//                          バイト列を用意し、空いているワーカーの入力キューへ渡す。
+//                          SD へのアクセスはこのスレッドだけなので、読み込みは順次のまま。
+//    ワーカー (N 本)     : decode() を呼び、結果を自分専用の完了キューへ積む。
+//    消費側 (1 スレッド) : drain() で全ワーカーの完了キューを回収する。
+//                          キャッシュ登録・進捗表示はここで行うので、結果の受け渡しに
+//                          ロックは要らない。
+//  キューはすべて SpscQueue (各ワーカーの入力: I/O → ワーカー、完了: ワーカー → 消費側)。
+//  入力キューが埋まると I/O スレッドが待つので、先読みしたバイト列は
+//  「ワーカー数 × INPUT_DEPTH」個までに抑えられる。
+//
+//  SDL に依存しないため tools/ のベンチマークからもそのまま使える。
+//  結果は void* (SoundManager では Mix_Chunk*)。nullptr は「失敗」として届く。
+// ============================================================
+class DecodePipeline {
+public:
+    static constexpr size_t INPUT_DEPTH    = 4;  // ワーカーごとの先読み数
+    static constexpr size_t COMPLETE_DEPTH = 64; // ワーカーごとの未回収の完了数
+    static constexpr int    MAX_WORKERS    = 8;
+
+    // fetch() が用意するバイト列。owned を立てると decode() の後に std::free する
+    // (マップ上を直接指す場合は owned = nullptr)
+    struct Blob {
+        const uint8_t* data  = nullptr;
+        uint32_t       size  = 0;
+        uint8_t*       owned = nullptr;
+    };
+
+    // I/O スレッドで呼ばれる。失敗なら false (その job は nullptr で完了する)
+    using FetchFn   = std::function<bool(uint32_t job, Blob& out)>;
+    // ワーカーで呼ばれる (複数スレッドから同時に)
+    using DecodeFn  = std::function<void*(uint32_t job, const uint8_t* data, uint32_t size)>;
+    // cancel() で回収されなかった結果の後始末
+    using DiscardFn = std::function<void(void* result)>;
+
+    DecodePipeline() = default;
+    ~DecodePipeline() { cancel(); }
+    DecodePipeline(const DecodePipeline&) = delete;
+    DecodePipeline& operator=(const DecodePipeline&) = delete;
+
+    // job 0 .. jobCount-1 を番号順に fetch する。workers <= 0 なら defaultWorkers()
+    void start(uint32_t jobCount, int workers, FetchFn fetch, DecodeFn decode, DiscardFn discard);
+
+    // 完了した分を fn(job, result) で受け取る。start() を呼んだのとは別のスレッドでもよいが、
+    // 同時に drain() するのは 1 スレッドだけにすること。戻り値 = 今回受け取った数
+    template <typename F>
+    size_t drain(F&& fn) {
+        size_t n = 0;
+        Result r;
+        for (auto& w : workers) {
+            while (w->completed.pop(r)) {
+                fn(r.job, r.value);
+                n++;
+            }
+        }
+        drained += (uint32_t)n;
+        return n;
+    }
+
+    // 全 job を drain し終えたか
+    bool finished() const { return drained >= jobCount; }
+    uint32_t drainedCount() const { return drained; }
+    uint32_t getJobCount() const { return jobCount; }
+    int workerCount() const { return (int)workers.size(); }
+
+    // 残りを捨ててスレッドを止める。未回収の結果は discard へ渡す
+    void cancel();
+    // 全 job の完了を待たずにスレッドだけ回収する (finished() の後に呼ぶ)
+    void join();
+
+    // CPU コア数 - 1 (I/O スレッドと消費側の分)、1〜MAX_WORKERS
+    static int defaultWorkers();
+
+private:
+    struct Input {
+        uint32_t job;
+        Blob     blob;
+        bool     ok;
+    };
+    struct Result {
+        uint32_t job;
+        void*    value;
+    };
+    struct Worker {
+        SpscQueue<Input, INPUT_DEPTH>     input;
+        SpscQueue<Result, COMPLETE_DEPTH> completed;
+        std::thread thread;
+    };
+
+    void ioLoop();
+    void workerLoop(Worker& w);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::thread       ioThread;
+    FetchFn           fetchFn;
+    DecodeFn          decodeFn;
+    DiscardFn         discardFn;
+    uint32_t          jobCount = 0;
+    uint32_t          drained  = 0; // 消費側のみ
+    std::atomic<bool> ioDone{false};
+    std::atomic<bool> cancelled{false};
+};
+
+#endif // DECODEPIPELINE_HPP
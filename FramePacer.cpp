@@ -0,0 +1,81 @@
+#include "FramePacer.hpp"
+#include <algorithm>
+#include <cmath>
+
+// EMA 係数: interval は安定しているのでゆっくり、コストと誤差は速めに追従させる
+static constexpr double INTERVAL_ALPHA = 0.05;
+static constexpr double COST_ALPHA     = 0.10;
+static constexpr double ERROR_ALPHA    = 0.10;
+
+// これを外れる Present 間隔はロード・FC 演出などによる停止とみなして学習に使わない
+static constexpr double MIN_SANE_INTERVAL_MS = 4.0;
+static constexpr double MAX_SANE_INTERVAL_MS = 100.0;
+
+void FramePacer::reset() {
+    perfFreq          = SDL_GetPerformanceFrequency();
+    if (perfFreq == 0) perfFreq = 1;
+    frameStartTick    = 0;
+    submitTick        = 0;
+    lastPresentTick   = 0;
+    inFrame           = false;
+    presentIntervalMs = 1000.0 / 60.0;
+    renderCostMs      = 0.0;
+    predictedLatencyMs = 0.0;
+    errorMs           = 0.0;
+    errorAbsMs        = 0.0;
+    presentedFrames   = 0;
+}
+
+double FramePacer::beginFrame() {
+    frameStartTick = SDL_GetPerformanceCounter();
+    submitTick     = 0;
+    inFrame        = true;
+
+    // まだ vsync 位相が分からない間は補正しない
+    if (lastPresentTick == 0) {
+        predictedLatencyMs = 0.0;
+        return predictedLatencyMs;
+    }
+
+    // 描画が終わる見込み時刻以降で最初に来る vsync を求める
+    double sinceVsyncMs = ticksToMs(frameStartTick - lastPresentTick);
+    double readyMs      = sinceVsyncMs + renderCostMs;
+    double k            = std::max(1.0, std::ceil(readyMs / presentIntervalMs));
+    double latency      = k * presentIntervalMs - sinceVsyncMs;
+
+    predictedLatencyMs = std::clamp(latency, 0.0, presentIntervalMs * 3.0);
+    return predictedLatencyMs;
+}
+
+void FramePacer::markSubmit() {
+    if (inFrame) submitTick = SDL_GetPerformanceCounter();
+}
+
+void FramePacer::markPresented() {
+    uint64_t now = SDL_GetPerformanceCounter();
+
+    if (lastPresentTick != 0) {
+        double interval = ticksToMs(now - lastPresentTick);
+        if (interval >= MIN_SANE_INTERVAL_MS && interval <= MAX_SANE_INTERVAL_MS) {
+            presentIntervalMs += (interval - presentIntervalMs) * INTERVAL_ALPHA;
+        }
+    }
+
+    if (inFrame) {
+        if (submitTick != 0) {
+            double cost = ticksToMs(submitTick - frameStartTick);
+            renderCostMs += (cost - renderCostMs) * COST_ALPHA;
+        }
+        // 予測が有効だったフレームのみ誤差を集計する
+        if (lastPresentTick != 0) {
+            double actual = ticksToMs(now - frameStartTick);
+            double err    = actual - predictedLatencyMs;
+            errorMs    += (err - errorMs) * ERROR_ALPHA;
+            errorAbsMs += (std::abs(err) - errorAbsMs) * ERROR_ALPHA;
+        }
+        presentedFrames++;
+    }
+
+    lastPresentTick = now;
+    inFrame         = false;
+}
@@ -0,0 +1,63 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+
+// ============================================================
+//  FramePacer — 表示時刻予測モデル
+//
+//  【問題】
+//    renderScene は cur_ms (フレーム開始時にサンプリングした時刻) でノーツを
+//    配置していたが、その絵が実際に画面に出るのは入力処理・更新・描画・
+//    vsync 待ちを経た 1 フレーム以上後。ノーツは常に「可変量だけ遅れて」見える。
+//
+//  【モデル】
+//    - presentInterval : SDL_RenderPresent が返る間隔の EMA (= vsync 周期)
+//    - renderCost      : フレーム開始 → Present 呼び出し直前までの時間の EMA
+//    - lastPresentTick : 直前の Present が返った時刻 (= vsync 位相の基準点)
+//
+//    予測表示時刻 = 「フレーム開始 + renderCost 以降で最初に来る vsync」
+//    Present が返った瞬間を実表示時刻とみなし、予測との差を誤差として記録する。
+//
+//  時刻はすべて SDL_GetPerformanceCounter ベースで扱い、
+//  ゲーム時計 (SDL_GetTicks の ms) へはオフセットとして加算するだけにする。
+// ============================================================
+class FramePacer {
+public:
+    void reset();
+
+    // フレーム開始時に呼ぶ。戻り値 = 予測表示時刻までの遅延 (ms)
+    double beginFrame();
+    // SDL_RenderPresent の直前に呼ぶ (描画コスト計測用)
+    void markSubmit();
+    // SDL_RenderPresent が返った直後に呼ぶ
+    void markPresented();
+
+    double getPredictedLatencyMs()  const { return predictedLatencyMs; }
+    double getPresentIntervalMs()   const { return presentIntervalMs; }
+    double getRenderCostMs()        const { return renderCostMs; }
+    // 予測 − 実測 の誤差 (符号付き EMA: 正 = 実際の表示が予測より遅い)
+    double getPredictionErrorMs()   const { return errorMs; }
+    // 誤差の絶対値 EMA (ばらつきの目安)
+    double getPredictionJitterMs()  const { return errorAbsMs; }
+    uint32_t getFrameCount()        const { return presentedFrames; }
+
+private:
+    double ticksToMs(uint64_t ticks) const { return (double)ticks * 1000.0 / (double)perfFreq; }
+
+    uint64_t perfFreq         = 1;
+    uint64_t frameStartTick   = 0;
+    uint64_t submitTick       = 0;
+    uint64_t lastPresentTick  = 0;
+    bool     inFrame          = false;
+
+    double presentIntervalMs  = 1000.0 / 60.0;
+    double renderCostMs       = 0.0;
+    double predictedLatencyMs = 0.0;
+    double errorMs            = 0.0;
+    double errorAbsMs         = 0.0;
+    uint32_t presentedFrames  = 0;
+};
+
+#endif // FRAMEPACER_HPP
@@ -0,0 +1,109 @@
+#include "LatencyProbe.hpp"
+#include <algorithm>
+#include <fstream>
+
+void LatencyProbe::reset() {
+    // 公開済みの id を先に無効にしてから時刻を消す (オーディオスレッドが古い id で書かないように)
+    for (Record& r : ring) r.id.store(0, std::memory_order_release);
+    for (Record& r : ring) {
+        for (auto& x : r.t) x.store(0, std::memory_order_relaxed);
+    }
+    nextId  = 1;
+    oldest  = 1;
+    current = 0;
+    samples.clear();
+    version++;
+}
+
+uint32_t LatencyProbe::beginHit(int lane, int64_t inputAgeNs) {
+    if (!enabled) return 0;
+    if (samples.capacity() == 0) samples.reserve(4096);
+
+    uint32_t id = nextId++;
+    if (nextId == 0) nextId = 1;
+    // リングが一周した: 一番古い未確定の記録は待たずに確定する
+    while (oldest != id && id - oldest >= RING) {
+        finalize(ring[oldest % RING], oldest);
+        oldest++;
+    }
+
+    Record& r = ring[id % RING];
+    r.id.store(0, std::memory_order_release);
+    const int64_t now = nowNs();
+    r.t[INPUT].store(now - std::max<int64_t>(0, inputAgeNs), std::memory_order_relaxed);
+    for (int s = HIT; s < STAGES; s++) r.t[s].store(0, std::memory_order_relaxed);
+    r.lane = lane;
+    r.id.store(id, std::memory_order_release);
+    current = id;
+    return id;
+}
+
+void LatencyProbe::markPresented() {
+    if (!enabled) return;
+    const int64_t now = nowNs();
+    for (uint32_t id = oldest; id != nextId; id++) {
+        if (id == 0) continue;
+        Record& r = ring[id % RING];
+        int64_t expected = 0;
+        r.t[PRESENT].compare_exchange_strong(expected, now, std::memory_order_relaxed);
+    }
+    // 古い順に、MIX が届いたか (音を積まなかった打鍵は待たない)、待ちきれなくなったものを確定する
+    while (oldest != nextId) {
+        if (oldest == 0) { oldest++; continue; }
+        Record& r = ring[oldest % RING];
+        const bool mixed   = r.t[MIX].load(std::memory_order_relaxed) != 0;
+        const bool silent  = r.t[PLAY].load(std::memory_order_relaxed) == 0; // play() は打鍵の処理中に呼ばれる
+        const bool expired = now - r.t[INPUT].load(std::memory_order_relaxed) > MIX_TIMEOUT_MS * 1000000;
+        if (!mixed && !silent && !expired) break;
+        finalize(r, oldest);
+        oldest++;
+    }
+}
+
+void LatencyProbe::finalize(Record& r, uint32_t id) {
+    Sample s;
+    s.id   = id;
+    s.lane = r.lane;
+    const int64_t t0 = r.t[INPUT].load(std::memory_order_relaxed);
+    for (int k = 0; k < STAGES; k++) {
+        int64_t t = r.t[k].load(std::memory_order_relaxed);
+        s.us[k] = t ? (t - t0) / 1000 : -1;
+    }
+    r.id.store(0, std::memory_order_release); // 以降の MIX は捨てる
+    samples.push_back(s);
+    version++;
+}
+
+LatencyProbe::Percentiles LatencyProbe::percentiles(Stage to) const {
+    if (cachedVersion[to] == version) return cached[to];
+    cachedVersion[to] = version;
+    Percentiles& p = cached[to];
+    p = Percentiles();
+    std::vector<int64_t>& v = scratch;
+    v.clear();
+    v.reserve(WINDOW);
+    size_t from = samples.size() > WINDOW ? samples.size() - WINDOW : 0;
+    for (size_t i = from; i < samples.size(); i++) {
+        if (samples[i].us[to] >= 0) v.push_back(samples[i].us[to]);
+    }
+    if (v.empty()) return p;
+    std::sort(v.begin(), v.end());
+    auto at = [&](double q) { return v[std::min(v.size() - 1, (size_t)(q * (double)(v.size() - 1) + 0.5))] / 1000.0; };
+    p.p50   = at(0.50);
+    p.p95   = at(0.95);
+    p.p99   = at(0.99);
+    p.count = (uint32_t)v.size();
+    return p;
+}
+
+bool LatencyProbe::writeCsv(const std::string& path) const {
+    std::ofstream ofs(path);
+    if (!ofs) return false;
+    ofs << "id,lane,input_us,hit_us,play_us,mix_us,present_us\n";
+    for (const Sample& s : samples) {
+        ofs << s.id << "," << s.lane;
+        for (int k = 0; k < STAGES; k++) ofs << "," << s.us[k];
+        ofs << "\n";
+    }
+    return (bool)ofs;
+}
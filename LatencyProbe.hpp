@@ -0,0 +1,116 @@
+#ifndef LATENCYPROBE_HPP
+#define LATENCYPROBE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// ============================================================
+//  LatencyProbe — 打鍵から音・画面までの遅延の実測
+//
+//  【目的】
+//    表示時刻予測 (FramePacer) もミキサーのスケジューリングも「見積もり」しか
+//    持っておらず、ボタンを押してから音が出る・判定が見えるまでに実際どこで
+//    どれだけ掛かっているかを確かめる手段が無かった。
+//
+//  【段階】 (時刻はすべて steady_clock の ns)
+//    INPUT   : 入力イベントが SDL のキューに入った時刻 (イベントの timestamp から逆算。ms 精度)
+//    HIT     : processHit を呼ぶ直前
+//    PLAY    : SoundManager::play がミキサーのキューに積んだ直後
+//    MIX     : そのボイスを初めて混ぜたオーディオコールバックの開始 (オーディオスレッド)
+//    PRESENT : その打鍵の結果を含むフレームの SDL_RenderPresent が返った直後
+//
+//  【構成】
+//    記録は RING 個の固定スロットのリング (id % RING)。メインスレッドが beginHit() で
+//    スロットを初期化して id を公開し、オーディオスレッドは id が一致する時だけ MIX を
+//    書く (ロック・確保なし)。PRESENT が付き、MIX が付くか MIX_TIMEOUT_MS を過ぎた記録から
+//    順に確定し、百分位数 (オーバーレイ) と CSV の行になる。
+//    キー音の無い打鍵 (空 POOR など) は MIX = 0 のまま確定する。
+//
+//  SDL に依存しない (入力時刻の逆算は呼び出し側で行う)。
+// ============================================================
+class LatencyProbe {
+public:
+    enum Stage : int { INPUT = 0, HIT, PLAY, MIX, PRESENT, STAGES };
+    static constexpr uint32_t RING           = 256;
+    static constexpr uint32_t WINDOW         = 512; // 百分位数を取る直近の確定数
+    static constexpr int64_t  MIX_TIMEOUT_MS = 500;
+
+    // 確定した1打鍵 (INPUT からの経過 us。届かなかった段階は -1)
+    struct Sample {
+        uint32_t id   = 0;
+        int      lane = 0;
+        int64_t  us[STAGES] = {0, -1, -1, -1, -1};
+    };
+    struct Percentiles {
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0; // ms
+        uint32_t count = 0;
+    };
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setEnabled(bool v) { enabled = v; }
+    bool isEnabled() const  { return enabled; }
+    // 曲の開始時に呼ぶ (確定済みの記録も捨てる。オーディオスレッドが動いていてもよい)
+    void reset();
+
+    // --- メインスレッド ---
+    // 打鍵1回分の記録を始める。inputAgeNs = 入力イベントが届いてから今までの時間。
+    // 無効なら 0 (以降の呼び出しは何もしない)
+    uint32_t beginHit(int lane, int64_t inputAgeNs);
+    void     endHit() { current = 0; }
+    // 今処理中の打鍵 (SoundManager::play が MIX を結び付けるのに使う)
+    uint32_t currentHit() const { return current; }
+    void     mark(uint32_t id, Stage s) { if (id) markAt(id, s, nowNs()); }
+    // Present が返った直後: 未確定の打鍵に PRESENT を付け、確定できるものを確定する
+    void     markPresented();
+
+    // --- オーディオスレッド ---
+    void markMix(uint32_t id, int64_t ns) { if (id) markAt(id, MIX, ns); }
+
+    // --- 結果 (メインスレッド) ---
+    // INPUT → to の百分位数 (直近 WINDOW 打鍵。to に届かなかった打鍵は数えない)
+    // ★HUD から毎フレーム呼ばれるので、確定が増えるまでは前回の結果を返す (並べ替え・確保なし)
+    Percentiles percentiles(Stage to) const;
+    const std::vector<Sample>& getSamples() const { return samples; }
+    // 確定済みの全打鍵を CSV に書く
+    bool writeCsv(const std::string& path) const;
+
+private:
+    struct Record {
+        std::atomic<uint32_t> id{0};
+        int                   lane = 0; // メインスレッドのみ
+        std::atomic<int64_t>  t[STAGES];
+        Record() { for (auto& x : t) x.store(0, std::memory_order_relaxed); }
+    };
+
+    // 最初の1回だけ書く (同じ打鍵で複数の音を鳴らしても最初の音で測る)
+    void markAt(uint32_t id, Stage s, int64_t ns) {
+        Record& r = ring[id % RING];
+        if (r.id.load(std::memory_order_acquire) != id) return; // 上書き済みのスロット
+        int64_t expected = 0;
+        r.t[s].compare_exchange_strong(expected, ns, std::memory_order_relaxed);
+    }
+    void finalize(Record& r, uint32_t id);
+
+    bool     enabled   = false;
+    Record   ring[RING];
+    uint32_t nextId    = 1;   // 0 は「記録なし」
+    uint32_t oldest    = 1;   // 未確定の最古の id
+    uint32_t current   = 0;
+
+    std::vector<Sample> samples; // 確定順。曲の間だけ溜める
+    uint64_t            version = 1; // 確定・reset のたびに進める
+
+    // percentiles() のキャッシュ (メインスレッドのみ)
+    mutable Percentiles          cached[STAGES];
+    mutable uint64_t             cachedVersion[STAGES] = {};
+    mutable std::vector<int64_t> scratch;
+};
+
+#endif // LATENCYPROBE_HPP
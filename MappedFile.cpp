@@ -0,0 +1,131 @@
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef __SWITCH__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_USE_MMAP 1
+#endif
+
+#if MAPPEDFILE_USE_MMAP
+static uint64_t pageSize() {
+    static const uint64_t ps = (uint64_t)sysconf(_SC_PAGESIZE);
+    return ps ? ps : 4096;
+}
+#endif
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#if MAPPEDFILE_USE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // マッピングはファイル記述子を閉じても残る
+    if (p == MAP_FAILED) return false;
+
+    mapped   = static_cast<uint8_t*>(p);
+    fileSize = (uint64_t)st.st_size;
+#else
+    fp = std::fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    // SD のシーク回数を減らすため、標準の 4KB より大きいバッファで読む
+    std::setvbuf(fp, nullptr, _IOFBF, 64 * 1024);
+    if (std::fseek(fp, 0, SEEK_END) != 0) {
+        std::fclose(fp);
+        fp = nullptr;
+        return false;
+    }
+    long end = std::ftell(fp);
+    if (end <= 0) {
+        std::fclose(fp);
+        fp = nullptr;
+        return false;
+    }
+    fileSize = (uint64_t)end;
+#endif
+
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+#if MAPPEDFILE_USE_MMAP
+    if (mapped) munmap(mapped, (size_t)fileSize);
+#endif
+    mapped = nullptr;
+
+    if (fp) std::fclose(fp);
+    fp = nullptr;
+    std::free(staging);
+    staging         = nullptr;
+    stagingCapacity = 0;
+
+    fileSize = 0;
+    opened   = false;
+}
+
+const uint8_t* MappedFile::view(uint64_t offset, uint32_t len) {
+    if (!opened || offset > fileSize || len > fileSize - offset) return nullptr;
+    if (mapped) return mapped + offset;
+
+    // フォールバック: 必要な時だけバッファを伸ばし、以降は使い回す
+    if (len > stagingCapacity) {
+        uint8_t* grown = static_cast<uint8_t*>(std::realloc(staging, len));
+        if (!grown) return nullptr;
+        staging         = grown;
+        stagingCapacity = len;
+    }
+    if (std::fseek(fp, (long)offset, SEEK_SET) != 0) return nullptr;
+    if (std::fread(staging, 1, len, fp) != len) return nullptr;
+    return staging;
+}
+
+void MappedFile::prefault(uint64_t offset, uint64_t len) {
+#if MAPPEDFILE_USE_MMAP
+    if (!mapped || offset >= fileSize) return;
+    if (len > fileSize - offset) len = fileSize - offset;
+    // madvise はページ境界から始める必要がある
+    uint64_t begin = offset & ~(pageSize() - 1);
+    madvise(mapped + begin, (size_t)(offset + len - begin), MADV_WILLNEED);
+#else
+    (void)offset;
+    (void)len;
+#endif
+}
+
+void MappedFile::fault(uint64_t offset, uint64_t len) {
+#if MAPPEDFILE_USE_MMAP
+    if (!mapped || offset >= fileSize) return;
+    if (len > fileSize - offset) len = fileSize - offset;
+    prefault(offset, len);
+    // 1ページ1バイトずつ触る。volatile で読み飛ばしを防ぐ
+    const uint64_t ps = pageSize();
+    volatile uint8_t sink = 0;
+    for (uint64_t p = offset & ~(ps - 1); p < offset + len; p += ps)
+        sink = sink + mapped[std::max(p, offset)];
+    (void)sink;
+#else
+    (void)offset;
+    (void)len;
+#endif
+}
+
+bool MappedFile::read(uint64_t offset, uint32_t len, uint8_t* dst) {
+    if (!opened || offset > fileSize || len > fileSize - offset) return false;
+    if (mapped) {
+        std::memcpy(dst, mapped + offset, len);
+        return true;
+    }
+    if (std::fseek(fp, (long)offset, SEEK_SET) != 0) return false;
+    return std::fread(dst, 1, len, fp) == len;
+}
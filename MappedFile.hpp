@@ -0,0 +1,67 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// ============================================================
+//  MappedFile — .boxwav パートの読み取り専用ビュー
+//
+//  旧実装はエントリごとに ifstream を seek → SDL_malloc した一時バッファへ read →
+//  SDL_RWFromMem でデコードしていた (loadSingleSound はさらに毎回ファイルを開き直す)。
+//  パートを一度だけ開き、エントリのバイト列をその場で指すポインタを返す。
+//
+//  - POSIX (Linux/macOS のツール・デバッグビルド): mmap。view() はコピーなし
+//  - Switch: newlib に mmap が無いため、開いたままの FILE* から、使い回す
+//    1本のステージングバッファへ読む。エントリごとの malloc/free と再オープンは無くなる
+//
+//  view() の戻り値は次の view() / close() まで有効。フォールバック版はバッファを
+//  共有するので、同じインスタンスを複数スレッドから同時に使わないこと。
+//  (mmap 版の view() はポインタを返すだけなので、どのスレッドから使ってもよい)
+// ============================================================
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool     isOpen()     const { return opened; }
+    uint64_t size()       const { return fileSize; }
+    bool     isZeroCopy() const { return mapped != nullptr; }
+
+    // [offset, offset + len) のバイト列。範囲外・読み込み失敗時は nullptr
+    const uint8_t* view(uint64_t offset, uint32_t len);
+
+    // これから読む範囲をページインしておく (mmap 版のみ。フォールバック版は何もしない)
+    void prefault(uint64_t offset, uint64_t len);
+
+    // 【追加】範囲のページを今ここで読み込ませる (mmap 版のみ)。DecodePipeline の
+    //        I/O スレッドで呼び、デコードするワーカーがページフォルトで SD を待たないようにする
+    void fault(uint64_t offset, uint64_t len);
+
+    // 【追加】[offset, offset + len) を dst へ読む。ステージングバッファを経由しないので、
+    //        別スレッドへ渡すバイト列を作るのに使う
+    bool read(uint64_t offset, uint32_t len, uint8_t* dst);
+
+    // フォールバック版のステージングバッファの最大サイズ (ピークメモリの報告用)
+    uint64_t getStagingPeak() const { return stagingCapacity; }
+
+private:
+    bool     opened   = false;
+    uint64_t fileSize = 0;
+
+    // mmap 版
+    uint8_t* mapped = nullptr;
+
+    // フォールバック版
+    FILE*    fp              = nullptr;
+    uint8_t* staging         = nullptr;
+    uint64_t stagingCapacity = 0;
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,216 @@
+#include "Nv12Converter.hpp"
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define NV12_USE_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NV12_USE_SSE2 1
+// AVX2 はコンパイラのターゲットに関係なく関数単位で有効にし、実行時に CPU を見て選ぶ
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NV12_USE_AVX2 1
+#define NV12_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// ============================================================
+//  行カーネル
+//    interleave: dst[2i] = u[i], dst[2i+1] = v[i]   (n ペア)
+//    copy      : dst[i]  = src[i]                    (n バイト)
+//  SIMD 版は 16 / 32 ペア (バイト) 単位で処理し、端数はスカラーで片付ける。
+//  ロード・ストアはすべて非アライン (FFmpeg の linesize もテクスチャの pitch も揃う保証は無い)。
+// ============================================================
+
+static void interleaveScalar(const uint8_t* u, const uint8_t* v, uint8_t* dst, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[2 * i]     = u[i];
+        dst[2 * i + 1] = v[i];
+    }
+}
+
+static void copyScalar(const uint8_t* src, uint8_t* dst, size_t n) {
+    memcpy(dst, src, n);
+}
+
+#if defined(NV12_USE_NEON)
+static void interleaveNeon(const uint8_t* u, const uint8_t* v, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t uv;
+        uv.val[0] = vld1q_u8(u + i);
+        uv.val[1] = vld1q_u8(v + i);
+        vst2q_u8(dst + 2 * i, uv); // st2 がそのまま交互に並べて書く
+    }
+    interleaveScalar(u + i, v + i, dst + 2 * i, n - i);
+}
+
+static void copyNeon(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint8x16_t a = vld1q_u8(src + i);
+        uint8x16_t b = vld1q_u8(src + i + 16);
+        uint8x16_t c = vld1q_u8(src + i + 32);
+        uint8x16_t d = vld1q_u8(src + i + 48);
+        vst1q_u8(dst + i,      a);
+        vst1q_u8(dst + i + 16, b);
+        vst1q_u8(dst + i + 32, c);
+        vst1q_u8(dst + i + 48, d);
+    }
+    for (; i + 16 <= n; i += 16) vst1q_u8(dst + i, vld1q_u8(src + i));
+    copyScalar(src + i, dst + i, n - i);
+}
+#endif
+
+#if defined(NV12_USE_SSE2)
+static void interleaveSse2(const uint8_t* u, const uint8_t* v, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i vu = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i));
+        __m128i vv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i),      _mm_unpacklo_epi8(vu, vv));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 16), _mm_unpackhi_epi8(vu, vv));
+    }
+    interleaveScalar(u + i, v + i, dst + 2 * i, n - i);
+}
+
+static void copySse2(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),      a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+    }
+    for (; i + 16 <= n; i += 16)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    copyScalar(src + i, dst + i, n - i);
+}
+#endif
+
+#if defined(NV12_USE_AVX2)
+// unpacklo/hi は 128bit レーンごとに働くので、結果は [0-7|16-23] と [8-15|24-31]。
+// permute2x128 でレーンを入れ替えて順番どおりにする
+NV12_TARGET_AVX2 static void interleaveAvx2(const uint8_t* u, const uint8_t* v, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i vu = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + i));
+        __m256i vv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+        __m256i lo = _mm256_unpacklo_epi8(vu, vv);
+        __m256i hi = _mm256_unpackhi_epi8(vu, vv);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * i),      _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleaveSse2(u + i, v + i, dst + 2 * i, n - i);
+}
+#endif
+
+// ============================================================
+//  カーネルの選択 (起動時に1回)
+// ============================================================
+
+struct KernelSet {
+    void (*interleave)(const uint8_t*, const uint8_t*, uint8_t*, size_t);
+    void (*copy)(const uint8_t*, uint8_t*, size_t);
+};
+
+static KernelSet kernelSet(Nv12Converter::Kernel k) {
+    switch (k) {
+#if defined(NV12_USE_NEON)
+    case Nv12Converter::KERNEL_NEON: return {interleaveNeon, copyNeon};
+#endif
+#if defined(NV12_USE_SSE2)
+    case Nv12Converter::KERNEL_SSE2: return {interleaveSse2, copySse2};
+#endif
+#if defined(NV12_USE_AVX2)
+    // 256bit のコピーは SSE2 版より遅かった (tools/nv12_bench)。コピーは SSE2 版を使う
+    case Nv12Converter::KERNEL_AVX2: return {interleaveAvx2, copySse2};
+#endif
+    default: return {interleaveScalar, copyScalar};
+    }
+}
+
+static Nv12Converter::Kernel bestKernel() {
+#if defined(NV12_USE_NEON)
+    return Nv12Converter::KERNEL_NEON;
+#elif defined(NV12_USE_AVX2)
+    __builtin_cpu_init(); // 静的初期化から呼ぶので、CPU 情報の初期化を待たない
+    return __builtin_cpu_supports("avx2") ? Nv12Converter::KERNEL_AVX2 : Nv12Converter::KERNEL_SSE2;
+#elif defined(NV12_USE_SSE2)
+    return Nv12Converter::KERNEL_SSE2;
+#else
+    return Nv12Converter::KERNEL_SCALAR;
+#endif
+}
+
+static Nv12Converter::Kernel activeKernel = bestKernel();
+static KernelSet             active       = kernelSet(activeKernel);
+
+bool Nv12Converter::isSupported(Kernel k) {
+    switch (k) {
+    case KERNEL_SCALAR: return true;
+#if defined(NV12_USE_NEON)
+    case KERNEL_NEON:   return true;
+#endif
+#if defined(NV12_USE_SSE2)
+    case KERNEL_SSE2:   return true;
+#endif
+#if defined(NV12_USE_AVX2)
+    case KERNEL_AVX2:   return __builtin_cpu_supports("avx2");
+#endif
+    default:            return false;
+    }
+}
+
+bool Nv12Converter::setKernel(Kernel k) {
+    if (!isSupported(k)) return false;
+    activeKernel = k;
+    active       = kernelSet(k);
+    return true;
+}
+
+Nv12Converter::Kernel Nv12Converter::currentKernel() { return activeKernel; }
+
+const char* Nv12Converter::kernelName(Kernel k) {
+    switch (k) {
+    case KERNEL_SCALAR: return "scalar";
+    case KERNEL_SSE2:   return "SSE2";
+    case KERNEL_AVX2:   return "AVX2";
+    case KERNEL_NEON:   return "NEON";
+    default:            return "?";
+    }
+}
+
+// ============================================================
+//  面単位
+//  全てのストライドが行の幅と一致すれば、面全体を1行として1回の呼び出しで済ませる。
+//  連続したコピーは libc の memcpy (大きいブロック向けの最適化を持つ) に任せ、
+//  SIMD のコピーは pitch 付きの行ごとのコピーにだけ使う
+// ============================================================
+
+void Nv12Converter::interleaveUV(const uint8_t* u, ptrdiff_t uStride, const uint8_t* v, ptrdiff_t vStride,
+                                 uint8_t* dst, ptrdiff_t dstStride, int pairs, int rows) {
+    if (pairs <= 0 || rows <= 0) return;
+    if (uStride == pairs && vStride == pairs && dstStride == 2 * (ptrdiff_t)pairs) {
+        active.interleave(u, v, dst, (size_t)pairs * rows);
+        return;
+    }
+    for (int r = 0; r < rows; r++)
+        active.interleave(u + r * uStride, v + r * vStride, dst + r * dstStride, (size_t)pairs);
+}
+
+void Nv12Converter::copyPlane(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                              int bytes, int rows) {
+    if (bytes <= 0 || rows <= 0) return;
+    if (srcStride == bytes && dstStride == bytes) {
+        memcpy(dst, src, (size_t)bytes * rows);
+        return;
+    }
+    for (int r = 0; r < rows; r++)
+        active.copy(src + r * srcStride, dst + r * dstStride, (size_t)bytes);
+}
@@ -0,0 +1,43 @@
+#ifndef NV12CONVERTER_HPP
+#define NV12CONVERTER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// ============================================================
+//  Nv12Converter — 動画 BGA のフレームを NV12 に詰めるカーネル
+//
+//  デコード側 (videoWorker) はフレームの参照をスロットに移すだけで、変換はすべて
+//  描画側 (BgaManager::render) が、デコーダの面からロックしたテクスチャ (pitch 付き) へ直接行う。
+//    - Y 面 (NV12 で出てくる動画は UV 面も) のコピー
+//    - YUV420P の U / V を NV12 の UV に交互に並べながら書く変換
+//  解像度が上がると UV のインターリーブがプロファイルに出てくるため、
+//  行単位のカーネルを NEON / SSE2 / AVX2 で用意し、スカラー版を予備に残す。
+//
+//  カーネルは起動時に1回だけ選ぶ (aarch64 = NEON、x86 は CPU が AVX2 を持てば AVX2、
+//  無ければ SSE2)。ストライドが行の幅と一致する時は全体を1行として1回で処理する
+//  (連続したコピーは memcpy のままの方が速いので、SIMD のコピーは pitch 付きの行だけ)。
+//
+//  SDL / FFmpeg に依存しないため tools/nv12_bench からそのまま使える。
+// ============================================================
+class Nv12Converter {
+public:
+    enum Kernel : int { KERNEL_SCALAR = 0, KERNEL_SSE2, KERNEL_AVX2, KERNEL_NEON, KERNEL_COUNT };
+
+    // U / V 面 (1行 pairs バイト × rows 行) → NV12 の UV 面 (1行 pairs*2 バイト)
+    static void interleaveUV(const uint8_t* u, ptrdiff_t uStride, const uint8_t* v, ptrdiff_t vStride,
+                             uint8_t* dst, ptrdiff_t dstStride, int pairs, int rows);
+    // 1行 bytes バイト × rows 行の面のコピー (ストライドは別々でよい)
+    static void copyPlane(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride,
+                          int bytes, int rows);
+
+    // この CPU で使えるカーネルか
+    static bool isSupported(Kernel k);
+    // ベンチマーク用: 使うカーネルを切り替える (使えなければ false で何もしない)
+    static bool setKernel(Kernel k);
+    static Kernel currentKernel();
+    static const char* kernelName(Kernel k);
+    static const char* kernelName() { return kernelName(currentKernel()); }
+};
+
+#endif // NV12CONVERTER_HPP
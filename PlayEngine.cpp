@@ -7,6 +7,11 @@
 #include <map>
 #include <set>
 
+// BGM キー音をミキサーへ先行登録する幅 (ms)。
+// 実際の発音はオーディオコールバック内で target_ms ちょうどのサンプルから始まるため、
+// フレーム間隔より十分長ければよい。
+static constexpr double BGM_LOOKAHEAD_MS = 50.0;
+
 // TOTAL値計算 (HappySky仕様)
 int calculateHSRecoveryInternal(int notes) {
     if (notes <= 0) return 0;
@@ -149,6 +154,7 @@ void PlayEngine::init(BMSData& data) {
     status.clearType = ClearType::NO_PLAY;
 
     nextUpdateIndex = 0;
+    bgmPremixed     = false;
     for (int i = 0; i <= 8; i++) lastSoundPerLaneId[i] = 0;
 
     // ★修正②: レーン別インデックスを構築。processHit で全ノーツを O(N) スキャンする代わりに
@@ -192,8 +198,11 @@ void PlayEngine::update(double cur_ms, uint32_t now, SoundManager& snd) {
             lastSoundPerLaneId[n.lane] = n.soundId;
         }
 
-        if (n.isBGM && n.target_ms <= cur_ms) {
-            snd.play(n.soundId);
+        // ★BGM はフレームが target_ms を過ぎるのを待たず、先読みしてスケジュールする。
+        //   「フレームが来た時に鳴らす」方式の 0〜16ms のジッター (フラム) を解消する。
+        if (n.isBGM && n.target_ms <= cur_ms + BGM_LOOKAHEAD_MS) {
+            // ディスクから流す音は事前ミックスに入らないので、その時も個別に鳴らす
+            if (!bgmPremixed || snd.isStreamed(n.soundId)) snd.schedule(n.soundId, n.target_ms, AudioMixer::PRIORITY_BGM);
             n.played = true;
             if (i == nextUpdateIndex) nextUpdateIndex++;
         }
@@ -286,7 +295,7 @@ int PlayEngine::processHit(int lane, double cur_ms, uint32_t now, SoundManager&
         // 判定窓より古いノーツはスキップ（update() で POOR 処理済みのはずだが念のため）
         if (diff > Config::JUDGE_BAD) continue;
 
-        snd.play(n.soundId);
+        snd.play(n.soundId, AudioMixer::PRIORITY_PLAYER, lane);
         lastSoundPerLaneId[lane] = n.soundId;
 
         if (n.isLN) {
@@ -344,7 +353,7 @@ int PlayEngine::processHit(int lane, double cur_ms, uint32_t now, SoundManager&
 
     if (!hitSuccess) {
         if (lane >= 1 && lane <= 8 && lastSoundPerLaneId[lane] != 0) {
-            snd.play(lastSoundPerLaneId[lane]);
+            snd.play(lastSoundPerLaneId[lane], AudioMixer::PRIORITY_PLAYER, lane);
             if (Config::GAUGE_OPTION == 6) { // HAZARD
                 status.gauge     = 0.0;
                 status.isFailed  = true;
@@ -18,6 +18,8 @@ public:
     int processHit(int lane, double cur_ms, uint32_t now, SoundManager& snd);
     void processRelease(int lane, double cur_ms, uint32_t now);
     void forceFail();
+    // BGM が事前ミックス済みトラックで鳴る場合、BGM ノーツのトリガーを止める
+    void setBgmPremixed(bool v) { bgmPremixed = v; }
 
     double getMsFromY(int64_t target_y) const;
     int64_t getYFromMs(double cur_ms) const;
@@ -47,6 +49,7 @@ private:
     double baseRecoveryPerNote = 0.0;
     size_t nextUpdateIndex = 0;
     double lastHistoryUpdateMs = -1000.0;
+    bool   bgmPremixed = false;
 
     // ★修正②: レーン別ノーツインデックス。processHit の O(N) 全スキャンを O(1) に変える。
     //          laneNoteIndices[lane] = notes[] 内でそのレーンに属するインデックスのリスト（target_ms 昇順）
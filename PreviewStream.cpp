@@ -0,0 +1,67 @@
+#include "PreviewStream.hpp"
+#include <algorithm>
+#include <cmath>
+
+static constexpr size_t RING_MASK = PreviewStream::RING_SAMPLES - 1;
+
+void PreviewStream::configure(int sampleRate, int ch, float vol) {
+    channels    = std::max(1, ch);
+    volume      = vol;
+    fadeInStep  = 1000.0f / (float)(std::max(1, sampleRate) * FADE_IN_MS);
+    fadeOutStep = 1000.0f / (float)(std::max(1, sampleRate) * FADE_OUT_MS);
+}
+
+uint32_t PreviewStream::request() {
+    return requestGen.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+size_t PreviewStream::write(uint32_t gen, const int16_t* pcm, size_t samples) {
+    uint64_t cur = rTail.load(std::memory_order_acquire);
+    if (tailGen(cur) != gen || currentGeneration() != gen) return 0;
+    uint32_t tail  = tailIndex(cur);
+    size_t   space = RING_SAMPLES - (uint32_t)(tail - rHead.load(std::memory_order_acquire));
+    size_t   n     = std::min(samples, space);
+    n -= n % (size_t)channels; // フレームを跨いで切らない
+    for (size_t i = 0; i < n; ++i) ring[(tail + i) & RING_MASK] = pcm[i];
+    // ★コピー中にオーディオスレッドが切り替えを済ませていたら公開しない (古い世代の音が次の曲の頭で鳴る)
+    if (!rTail.compare_exchange_strong(cur, packTail(gen, tail + (uint32_t)n),
+                                       std::memory_order_release, std::memory_order_relaxed))
+        return 0;
+    return n;
+}
+
+void PreviewStream::mixInto(int16_t* out, int samples) {
+    const uint32_t want = requestGen.load(std::memory_order_acquire);
+    uint32_t head = rHead.load(std::memory_order_relaxed);
+    uint32_t tail = tailIndex(rTail.load(std::memory_order_acquire));
+    if (want == playingGen && gain == 0.0f && tail == head)
+        return; // 無音 (待機中) は何もしない
+
+    for (int i = 0; i + channels <= samples; i += channels) {
+        if (playingGen != want) {
+            // 切り替え: 絞り切ったら前の世代の残りを捨て、供給スレッドに書き込みを許す。
+            // 世代と破棄位置を tail と一緒に書き換えるので、書きかけの古い世代は公開に失敗する
+            gain -= fadeOutStep;
+            if (gain <= 0.0f) {
+                gain = 0.0f;
+                uint64_t cur = rTail.load(std::memory_order_acquire);
+                while (!rTail.compare_exchange_weak(cur, packTail(want, tailIndex(cur)),
+                                                    std::memory_order_acq_rel, std::memory_order_acquire)) {}
+                head       = tailIndex(cur);
+                tail       = head;
+                playingGen = want;
+                rHead.store(head, std::memory_order_release);
+            }
+        }
+        if ((uint32_t)(tail - head) < (uint32_t)channels) continue; // 供給待ち (デコードが追いつくまで無音)
+        if (playingGen == want && gain < 1.0f) gain = std::min(1.0f, gain + fadeInStep);
+
+        const float g = gain * volume;
+        for (int c = 0; c < channels; ++c) {
+            int v = out[i + c] + (int)std::lrintf(ring[(head + c) & RING_MASK] * g);
+            out[i + c] = (int16_t)std::clamp(v, -32768, 32767);
+        }
+        head += channels;
+    }
+    rHead.store(head, std::memory_order_release);
+}
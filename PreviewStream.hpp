@@ -0,0 +1,78 @@
+#ifndef PREVIEWSTREAM_HPP
+#define PREVIEWSTREAM_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+// ============================================================
+//  PreviewStream — 選曲画面のプレビュー用リングバッファ + フェード
+//
+//  【旧実装の問題点】
+//    playPreview() が UI スレッドでプレビューファイル全体を Mix_LoadWAV_RW していた。
+//    数十秒の OGG だと数百 ms 止まり、カーソルを動かすたびにスクロールが引っかかった。
+//
+//  【構成】
+//    供給スレッド (SoundManager のプレビュー用ワーカー) がデバイス形式の int16 を
+//    小分けに write() し、オーディオコールバックが mixInto() でキー音ミキサーの出力に足す。
+//    リングは1本の SPSC (供給スレッド → オーディオスレッド)。
+//
+//  【切り替え (世代)】
+//    メインスレッドは request() で世代を進めるだけで、待たずに戻る。
+//    オーディオスレッドは世代が変わったのを見ると、鳴っている音を FADE_OUT_MS で
+//    絞り切ってからリングの残りを捨て、書き込みを許す世代を新しい世代にする。
+//    供給スレッドは ready(gen) になるまで書かない (前の曲の残りと混ざらない)。
+//    ★世代は tail と同じ 64bit の原子変数に入れ、供給スレッドは CAS で公開する。
+//      コピー中に切り替え (破棄) が済んでいれば CAS が失敗し、古い世代の音は公開されない。
+//    新しい世代の音は FADE_IN_MS かけて立ち上げる。
+//
+//  SDL に依存しない。mixInto() 内でのヒープ確保・ロックはなし。
+// ============================================================
+class PreviewStream {
+public:
+    static constexpr size_t RING_SAMPLES = 65536; // 2 の冪。48kHz ステレオで約 0.7 秒 (22050Hz モノラルなら約 3 秒)
+    static constexpr int    FADE_IN_MS   = 250;
+    static constexpr int    FADE_OUT_MS  = 30;    // カーソル移動で即座に止めるため短め (クリック音防止分だけ)
+
+    void configure(int sampleRate, int channels, float volume);
+
+    // --- メインスレッド ---
+    // 新しい世代を始める (前の音はフェードアウトして捨てられる)。戻り値 = 新しい世代
+    uint32_t request();
+    uint32_t currentGeneration() const { return requestGen.load(std::memory_order_acquire); }
+
+    // --- 供給スレッド ---
+    // gen への切り替え (前の世代の破棄) が終わり、書き込んでよいか
+    bool ready(uint32_t gen) const {
+        return tailGen(rTail.load(std::memory_order_acquire)) == gen && currentGeneration() == gen;
+    }
+    // 書けたサンプル数 (リングが埋まっていれば途中まで、gen が古ければ 0)
+    size_t write(uint32_t gen, const int16_t* pcm, size_t samples);
+
+    // --- オーディオスレッド ---
+    // out (インターリーブ int16) にプレビューを足す (飽和)
+    void mixInto(int16_t* out, int samples);
+
+private:
+    // 上位 32bit = 書き込みを許した世代 (破棄が済んだ世代)、下位 32bit = tail
+    static uint64_t packTail(uint32_t gen, uint32_t tail) { return ((uint64_t)gen << 32) | tail; }
+    static uint32_t tailGen(uint64_t v)   { return (uint32_t)(v >> 32); }
+    static uint32_t tailIndex(uint64_t v) { return (uint32_t)v; }
+
+    int16_t ring[RING_SAMPLES];
+    alignas(64) std::atomic<uint32_t> rHead{0}; // オーディオスレッドのみ書く
+    // 供給スレッドは tail を、オーディオスレッドは世代 (と破棄時の位置) を CAS で書く
+    alignas(64) std::atomic<uint64_t> rTail{0};
+
+    std::atomic<uint32_t> requestGen{0}; // メインスレッドのみ書く
+
+    // オーディオスレッド専用
+    uint32_t playingGen  = 0;
+    float    gain        = 0.0f;
+    float    fadeInStep  = 1.0f;
+    float    fadeOutStep = 1.0f;
+    float    volume      = 1.0f;
+    int      channels    = 1;
+};
+
+#endif // PREVIEWSTREAM_HPP
@@ -5,6 +5,7 @@
 #include "BgaManager.hpp"
 #include <cmath>
 #include <algorithm>
+#include <iostream>
 #include <SDL2/SDL_image.h> 
 
 #ifdef __SWITCH__
@@ -66,6 +67,13 @@ void ScenePlay::updateAssist(double cur_ms, PlayEngine& engine, SoundManager& sn
     }
 }
 
+ScenePlay::ScenePlay() = default;
+ScenePlay::~ScenePlay() = default;
+
+void ScenePlay::releaseBga() {
+    if (bgaHolder) bgaHolder->cleanup();
+}
+
 // --- メインロジック ---
 bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer, const std::string& bmsonPath) {
     // 1. 前の曲の残骸を完全に消し去る (断片化対策の第一歩)
@@ -104,7 +112,8 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
     drawStartIndex = 0;
     
     // BGA初期化
-    BgaManager bga;
+    if (!bgaHolder) bgaHolder = std::make_unique<BgaManager>();
+    BgaManager& bga = *bgaHolder;
     bga.init(data.bga_images.size());
     bga.setEvents(data.bga_events);      
     bga.setLayerEvents(data.layer_events); 
@@ -137,12 +146,18 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
     if (!data.header.bga_video.empty()) {
         std::string videoFile = data.header.bga_video;
         std::string fullVideoPath = bmsonDir + videoFile;
-        bga.loadBgaFile(fullVideoPath, ren);
+        // 【追加】リトライで同じ動画なら、開き直さずに頭から出し直す
+        if (bga.isVideoOpen(fullVideoPath)) bga.restartVideo(0.0);
+        else bga.loadBgaFile(fullVideoPath, ren);
+    } else {
+        bga.closeVideo();
     }
 
     for (auto const& [id, filename] : data.bga_images) {
         bga.registerPath(id, filename);
     }
+    // 【追加】画像 BGA は時刻 (ms) で先読みする
+    bga.setEventTimes([&engine](long long y) { return engine.getMsFromY(y); });
 
     // 4. 音声インデックス作成とバルクロード
     // JSONが消えて「きれいになったヒープ」に対して大きな音声を確保しにいく
@@ -166,32 +181,99 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
 
     // 指摘のあった「二重消費」はSoundManager側で修正済みのため、安心して呼べる
     int lastLoadPercent = -1;
-    snd.loadSoundsInBulk(soundList, bmsonDir, bmsonBaseName, [&](int processedCount, const std::string& currentName) {
-        int curPercent = (processedCount * 100) / (int)data.sound_channels.size();
+    auto drawLoadProgress = [&](int done, int total, const std::string& label) {
+        int curPercent = (total > 0) ? (done * 100) / total : 100;
 
         if (curPercent != lastLoadPercent) {
-            renderer.renderLoading(ren, processedCount, data.sound_channels.size(), "Audio Loading: " + currentName);
+            renderer.renderLoading(ren, done, total, label);
             
             uint64_t curMem = snd.getCurrentMemory();
             uint64_t maxMem = snd.getMaxMemory();
             double curMB = (double)curMem / (1024.0 * 1024.0);
             double maxMB = (double)maxMem / (1024.0 * 1024.0);
             char memBuf[128];
-            snprintf(memBuf, sizeof(memBuf), "WAV Memory: %.1f / %.1f MB", curMB, maxMB);
+            // 【追加】同じ内容のサンプルを共有して浮いた分も出す
+            uint64_t dedup = snd.getDedupBytes();
+            if (dedup > 0) {
+                snprintf(memBuf, sizeof(memBuf), "WAV Memory: %.1f / %.1f MB (dedup -%.1f MB, %u shared)", curMB, maxMB,
+                         (double)dedup / (1024.0 * 1024.0), snd.getDedupCount());
+            } else {
+                snprintf(memBuf, sizeof(memBuf), "WAV Memory: %.1f / %.1f MB", curMB, maxMB);
+            }
             renderer.drawText(ren, memBuf, 640, 580, {200, 200, 200, 255}, false, true);
             
             if (curMem >= maxMem - (1024 * 1024 * 5)) { // 警告しきい値を5MB程度に調整
-                renderer.drawText(ren, "WARNING: MEMORY LIMIT REACHED (SKIPPING)", 640, 620, {255, 50, 50, 255}, false, true);
+                renderer.drawText(ren, "WARNING: MEMORY LIMIT REACHED (DROPPING LOW PRIORITY SOUNDS)", 640, 620, {255, 50, 50, 255}, false, true);
             }
             
             SDL_RenderPresent(ren);
             lastLoadPercent = curPercent;
         }
+    };
+
+    // 【追加】前の譜面の事前ミックスが残っていれば、キー音の予算を空けるために先に解放する
+    snd.keepPremixFor(Config::BGM_PREMIX ? bmsonPath : std::string());
+
+    // 予算を超えた時にどの音を残すかは譜面での使われ方で決める
+    snd.setSoundUsage(engine.getNotes());
+
+    if (Config::ASYNC_LOAD_LEAD_SEC > 0) {
+        // 【追加】最初の N 秒分 (+ 事前ミックスする BGM の音) だけ揃えて開始し、残りは演奏中に読む
+        char leadLabel[64];
+        snprintf(leadLabel, sizeof(leadLabel), "Audio Loading (first %ds)...", Config::ASYNC_LOAD_LEAD_SEC);
+        snd.loadSoundsAsync(soundList, engine.getNotes(), bmsonDir, bmsonBaseName,
+                            Config::ASYNC_LOAD_LEAD_SEC * 1000.0, Config::BGM_PREMIX,
+                            [&](int done, int total) {
+            drawLoadProgress(done, total, leadLabel);
+            SDL_Event e; while(SDL_PollEvent(&e));
+        });
+    } else {
+        snd.loadSoundsInBulk(soundList, bmsonDir, bmsonBaseName, [&](int processedCount, const std::string& currentName) {
+            drawLoadProgress(processedCount, (int)data.sound_channels.size(), "Audio Loading: " + currentName);
+
+            if (processedCount % 100 == 0) {
+                SDL_Event e; while(SDL_PollEvent(&e));
+            }
+        });
+    }
 
-        if (processedCount % 100 == 0) {
+    // 5. BGM レーンの事前ミックス (メモリが足りなければノーツごとの発音にフォールバック)
+    bool bgmPremixed = false;
+    if (Config::BGM_PREMIX) {
+        bgmPremixed = snd.premixBgm(engine.getNotes(), bmsonPath, [&](int done, int total) {
+            renderer.renderLoading(ren, done, total, "Premixing BGM...");
+            SDL_RenderPresent(ren);
             SDL_Event e; while(SDL_PollEvent(&e));
-        }
-    });
+        });
+    } else {
+        snd.freePremix();
+    }
+    engine.setBgmPremixed(bgmPremixed);
+
+    // 【追加】無音の切り落としで減ったメモリと、平均同時発音数の見積もり (切る前 → 後)
+    //         事前ミックスした BGM はボイスを使わないので除く。演奏後に実測値と並べて出す
+    SoundManager::TrimReport trimReport = snd.getTrimReport(engine.getNotes(), !bgmPremixed);
+    char trimText[128] = "";
+    if (trimReport.trimmedSounds > 0) {
+        snprintf(trimText, sizeof(trimText), "Silence trim: %u sounds, -%.1f MB, voices %.1f -> %.1f",
+                 trimReport.trimmedSounds, trimReport.savedBytes / (1024.0 * 1024.0),
+                 trimReport.voicesBefore, trimReport.voicesAfter);
+        if (Config::PLAY_STATS_LOG) std::cout << trimText << " (estimated)" << std::endl;
+    }
+    // 【追加】ADPCM で持つことにした音と、それで減った WAV Memory
+    char adpcmText[128] = "";
+    if (trimReport.adpcmSounds > 0) {
+        snprintf(adpcmText, sizeof(adpcmText), "ADPCM: %u sounds, -%.1f MB", trimReport.adpcmSounds,
+                 trimReport.adpcmSavedBytes / (1024.0 * 1024.0));
+        if (Config::PLAY_STATS_LOG) std::cout << adpcmText << std::endl;
+    }
+    // 【追加】ディスクから流す長い音 (非同期ロードで後から届く分はここに入らない)
+    char streamText[128] = "";
+    if (snd.getStreamedSounds() > 0) {
+        snprintf(streamText, sizeof(streamText), "Streamed: %u sounds, -%.1f MB", snd.getStreamedSounds(),
+                 snd.getStreamSavedBytes() / (1024.0 * 1024.0));
+        if (Config::PLAY_STATS_LOG) std::cout << streamText << std::endl;
+    }
 
     SDL_Delay(100);
 
@@ -221,15 +303,54 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
         if (!n.isBGM) max_target_ms = std::max(max_target_ms, n.target_ms);
     }
 
+    // ★全キー音がキャッシュから来た (= SD を読んでいない) 場合は I/O の落ち着き待ちが不要
+    bool allFromCache = (snd.getCacheMisses() == 0 && snd.getCacheHits() > 0);
     uint32_t readyStartTime = SDL_GetTicks();
-    const uint32_t READY_DURATION = 5000; 
+    const uint32_t READY_DURATION = allFromCache ? 1000 : 5000;
+    char readyText[64];
+    snprintf(readyText, sizeof(readyText), "Please wait %u seconds", READY_DURATION / 1000);
+
+    // 【追加】WAV Memory の予算に入らず落とした音を待機画面に出す (黙って鳴らなくしない)
+    std::vector<std::string> dropLines;
+    {
+        std::vector<SoundManager::DroppedSound> dropped = snd.getDroppedSounds();
+        if (!dropped.empty()) {
+            uint64_t droppedBytes = 0;
+            uint32_t playerDrops  = 0;
+            for (const auto& d : dropped) {
+                droppedBytes += d.bytes;
+                if (d.player) playerDrops++;
+            }
+            char buf[128];
+            snprintf(buf, sizeof(buf), "WAV MEMORY FULL: %zu sounds dropped (%.1f MB, %u player lane)",
+                     dropped.size(), droppedBytes / (1024.0 * 1024.0), playerDrops);
+            dropLines.push_back(buf);
+            // 重要なもの (プレイヤーレーン → 大きい順) から数件だけ名前を出す
+            std::sort(dropped.begin(), dropped.end(), [](const auto& a, const auto& b) {
+                if (a.player != b.player) return a.player;
+                return a.bytes > b.bytes;
+            });
+            for (size_t i = 0; i < dropped.size() && i < 3; ++i) {
+                snprintf(buf, sizeof(buf), "%s %s (%.0f KB)", dropped[i].evicted ? "evicted" : "skipped",
+                         dropped[i].name.c_str(), dropped[i].bytes / 1024.0);
+                dropLines.push_back(buf);
+            }
+        }
+    }
     while (SDL_GetTicks() - readyStartTime < READY_DURATION) {
         uint32_t now = SDL_GetTicks();
         if (!processInput(-2000.0, now, snd, engine)) return false;
-        bga.preLoad(0, ren);
+        bga.preLoad(0.0, ren);
         renderScene(ren, renderer, engine, bga, -2000.0, 0, 0, currentHeader, now, 0.0);
         // ★修正⑥: rebuildLaneLayout() でキャッシュ済みの値を使用（再計算を廃止）
-        renderer.drawText(ren, "Please wait 5 seconds", renderer.getLaneCenterX(), 450, {255, 255, 0, 255}, false, true);
+        renderer.drawText(ren, readyText, renderer.getLaneCenterX(), 450, {255, 255, 0, 255}, false, true);
+        if (trimText[0]) renderer.drawText(ren, trimText, renderer.getLaneCenterX(), 410, {200, 200, 200, 255}, false, true);
+        if (adpcmText[0]) renderer.drawText(ren, adpcmText, renderer.getLaneCenterX(), 380, {200, 200, 200, 255}, false, true);
+        if (streamText[0]) renderer.drawText(ren, streamText, renderer.getLaneCenterX(), 350, {200, 200, 200, 255}, false, true);
+        for (size_t i = 0; i < dropLines.size(); ++i) {
+            renderer.drawText(ren, dropLines[i], renderer.getLaneCenterX(), 500 + (int)i * 30,
+                              {255, 80, 80, 255}, false, true);
+        }
         SDL_RenderPresent(ren);
 #ifdef __SWITCH__
         if (!appletMainLoop()) return false;
@@ -260,6 +381,9 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
     }
 
     uint32_t start_ticks = SDL_GetTicks() + 2000;
+    // ミキサーのソングクロックをゲームループの cur_ms と同じ時計に合わせる
+    snd.setSongClock((double)((int64_t)SDL_GetTicks() - (int64_t)start_ticks));
+    if (bgmPremixed) snd.startPremixedBgm();
     uint32_t lastFpsTime = SDL_GetTicks();
     int frameCount = 0, fps = 0;
     bool playing = true;
@@ -288,11 +412,23 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
         }
     }
 
+    // 待機画面は1フレームに2回 Present しているため、計測は本編直前から始める
+    pacer.reset();
+    snd.resetMixerStats();
+    snd.getLatencyProbe().reset();
+    snd.getLatencyProbe().setEnabled(Config::LATENCY_PROBE);
+
     while (playing) {
         uint32_t now = SDL_GetTicks();
         double cur_ms = (double)((int64_t)now - (int64_t)start_ticks);
 
-        bga.syncTime(cur_ms - videoOffsetMs);
+        // ★表示時刻予測: 入力・判定は cur_ms、描画 (ノーツ・小節線・BGA) は
+        //   このフレームが実際に画面に出る予測時刻 display_ms を使う
+        double latencyMs  = pacer.beginFrame();
+        double display_ms = Config::PREDICT_DISPLAY_TIME ? cur_ms + latencyMs : cur_ms;
+
+        bga.syncTime(display_ms - videoOffsetMs);
+        bga.preLoad(display_ms, ren); // 【追加】画像 BGA の先読み要求とアップロード (予算内)
 
         if (!processInput(cur_ms, now, snd, engine)) {
             if (engine.getStatus().isFailed) playing = false;
@@ -306,12 +442,12 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
         if (s.isFailed) playing = false;
         double progress = 0.0;
         if (max_target_ms > 0) progress = std::clamp(cur_ms / max_target_ms, 0.0, 1.0);
-        int64_t cur_y = engine.getYFromMs(cur_ms);
+        int64_t cur_y = engine.getYFromMs(display_ms);
         auto& judge = engine.getCurrentJudge();
         if (judge.active && (judge.kind == JudgeKind::POOR || judge.kind == JudgeKind::BAD)) bga.setMissTrigger(true);
         else bga.setMissTrigger(false);
 
-        renderScene(ren, renderer, engine, bga, cur_ms, cur_y, fps, currentHeader, now, progress);
+        renderScene(ren, renderer, engine, bga, display_ms, cur_y, fps, currentHeader, now, progress);
 
         if (!fcEffectTriggered && s.remainingNotes <= 0) {
             bool isFC = (s.poorCount == 0 && s.badCount == 0 && s.totalNotes > 0);
@@ -328,7 +464,7 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
                 while (SDL_GetTicks() - fcStart < 2500) {
                     uint32_t nowFC = SDL_GetTicks();
                     float p = std::min(1.0f, (float)(nowFC - fcStart) / 1000.0f);
-                    renderScene(ren, renderer, engine, bga, cur_ms, cur_y, fps, currentHeader, nowFC, 1.0);
+                    renderScene(ren, renderer, engine, bga, display_ms, cur_y, fps, currentHeader, nowFC, 1.0);
                     if (gradTex) {
                         int lineY = Config::JUDGMENT_LINE_Y;
                         int uvOffset = (int)(nowFC * 1) % TEX_H; 
@@ -370,11 +506,78 @@ bool ScenePlay::run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer
     // ★修正①: ループ終了後に一度だけコピー（FC の場合はループ内でコピー済みなのでスキップ）
     if (!fcEffectTriggered) status = engine.getStatus();
 
+    // 計測値のダンプは PLAY_STATS_LOG の時だけ (HUD と同じ値を演奏後にまとめて出す)
+    if (Config::PLAY_STATS_LOG) {
+        std::cout << "FramePacer: interval=" << pacer.getPresentIntervalMs()
+                  << "ms render=" << pacer.getRenderCostMs()
+                  << "ms err=" << pacer.getPredictionErrorMs()
+                  << "ms jitter=" << pacer.getPredictionJitterMs()
+                  << "ms frames=" << pacer.getFrameCount() << std::endl;
+        const AudioMixer::Stats ms = snd.getMixerStats();
+        std::cout << "Mixer: peakVoices=" << ms.peakVoices
+                  << " stolen=" << ms.stolenVoices
+                  << " polyCuts=" << ms.polyCuts
+                  << " chokeCuts=" << ms.chokeCuts
+                  << " underruns=" << ms.underruns
+                  << " maxGap=" << ms.maxGapUs << "us"
+                  << " dropped=" << ms.droppedTriggers
+                  << " peakCallback=" << ms.peakCallbackUs
+                  << "us voices/ms=" << ms.voicesPerMs
+                  << " scheduled=" << ms.scheduledEvents
+                  << " late=" << ms.lateEvents
+                  << " avgVoices=" << ms.avgVoices()
+                  << " avgCallback=" << ms.avgCallbackUs() << "us"
+                  << (bgmPremixed ? " (BGM premixed)" : " (BGM per-note)") << std::endl;
+        if (trimReport.trimmedSounds > 0) {
+            std::cout << "Silence trim: " << trimReport.trimmedSounds << " sounds, saved "
+                      << (trimReport.savedBytes >> 10) << "KB, est. avgVoices " << trimReport.voicesBefore
+                      << " -> " << trimReport.voicesAfter << ", measured " << ms.avgVoices() << std::endl;
+        }
+        if (trimReport.adpcmSounds > 0) {
+            // 展開のコストはコールバック時間に含まれる (ボイス単体の比較は tools/mixer_bench)
+            std::cout << "ADPCM: " << trimReport.adpcmSounds << " sounds, saved " << (trimReport.adpcmSavedBytes >> 10)
+                      << "KB, avgAdpcmVoices=" << ms.avgAdpcmVoices() << " of " << ms.avgVoices() << std::endl;
+        }
+        if (snd.getStreamedSounds() > 0) {
+            // underruns = 読み込みが間に合わず無音で埋めたコールバックの数 (0 が正常)
+            std::cout << "Streamed: " << snd.getStreamedSounds() << " sounds, saved "
+                      << (snd.getStreamSavedBytes() >> 10) << "KB, underruns=" << snd.getStreamUnderruns() << std::endl;
+        }
+        if (Config::ASYNC_LOAD_LEAD_SEC > 0) {
+            SoundManager::LoadStats ls = snd.getLoadStats();
+            std::cout << "Load: total=" << ls.total
+                      << " cached=" << ls.cacheHits
+                      << " beforeStart=" << ls.required
+                      << " streamed=" << ls.streamed
+                      << " late=" << ls.lateArrivals
+                      << " missedTriggers=" << ls.missedTriggers
+                      << " wait=" << ls.waitMs << "ms"
+                      << " all=" << ls.totalMs << "ms" << std::endl;
+        }
+    }
+    const LatencyProbe& probe = snd.getLatencyProbe();
+    if (probe.isEnabled() && !probe.getSamples().empty()) {
+        // LATENCY_PROBE の CSV はログの有無に関係なく書く。各列は入力イベントからの経過 us (-1 = その段階に届かなかった)
+        std::string csv = Config::ROOT_PATH + "latency.csv";
+        bool written = probe.writeCsv(csv);
+        if (Config::PLAY_STATS_LOG) {
+            LatencyProbe::Percentiles mix = probe.percentiles(LatencyProbe::MIX);
+            LatencyProbe::Percentiles prs = probe.percentiles(LatencyProbe::PRESENT);
+            std::cout << "Latency: hits=" << probe.getSamples().size()
+                      << " input>mix p50/p95/p99=" << mix.p50 << "/" << mix.p95 << "/" << mix.p99 << "ms"
+                      << " input>present=" << prs.p50 << "/" << prs.p95 << "/" << prs.p99 << "ms"
+                      << (written ? " -> " + csv : std::string(" (csv write failed)")) << std::endl;
+        }
+    }
+
+    // 途切れがあれば次回起動時のバッファを広げる (下の Config::save で保存される)
+    snd.adaptBufferAfterSong();
+
     Config::save();
 
     if (gradTex) SDL_DestroyTexture(gradTex);
     snd.clear();
-    bga.cleanup(); 
+    bga.clearImages(); // 動画はリトライに備えて開いたまま (releaseBga で閉じる)
     if (isAborted) return false; 
     return true;
 }
@@ -432,7 +635,12 @@ bool ScenePlay::processInput(double cur_ms, uint32_t now, SoundManager& snd, Pla
             if (lane != -1 && !isAutoLane(lane)) {
                 if (isDown) {
                     if (!engine.getStatus().isFailed && cur_ms >= -500.0) {
+                        // 遅延計測: イベントの timestamp (ms) から SDL のキューに入った時刻を逆算する
+                        LatencyProbe& probe = snd.getLatencyProbe();
+                        uint32_t hitId = probe.beginHit(lane, (int64_t)(SDL_GetTicks() - ev.jbutton.timestamp) * 1000000);
+                        probe.mark(hitId, LatencyProbe::HIT);
                         int resultJudge = engine.processHit(lane, cur_ms, now, snd);
+                        probe.endHit();
                         
                         bool found = false;
                         for (auto& eff : effects) {
@@ -559,6 +767,43 @@ void ScenePlay::renderScene(SDL_Renderer* ren, NoteRenderer& renderer, PlayEngin
         char gearText[256];
         snprintf(gearText, sizeof(gearText), "GN: %d | SUD+:%d LIFT:%d", calcSyncGN(currentBpm), Config::SUDDEN_PLUS, Config::LIFT);
         renderer.drawText(ren, gearText, laneCenterX, 20, {0, 255, 0, 255}, false, true);
+
+        // 表示時刻予測のチューニング用: 予測遅延 / 予測誤差 (EMA) / ばらつき
+        char pacerText[128];
+        snprintf(pacerText, sizeof(pacerText), "LAT:%.1fms ERR:%+.1fms JIT:%.1fms",
+                 pacer.getPredictedLatencyMs(), pacer.getPredictionErrorMs(), pacer.getPredictionJitterMs());
+        renderer.drawText(ren, pacerText, laneCenterX, 50, {0, 200, 255, 255}, false, true);
+
+        // 非同期ロードの追従状況: 演奏開始後に読んだ数 / 遅刻 / 鳴らせなかった発音
+        if (Config::ASYNC_LOAD_LEAD_SEC > 0) {
+            SoundManager::LoadStats ls = SoundManager::getInstance().getLoadStats();
+            char loadText[128];
+            snprintf(loadText, sizeof(loadText), "STREAM:%u/%u LATE:%u MISS:%u",
+                     ls.streamed, ls.total - ls.cacheHits - ls.required, ls.lateArrivals, ls.missedTriggers);
+            renderer.drawText(ren, loadText, laneCenterX, 80, {255, 200, 0, 255}, false, true);
+        }
+
+        // オーディオ形式と途切れ (XRUN) の回数、直近のコールバック時間
+        const SoundManager::AudioSettings& as = SoundManager::getInstance().getAudioSettings();
+        const AudioMixer::Stats ms = SoundManager::getInstance().getMixerStats();
+        char audioText[128];
+        snprintf(audioText, sizeof(audioText), "AUDIO:%dHz/%dch/%d XRUN:%llu CB:%.0fus",
+                 as.rate, as.channels, as.buffer, (unsigned long long)ms.underruns, ms.lastCallbackUs);
+        renderer.drawText(ren, audioText, laneCenterX, 110, ms.underruns ? SDL_Color{255, 80, 80, 255} : SDL_Color{160, 160, 160, 255}, false, true);
+
+        // 打鍵からの遅延 (LATENCY_PROBE): 音 = 初めて混ぜたコールバック、画面 = 結果を含む Present
+        const LatencyProbe& probe = SoundManager::getInstance().getLatencyProbe();
+        if (probe.isEnabled()) {
+            LatencyProbe::Percentiles mix = probe.percentiles(LatencyProbe::MIX);
+            LatencyProbe::Percentiles prs = probe.percentiles(LatencyProbe::PRESENT);
+            char probeText[160];
+            snprintf(probeText, sizeof(probeText), "IN>SND:%.1f/%.1f/%.1f IN>PRS:%.1f/%.1f/%.1fms (%u)",
+                     mix.p50, mix.p95, mix.p99, prs.p50, prs.p95, prs.p99, prs.count);
+            renderer.drawText(ren, probeText, laneCenterX, 140, {255, 160, 255, 255}, false, true);
+        }
     }
+    pacer.markSubmit();
     SDL_RenderPresent(ren);
+    pacer.markPresented();
+    SoundManager::getInstance().getLatencyProbe().markPresented();
 }
\ No newline at end of file
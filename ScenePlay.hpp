@@ -3,11 +3,13 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <SDL2/SDL.h>
 #include "SoundManager.hpp"
 #include "NoteRenderer.hpp"
 #include "CommonTypes.hpp"
 #include "BMSData.hpp"
+#include "FramePacer.hpp"
 
 // ボムの独立したアニメーション管理用
 struct BombAnim {
@@ -22,9 +24,13 @@ class BgaManager;
 
 class ScenePlay {
 public:
+    ScenePlay();
+    ~ScenePlay();
     bool run(SDL_Renderer* ren, SoundManager& snd, NoteRenderer& renderer, const std::string& bmsonPath);
     const PlayStatus& getStatus() const { return status; }
     const BMSHeader& getHeader() const { return currentHeader; }
+    // 【追加】リトライを抜けた後に呼ぶ: 使い回すために開いたままの動画 BGA を閉じる
+    void releaseBga();
 
 private:
     // --- 内部処理用関数（重複を削除し、ここに集約） ---
@@ -59,6 +65,12 @@ private:
     
     // 最適化用インデックス
     size_t drawStartIndex = 0; 
+
+    // 表示時刻予測 (renderScene の Present 前後で計測)
+    FramePacer pacer;
+
+    // 動画 BGA はリトライで開き直さないよう run() をまたいで持つ (releaseBga で閉じる)
+    std::unique_ptr<BgaManager> bgaHolder;
 };
 
 #endif
@@ -3,11 +3,13 @@
 #include "ScoreManager.hpp"
 #include <SDL2/SDL_image.h>
 
-void SceneResult::run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatus& status, const BMSHeader& header) {
+bool SceneResult::run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatus& status, const BMSHeader& header,
+                      bool allowRetry) {
     ScoreManager::saveIfBest(header.title, header.chartName, (int)header.total, status);
     BestScore best = ScoreManager::loadScore(header.title, header.chartName, (int)header.total);
 
     bool backToSelect = false;
+    bool retry = false;
     SDL_Event e;
 
     uint32_t startTime = SDL_GetTicks();
@@ -25,13 +27,18 @@ void SceneResult::run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatu
 
     while (!backToSelect) {
         while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) return;
+            if (e.type == SDL_QUIT) return false;
 
             if (SDL_GetTicks() - startTime > MIN_DISPLAY_TIME) {
                 if (e.type == SDL_JOYBUTTONDOWN) {
                     if (e.jbutton.button == Config::SYS_BTN_BACK) {
                         backToSelect = true;
                     }
+                    // 【追加】リトライ: キー音はキャッシュに残っているのでロードはほぼ一瞬
+                    else if (allowRetry && e.jbutton.button == Config::SYS_BTN_DECIDE) {
+                        retry = true;
+                        backToSelect = true;
+                    }
                 }
                 else if (e.type == SDL_KEYDOWN) {
                     if (e.key.keysym.sym == SDLK_ESCAPE ||
@@ -39,6 +46,10 @@ void SceneResult::run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatu
                         e.key.keysym.sym == SDLK_RETURN) {
                         backToSelect = true;
                     }
+                    else if (allowRetry && e.key.keysym.sym == SDLK_r) {
+                        retry = true;
+                        backToSelect = true;
+                    }
                 }
             }
         }
@@ -109,6 +120,10 @@ void SceneResult::run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatu
         renderer.drawTextCached(ren, fastText, 850, 580, {0, 255, 255, 255}, false, false);
         renderer.drawTextCached(ren, slowText, 850, 610, {255, 0, 255, 255}, false, false);
 
+        if (allowRetry) {
+            renderer.drawTextCached(ren, "DECIDE: RETRY  /  BACK: SELECT", 640, 680, {200, 200, 200, 255}, false, true);
+        }
+
         // SDL_RENDERER_PRESENTVSYNCが有効なためSDL_RenderPresentが既に16ms待機する
         // SDL_Delay(16)を重ねると実質30fpsになるため削除
         SDL_RenderPresent(ren);
@@ -117,6 +132,7 @@ void SceneResult::run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatu
     IMG_Quit();
     SDL_Delay(200);
     SDL_FlushEvents(SDL_JOYBUTTONDOWN, SDL_JOYBUTTONUP);
+    return retry;
 }
 
 std::string SceneResult::calculateRank(const PlayStatus& status) {
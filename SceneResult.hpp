@@ -9,7 +9,9 @@
 class SceneResult {
 public:
     // リザルト画面のメインループを実行
-    void run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatus& status, const BMSHeader& header);
+    // allowRetry が true の時は DECIDE で同じ譜面をリトライできる。戻り値 = リトライが選ばれたか
+    bool run(SDL_Renderer* ren, NoteRenderer& renderer, const PlayStatus& status, const BMSHeader& header,
+             bool allowRetry = false);
 
 private:
     // スコアからランク（AAA〜F）を計算
@@ -404,10 +404,9 @@ std::string SceneSelect::update(SDL_Renderer* ren, NoteRenderer& renderer, int c
                 else if (btn == Config::SYS_BTN_DECIDE && !songGroups.empty()) {
                     SongGroup& g = songGroups[selectedIndex];
                     if (g.isFolder) {
+                        // ★決定音の読み込み・デコードはプレビュー用スレッドで行う (UI スレッドでは待たない)
                         if (!g.customSE.empty() && fs::exists(g.customSE)) {
-                            fs::path sePath(g.customSE);
-                            SoundManager::getInstance().loadSingleSound(sePath.filename().string(), sePath.parent_path().string());
-                            SoundManager::getInstance().playByName(sePath.filename().string());
+                            SoundManager::getInstance().playEffect(g.customSE);
                         }
                         g_currentDirPath = g.folderPath;
                         this->init(false, ren, renderer, currentStage); 
@@ -582,11 +581,13 @@ std::string SceneSelect::update(SDL_Renderer* ren, NoteRenderer& renderer, int c
                 if (!entry.previewPath.empty()) {
                     SoundManager::getInstance().playPreview(entry.previewPath);
                 } else {
-                    BMSHeader header = BmsonLoader::loadHeader(entry.filename);
-                    if (!header.preview.empty()) {
-                        fs::path root = fs::path(entry.filename).parent_path();
-                        SoundManager::getInstance().playPreview((root / header.preview).string());
-                    }
+                    // ★ヘッダの読み込みはプレビュー用スレッドで行う (スクロール中に UI を止めない)
+                    std::string chartPath = entry.filename;
+                    SoundManager::getInstance().playPreview(chartPath, [chartPath]() -> std::string {
+                        BMSHeader header = BmsonLoader::loadHeader(chartPath);
+                        if (header.preview.empty()) return "";
+                        return (fs::path(chartPath).parent_path() / header.preview).string();
+                    });
                 }
             }
         }
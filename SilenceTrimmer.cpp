@@ -0,0 +1,84 @@
+#include "SilenceTrimmer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define TRIM_USE_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRIM_USE_SSE2 1
+#endif
+
+static bool forceScalar = false;
+
+static inline bool loud(int16_t s, int16_t threshold) {
+    return std::abs((int)s) > threshold;
+}
+
+// ============================================================
+//  先頭から / 末尾から、しきい値を超えるサンプルを含む 8 サンプル組を探す。
+//  見つかった組の中はスカラーで確定する。
+//  abs(-32768) の飽和を避けるため、x > t || x < -t で判定する。
+// ============================================================
+
+#if defined(TRIM_USE_NEON)
+static inline bool anyLoud(const int16_t* p, int16x8_t hi, int16x8_t lo) {
+    int16x8_t v = vld1q_s16(p);
+    uint16x8_t m = vorrq_u16(vcgtq_s16(v, hi), vcltq_s16(v, lo));
+    return vmaxvq_u16(m) != 0;
+}
+#elif defined(TRIM_USE_SSE2)
+static inline bool anyLoud(const int16_t* p, __m128i hi, __m128i lo) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i m = _mm_or_si128(_mm_cmpgt_epi16(v, hi), _mm_cmplt_epi16(v, lo));
+    return _mm_movemask_epi8(m) != 0;
+}
+#endif
+
+bool SilenceTrimmer::findAudible(const int16_t* pcm, size_t samples, int16_t threshold,
+                                 size_t& first, size_t& last) {
+    size_t head = 0;
+    size_t tail = samples; // [head, tail) が未確定
+
+#if defined(TRIM_USE_NEON) || defined(TRIM_USE_SSE2)
+    if (!forceScalar) {
+#if defined(TRIM_USE_NEON)
+        const int16x8_t hi = vdupq_n_s16(threshold);
+        const int16x8_t lo = vdupq_n_s16((int16_t)-threshold);
+#else
+        const __m128i hi = _mm_set1_epi16(threshold);
+        const __m128i lo = _mm_set1_epi16((int16_t)-threshold);
+#endif
+        while (head + 8 <= tail && !anyLoud(pcm + head, hi, lo)) head += 8;
+        while (tail >= head + 8 && !anyLoud(pcm + tail - 8, hi, lo)) tail -= 8;
+    }
+#endif
+
+    while (head < tail && !loud(pcm[head], threshold)) head++;
+    if (head == tail) return false;
+    while (tail > head && !loud(pcm[tail - 1], threshold)) tail--;
+    first = head;
+    last  = tail - 1;
+    return true;
+}
+
+int16_t SilenceTrimmer::thresholdFromDb(int db) {
+    if (db >= 0) return 0;
+    double amp = 32768.0 * std::pow(10.0, db / 20.0);
+    return (int16_t)std::max(0.0, std::min(32767.0, std::floor(amp)));
+}
+
+void SilenceTrimmer::setForceScalar(bool v) { forceScalar = v; }
+
+const char* SilenceTrimmer::kernelName() {
+    if (forceScalar) return "scalar";
+#if defined(TRIM_USE_NEON)
+    return "NEON";
+#elif defined(TRIM_USE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,33 @@
+#ifndef SILENCETRIMMER_HPP
+#define SILENCETRIMMER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// ============================================================
+//  SilenceTrimmer — キー音の前後の無音を探す (ロード時の解析パス)
+//
+//  キー音には数百 ms のデジタル無音が末尾に付いていることが多く、
+//  メモリを食ううえ、鳴り終わるまでミキサーのボイスを1つ占有し続ける。
+//  絶対値がしきい値を超える最初と最後のサンプルを NEON / SSE2 で探し、
+//  呼び出し側 (SoundManager::trimSilence) がその外側を切り落とす。
+//  先頭を切った分は「オンセット」として記録し、発音時にその分だけ遅らせて
+//  鳴らすので、聞こえるタイミングは変わらない。
+//
+//  SDL に依存しないため tools/ のベンチマークからもそのまま使える。
+// ============================================================
+class SilenceTrimmer {
+public:
+    // |pcm[i]| > threshold となる最初と最後の i。全て無音なら false
+    static bool findAudible(const int16_t* pcm, size_t samples, int16_t threshold,
+                            size_t& first, size_t& last);
+
+    // dBFS (負の値。例: -60) → int16 の振幅しきい値
+    static int16_t thresholdFromDb(int db);
+
+    // ベンチマーク用: SIMD を無効化する
+    static void setForceScalar(bool v);
+    static const char* kernelName();
+};
+
+#endif // SILENCETRIMMER_HPP
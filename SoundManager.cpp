@@ -1,27 +1,156 @@
 #include "SoundManager.hpp"
+#include "Config.hpp"
+#include "WavDecoder.hpp"
+#include "SilenceTrimmer.hpp"
+#include "AdpcmCodec.hpp"
+#include "DecodePipeline.hpp"
+#include "AudioCalibrator.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 #include <iostream>
 #include <unordered_map>
-#include <fstream>
 #include <vector>
 #include <cstring>
+#include <cstdlib>
 #include <algorithm>
+#include <cmath>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <limits>
+#include <unordered_set>
+#include <sys/stat.h>
 
 void SoundManager::init() {
+    // ★init() は起動時 (main) と選曲画面に入るたび (SceneSelect) に呼ばれる。2回目以降は何もしない。
+    //   鳴っている最中に mixer.configure() → resetVoices() するとオーディオコールバックと競合し、
+    //   動いている std::thread に代入すると std::terminate になる。デバイスの開き直しは Switch で失敗しうる
+    if (audioOpened) return;
+
     sounds.reserve(4000);
     SDL_SetHint("SDL_AUDIO_RESAMPLING_MODE", "linear");
 
-    if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 1, 512) < 0) {
+    openAudio();
+    mixer.setPolyphony(Config::KEYSOUND_MAX_POLY);
+    previewQuit.store(false);
+    streamQuit.store(false);
+    previewThread = std::thread(&SoundManager::previewWorker, this);
+    streamThread  = std::thread(&SoundManager::streamWorker, this);
+
+    // ★キー音もプレビューも SDL_mixer のチャンネルを使わず、音楽フック (= 生のオーディオ
+    //   コールバック) 上の自前ミキサーと PreviewStream で鳴らす
+    Mix_HookMusic(&SoundManager::mixCallback, this);
+    std::cout << "SoundManager Initialized. (" << audioSettings.rate << "Hz, " << audioSettings.channels << "ch, "
+              << audioSettings.buffer << " frames, mixer="
+              << AudioMixer::kernelName() << ")" << std::endl;
+}
+
+void SoundManager::openAudio() {
+    AudioCalibrator::Candidate want{Config::AUDIO_RATE, Config::AUDIO_CHANNELS, Config::AUDIO_BUFFER};
+    if (Config::AUDIO_AUTO) {
+        AudioCalibrator::Limits limits;
+        limits.maxRate     = Config::AUDIO_MAX_RATE;
+        limits.maxChannels = Config::AUDIO_MAX_CHANNELS;
+        limits.minBuffer   = Config::AUDIO_MIN_BUFFER;
+        uint32_t t0 = SDL_GetTicks();
+        std::vector<AudioCalibrator::Measurement> tested;
+        AudioCalibrator::Measurement m = AudioCalibrator::choose(limits, &tested);
+        for (const auto& t : tested) {
+            std::cout << "Audio calibrate: " << t.c.rate << "Hz " << t.c.channels << "ch " << t.c.buffer
+                      << " frames: worst " << (int)t.worstUs << "us / " << (int)t.periodUs << "us"
+                      << (t.ok ? " OK" : "") << std::endl;
+        }
+        std::cout << "Audio calibrate: " << tested.size() << " candidates in " << (SDL_GetTicks() - t0) << "ms"
+                  << (m.ok ? "" : " (none within budget, using the one with the most headroom)") << std::endl;
+        want = m.c;
+        audioSettings.calibrated = true;
+        audioSettings.worstUs    = m.worstUs;
+        audioSettings.periodUs   = m.periodUs;
+    }
+
+    if (Mix_OpenAudio(want.rate, MIX_DEFAULT_FORMAT, want.channels, want.buffer) < 0) {
         std::cerr << "Mix_OpenAudio Error: " << Mix_GetError() << std::endl;
+        // 選んだ形式で開けなければ旧来の形式で開き直す
+        want = AudioCalibrator::Candidate{22050, 1, 512};
+        if (Mix_OpenAudio(want.rate, MIX_DEFAULT_FORMAT, want.channels, want.buffer) < 0)
+            std::cerr << "Mix_OpenAudio Error: " << Mix_GetError() << std::endl;
+    }
+    audioOpened = true;
+
+    // 実際に開けたフォーマットでミキサーを構成する (チャンネル数は変更されうる)
+    int freq = want.rate, ch = want.channels;
+    Uint16 fmt = MIX_DEFAULT_FORMAT;
+    Mix_QuerySpec(&freq, &fmt, &ch);
+    mixer.configure(freq, ch);
+    preview.configure(freq, ch, PREVIEW_GAIN);
+    audioSettings.rate     = freq;
+    audioSettings.channels = ch;
+    audioSettings.buffer   = want.buffer;
+    Config::AUDIO_RATE     = freq;
+    Config::AUDIO_CHANNELS = ch;
+    Config::AUDIO_BUFFER   = want.buffer;
+}
+
+// ★1曲だけの途切れ (読み込みの重なり・OS の割り込み) で恒久的に倍にしないよう、
+//   途切れた曲が UNDERRUN_SONGS 曲続いたら広げ、途切れない曲が CLEAN_SONGS 曲続いたら半分に戻す
+static constexpr int UNDERRUN_SONGS = 3;
+static constexpr int CLEAN_SONGS    = 10;
+static constexpr int BASE_BUFFER    = 256;
+
+void SoundManager::adaptBufferAfterSong() {
+    if (!Config::AUDIO_AUTO) return;
+    uint64_t underruns = mixer.getStats().underruns;
+    int& streak = Config::AUDIO_BUFFER_STREAK;
+
+    if (underruns > 0) {
+        streak = streak > 0 ? streak + 1 : 1;
+        if (streak < UNDERRUN_SONGS) return;
+        streak = 0;
+        int next = std::min(4096, audioSettings.buffer * 2);
+        if (next <= Config::AUDIO_MIN_BUFFER) return;
+        Config::AUDIO_MIN_BUFFER = next;
+        std::cout << "Audio: underruns in " << UNDERRUN_SONGS << " songs in a row (" << underruns
+                  << " at " << audioSettings.buffer << " frames), next launch will use at least "
+                  << next << std::endl;
+        return;
     }
 
-    Mix_AllocateChannels(256);
-    std::cout << "SoundManager Initialized." << std::endl;
+    streak = streak < 0 ? streak - 1 : -1;
+    if (-streak < CLEAN_SONGS) return;
+    streak = 0;
+    if (Config::AUDIO_MIN_BUFFER <= BASE_BUFFER) return;
+    Config::AUDIO_MIN_BUFFER = std::max(BASE_BUFFER, Config::AUDIO_MIN_BUFFER / 2);
+    std::cout << "Audio: " << CLEAN_SONGS << " songs without underruns, next launch will allow "
+              << Config::AUDIO_MIN_BUFFER << " frames" << std::endl;
+}
+
+void SoundManager::mixCallback(void* udata, Uint8* stream, int len) {
+    SoundManager* self = static_cast<SoundManager*>(udata);
+    int frames = len / (int)(sizeof(int16_t) * self->mixer.getChannels());
+    self->mixer.mix(reinterpret_cast<int16_t*>(stream), frames);
+    self->preview.mixInto(reinterpret_cast<int16_t*>(stream), frames * self->mixer.getChannels());
+}
+
+void SoundManager::withAudioStopped(const std::function<void()>& fn) {
+    // Mix_HookMusic は内部でオーディオデバイスをロックする。ロックはコールバック実行中は
+    // 取れないため、フックを外して戻った時点でコールバックは走っていないことが保証される。
+    Mix_HookMusic(nullptr, nullptr);
+    fn();
+    mixer.markDiscontinuity(); // 止めていた間を途切れとして数えない
+    Mix_HookMusic(&SoundManager::mixCallback, this);
 }
 
 void SoundManager::preloadBoxIndex(const std::string& rootPath, const std::string& bmsonName) {
+    // ★同じ譜面 (リトライ・同じ .boxwav を共有する別難易度) なら索引をそのまま使う。
+    //   パート2以降の probe で入る SDL_Delay(2500) も丸ごと省ける。
+    std::string firstPart = rootPath + (rootPath.empty() || rootPath.back() == '/' ? "" : "/") + bmsonName + ".boxwav";
+    std::string indexKey  = rootPath + "|" + bmsonName + "|" + makeCacheKey(firstPart, "", 0, 0);
+    if (!boxIndex.empty() && indexKey == boxIndexKey) {
+        std::cout << "BoxWav index reused (" << boxIndex.size() << " entries)" << std::endl;
+        return;
+    }
     boxIndex.clear();
+    boxIndexKey = indexKey;
     int partIdx = 1;
     while (true) {
         std::string suffix = (partIdx == 1) ? "" : std::to_string(partIdx);
@@ -33,60 +162,690 @@ void SoundManager::preloadBoxIndex(const std::string& rootPath, const std::strin
             SDL_Delay(2500);
         }
 
-        std::ifstream ifs(pckPath, std::ios::binary);
-        if (!ifs) break;
+        // ★パートはここで1回だけ開き、以降のロードもこのマッピングを使う
+        MappedFile* part = mapPart(pckPath);
+        if (!part) break;
 
-        uint32_t count, d1, d2;
-        if (!ifs.read((char*)&count, 4)) break;
-        ifs.read((char*)&d1, 4);
-        ifs.read((char*)&d2, 4);
+        // v2 は先頭パートの目次に全パートの全エントリが載っているので、ここで終わり
+        if (partIdx == 1 && loadIndexV2(rootPath, bmsonName, *part, pckPath)) return;
 
+        const uint8_t* header = part->view(0, 12);
+        if (!header) break;
+        uint32_t count;
+        memcpy(&count, header, 4); // d1, d2 (header + 4, + 8) は未使用
+
+        uint64_t pos = 12;
         for (uint32_t i = 0; i < count; ++i) {
-            char nameBuf[32];
+            const uint8_t* rec = part->view(pos, 36);
+            if (!rec) break;
             uint32_t fSize;
-            if (!ifs.read(nameBuf, 32)) break;
-            if (!ifs.read((char*)&fSize, 4)) break;
+            memcpy(&fSize, rec + 32, 4);
+            pos += 36;
+            // サイズがファイル末尾を越えるエントリは壊れているので以降を捨てる
+            if (fSize > part->size() - pos) break;
 
-            std::string fileName(nameBuf, strnlen(nameBuf, 32));
-            boxIndex[fileName] = { pckPath, (uint32_t)ifs.tellg(), fSize };
-            ifs.seekg(fSize, std::ios::cur);
+            std::string fileName((const char*)rec, strnlen((const char*)rec, 32));
+            boxIndex[fileName] = { pckPath, (uint32_t)pos, fSize };
+            pos += fSize;
         }
         partIdx++;
         if (partIdx > 128) break;
     }
 }
 
+// ============================================================
+//  loadIndexV2 — boxwav v2 の目次読み込み
+//  ヘッダと目次を1回ずつ view するだけ。パート数はヘッダにあるので
+//  name2.boxwav… を試しに開く必要も、SDL_Delay で待つ必要もない。
+// ============================================================
+bool SoundManager::loadIndexV2(const std::string& rootPath, const std::string& bmsonName,
+                               MappedFile& first, const std::string& firstPath) {
+    const uint8_t* hp = first.view(0, sizeof(BoxWav::HeaderV2));
+    if (!hp) return false;
+    BoxWav::HeaderV2 header;
+    if (!BoxWav::readHeaderV2(hp, header)) return false;
+    if (!BoxWav::isSupportedV2(header)) {
+        std::cout << "BoxWav: unsupported v2 header in " << firstPath << std::endl;
+        return true; // v1 として読むと壊れた索引になるので、空のまま返す
+    }
+
+    uint64_t tocBytes = (uint64_t)header.entryCount * sizeof(BoxWav::TocEntryV2);
+    if (tocBytes > UINT32_MAX) return true;
+    const uint8_t* toc = first.view(header.tocOffset, (uint32_t)tocBytes);
+    if (!toc) return true;
+
+    // パートのパスとサイズ (範囲チェック用)
+    std::vector<std::string> partPaths(header.partCount);
+    std::vector<uint64_t>    partSizes(header.partCount, 0);
+    std::string base = rootPath + (rootPath.empty() || rootPath.back() == '/' ? "" : "/") + bmsonName;
+    for (uint32_t p = 0; p < header.partCount; ++p) {
+        partPaths[p] = (p == 0) ? firstPath : BoxWav::partPath(base, p);
+        MappedFile* part = (p == 0) ? &first : mapPart(partPaths[p]);
+        partSizes[p] = part ? part->size() : 0;
+    }
+
+    boxIndex.reserve(header.entryCount);
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        BoxWav::TocEntryV2 e;
+        memcpy(&e, toc + (size_t)i * sizeof(e), sizeof(e));
+        if (!BoxWav::entryUsable(e, header, partSizes.data())) continue;
+
+        BoxEntry entry;
+        entry.pckPath  = partPaths[e.part];
+        entry.offset   = (uint32_t)e.offset;
+        entry.size     = e.size;
+        entry.format   = e.format;
+        entry.channels = e.channels;
+        entry.rate     = e.sampleRate;
+        boxIndex[std::string(e.name, strnlen(e.name, BoxWav::NAME_LEN))] = std::move(entry);
+    }
+
+    std::cout << "BoxWav v2: " << boxIndex.size() << " entries in " << header.partCount << " parts ("
+              << header.sampleRate << "Hz " << header.channels << "ch)" << std::endl;
+    return true;
+}
+
+// ============================================================
+//  デコード済みキャッシュ
+// ============================================================
+
+std::string SoundManager::makeCacheKey(const std::string& path, const std::string& entryName,
+                                       uint32_t offset, uint32_t size) {
+    // 内容タグ: ファイルのサイズと更新時刻。stat は1曲につき1ファイル1回だけ
+    auto it = fileTagCache.find(path);
+    if (it == fileTagCache.end()) {
+        uint64_t tag = 0;
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0) {
+            tag = ((uint64_t)st.st_size << 32) ^ (uint64_t)st.st_mtime;
+        }
+        it = fileTagCache.emplace(path, tag).first;
+    }
+    return path + "|" + entryName + "|" + std::to_string(offset) + "|" + std::to_string(size)
+         + "|" + std::to_string(it->second);
+}
+
+bool SoundManager::acquireCached(const std::string& key, uint32_t id) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = decodedCache.find(key);
+    if (it == decodedCache.end()) return false;
+
+    CacheEntry& e = it->second;
+    // ★保持形式 (ADPCM / PCM) がこの譜面での使われ方と合わなければミス扱いにしてデコードし直す。
+    //   別の譜面で BGM だけだった音が、この譜面ではプレイヤーレーンでよく鳴る、など。
+    //   今の譜面が既に使っているエントリはそのまま使う (同じキーを2つは持てない)
+    if (!e.active && chunkAdpcm.count(e.chunk) != (size_t)wantsAdpcm(id, e.chunk)) {
+        cacheLru.erase(e.lruIt);
+        releaseChunkLocked(e.chunk, e.bytes);
+        decodedCache.erase(it);
+        return false;
+    }
+    if (!e.active) cacheLru.splice(cacheLru.begin(), cacheLru, e.lruIt);
+    cacheHits++;
+    // 予算に入らなくても登録しないだけ (デコードし直しても同じなので、ヒット扱いで終える)
+    makeResidentLocked(key, e, id);
+    trimCache(cacheBudget()); // 追い出した常駐音の分
+    return true;
+}
+
+void SoundManager::insertCached(const std::string& key, uint32_t id, Mix_Chunk* chunk, uint64_t sourceBytes,
+                                uint32_t onsetFrames, uint32_t untrimmedLen, uint32_t adpcmSamples) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (untrimmedLen > 0) chunkTrims[chunk] = TrimInfo{onsetFrames, untrimmedLen};
+    if (adpcmSamples > 0) chunkAdpcm[chunk] = adpcmSamples;
+    uint64_t bytes = (uint64_t)chunk->alen + sizeof(Mix_Chunk);
+
+    cacheLru.push_front(key);
+    CacheEntry e;
+    e.chunk       = chunk;
+    e.bytes       = bytes;
+    e.sourceBytes = sourceBytes;
+    e.active      = false;
+    e.lruIt       = cacheLru.begin();
+    CacheEntry& stored = decodedCache[key] = e;
+    retainChunkLocked(chunk, bytes);
+    cacheMisses++;
+    // 予算に入らない音もキャッシュには残す (次に余裕のある譜面で使えるように)。
+    // ★登録の後で削る: 予算に入らなかった音・追い出した常駐音もここで予算まで解放される
+    makeResidentLocked(key, stored, id);
+    trimCache(cacheBudget());
+}
+
+bool SoundManager::insertAlias(const std::string& primaryKey, const std::string& key, uint32_t id,
+                               uint64_t sourceBytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // 元のエントリが (予算外でキャッシュから削られて) 無くなっていれば共有できない
+    auto pe = decodedCache.find(primaryKey);
+    if (pe == decodedCache.end()) return false;
+    if (decodedCache.count(key)) return false;
+
+    cacheLru.push_front(key);
+    CacheEntry e;
+    e.chunk       = pe->second.chunk;
+    e.bytes       = pe->second.bytes;
+    e.sourceBytes = sourceBytes;
+    e.active      = false;
+    e.lruIt       = cacheLru.begin();
+    CacheEntry& stored = decodedCache[key] = e;
+    retainChunkLocked(stored.chunk, stored.bytes);
+    dedupCount++;
+    makeResidentLocked(key, stored, id);
+    trimCache(cacheBudget());
+    return true;
+}
+
+void SoundManager::retainChunkLocked(Mix_Chunk* chunk, uint64_t bytes) {
+    if (chunkRefs[chunk]++ == 0) cacheBytes += bytes;
+}
+
+void SoundManager::releaseChunkLocked(Mix_Chunk* chunk, uint64_t bytes) {
+    auto it = chunkRefs.find(chunk);
+    if (it == chunkRefs.end() || --it->second > 0) return;
+    chunkRefs.erase(it);
+    chunkTrims.erase(chunk);
+    chunkAdpcm.erase(chunk);
+    Mix_FreeChunk(chunk);
+    cacheBytes -= std::min<uint64_t>(cacheBytes.load(), bytes);
+}
+
+bool SoundManager::makeResidentLocked(const std::string& key, CacheEntry& e, uint32_t id) {
+    // ★同じ内容のチャンクが既にこの譜面で常駐していれば、追加のメモリは要らない
+    bool shared = songChunkRefs.count(e.chunk) > 0;
+    uint64_t pcmBytes = pcmBytesLocked(e.chunk);
+    if (!admitLocked(id, shared ? 0 : e.chunk->alen, pcmBytes)) return false;
+
+    uint32_t& refs = songChunkRefs[e.chunk];
+    if (refs++ == 0) {
+        currentTotalMemory += e.chunk->alen;
+        chargeSavingsLocked(e.chunk, true);
+    } else {
+        dedupBytes += e.chunk->alen;
+    }
+
+    activateLocked(key, e);
+    auto old = residents.find(id);
+    if (old != residents.end()) residentOrder.erase(old->second.orderIt);
+    residents[id] = Resident{key, e.chunk->alen, e.chunk,
+                             residentOrder.emplace(importance(id, pcmBytes), id)};
+    // 非同期ロード中はエントリが登録済みなので値だけ書き換える (マップの構造は変えない)
+    auto it = sounds.find(id);
+    SoundSlot& slot = (it != sounds.end()) ? it->second : sounds[id];
+    auto tr = chunkTrims.find(e.chunk);
+    auto ad = chunkAdpcm.find(e.chunk);
+    slot.onsetFrames.store(tr != chunkTrims.end() ? tr->second.onsetFrames : 0, std::memory_order_relaxed);
+    slot.adpcmSamples.store(ad != chunkAdpcm.end() ? ad->second : 0, std::memory_order_relaxed);
+    slot.chunk.store(e.chunk, std::memory_order_release);
+    return true;
+}
+
+void SoundManager::chargeSavingsLocked(Mix_Chunk* chunk, bool add) {
+    auto charge = [add](std::atomic<uint32_t>& count, std::atomic<uint64_t>& bytes, uint64_t saved) {
+        if (add) {
+            count++;
+            bytes += saved;
+        } else {
+            count -= std::min<uint32_t>(count, 1);
+            bytes -= std::min<uint64_t>(bytes, saved);
+        }
+    };
+    // 圧縮した音の「切った後の PCM の長さ」は展開後のサンプル数から求める
+    auto ad = chunkAdpcm.find(chunk);
+    uint64_t pcmLen = ad != chunkAdpcm.end() ? (uint64_t)ad->second * sizeof(int16_t) : chunk->alen;
+    auto tr = chunkTrims.find(chunk);
+    if (tr != chunkTrims.end()) charge(trimmedSounds, trimSavedBytes, tr->second.untrimmedLen - pcmLen);
+    if (ad != chunkAdpcm.end()) charge(adpcmSounds, adpcmSavedBytes, pcmLen - chunk->alen);
+}
+
+void SoundManager::completeJob(std::vector<LoadJob>& jobs, uint32_t i, Mix_Chunk* chunk,
+                               std::unordered_map<uint32_t, std::vector<uint32_t>>& waiting) {
+    LoadJob& job = jobs[i];
+    job.done = true;
+    if (job.stream) {
+        createStream(job);
+        return;
+    }
+    if (job.dupOf >= 0) {
+        // 重複: 元のジョブのチャンクを共有する。元がまだなら届くまで預ける
+        const LoadJob& primary = jobs[job.dupOf];
+        if (!primary.done) waiting[(uint32_t)job.dupOf].push_back(i);
+        else if (primary.decoded) insertAlias(primary.key, job.key, job.id, job.box.size);
+        return;
+    }
+
+    job.decoded = chunk != nullptr;
+    if (chunk) insertCached(job.key, job.id, chunk, job.box.size, job.onsetFrames, job.untrimmedLen, job.adpcmSamples);
+    auto w = waiting.find(i);
+    if (w == waiting.end()) return;
+    if (job.decoded) {
+        for (uint32_t d : w->second) insertAlias(job.key, jobs[d].key, jobs[d].id, jobs[d].box.size);
+    }
+    waiting.erase(w);
+}
+
+// ============================================================
+//  WAV Memory の予算管理
+// ============================================================
+void SoundManager::setSoundUsage(const std::vector<PlayableNote>& notes) {
+    soundUsage.clear();
+    for (const auto& n : notes) {
+        SoundUsage& u = soundUsage[n.soundId];
+        u.uses++;
+        if (!n.isBGM) u.player = true;
+    }
+}
+
+uint64_t SoundManager::pcmBytesLocked(Mix_Chunk* chunk) const {
+    auto tr = chunkTrims.find(chunk);
+    if (tr != chunkTrims.end()) return tr->second.untrimmedLen;
+    auto ad = chunkAdpcm.find(chunk);
+    if (ad != chunkAdpcm.end()) return (uint64_t)ad->second * sizeof(int16_t);
+    return chunk->alen;
+}
+
+double SoundManager::importance(uint32_t id, uint64_t pcmBytes) const {
+    auto it = soundUsage.find(id);
+    if (it == soundUsage.end()) return 0.0; // 譜面で使われない音
+    double bytesPerSec = (double)mixer.getSampleRate() * mixer.getChannels() * sizeof(int16_t);
+    double sec   = std::max(0.01, (double)pcmBytes / bytesPerSec);
+    double score = it->second.uses / sec;
+    // 区分を跨いで逆転しないよう、プレイヤーレーンの音は桁を上げる
+    return it->second.player ? 1e12 + score : 1.0 + score;
+}
+
+bool SoundManager::admitLocked(uint32_t id, uint64_t bytes, uint64_t pcmBytes) {
+    auto drop = [&](uint32_t did, uint64_t dbytes, bool evicted) {
+        DroppedSound d;
+        auto nm = soundNames.find(did);
+        auto us = soundUsage.find(did);
+        d.name    = nm != soundNames.end() ? nm->second : std::to_string(did);
+        d.bytes   = dbytes;
+        d.player  = us != soundUsage.end() && us->second.player;
+        d.evicted = evicted;
+        droppedSounds.push_back(std::move(d));
+    };
+
+    if (bytes == 0 || currentTotalMemory + bytes <= MAX_WAV_MEMORY) return true;
+    if (residentLocked) {
+        drop(id, bytes, false);
+        return false;
+    }
+
+    // 自分より重要度の低い常駐音を、低い順に空けて足りるか確かめてから追い出す。
+    // residentOrder は重要度順に保ってあるので、先頭から必要な分だけ見ればよい
+    double mine = importance(id, pcmBytes);
+
+    // 共有チャンクは最後の参照を外した時にだけ空く
+    uint64_t need  = currentTotalMemory + bytes - MAX_WAV_MEMORY;
+    uint64_t freed = 0;
+    size_t   count = 0;
+    std::unordered_map<Mix_Chunk*, uint32_t> left;
+    for (auto vt = residentOrder.begin(); vt != residentOrder.end() && vt->first < mine && freed < need; ++vt) {
+        const Resident& r = residents[vt->second];
+        count++;
+        auto [lt, fresh] = left.emplace(r.chunk, 0);
+        if (fresh) lt->second = songChunkRefs[r.chunk];
+        if (--lt->second == 0) freed += r.bytes;
+    }
+    if (freed < need) {
+        drop(id, bytes, false);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t rid = residentOrder.begin()->second;
+        residentOrder.erase(residentOrder.begin());
+        Resident& r  = residents[rid];
+        // まだ1音も鳴らしていないので、参照を外すだけでよい (チャンクはキャッシュに戻る)
+        auto snd = sounds.find(rid);
+        if (snd != sounds.end()) snd->second.chunk.store(nullptr, std::memory_order_release);
+        auto sr = songChunkRefs.find(r.chunk);
+        if (sr != songChunkRefs.end() && --sr->second == 0) {
+            songChunkRefs.erase(sr);
+            // 同じキーを別の id がまだ使っていれば追い出し候補に戻さない (チャンクの参照が無くなった時だけ)
+            auto ce = decodedCache.find(r.key);
+            if (ce != decodedCache.end()) deactivateLocked(r.key, ce->second);
+            currentTotalMemory -= std::min<uint64_t>(currentTotalMemory, r.bytes);
+            chargeSavingsLocked(r.chunk, false);
+        } else {
+            dedupBytes -= std::min<uint64_t>(dedupBytes, r.bytes);
+        }
+        drop(rid, r.bytes, true);
+        residents.erase(rid);
+    }
+    return true;
+}
+
+void SoundManager::lockResidents() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    residentLocked = true;
+    if (droppedSounds.empty()) return;
+    uint64_t total = 0;
+    for (const auto& d : droppedSounds) total += d.bytes;
+    std::cout << "WAV Memory: dropped " << droppedSounds.size() << " sounds (" << (total >> 10)
+              << "KB) over the " << (MAX_WAV_MEMORY >> 20) << "MB budget" << std::endl;
+}
+
+std::vector<SoundManager::DroppedSound> SoundManager::getDroppedSounds() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return droppedSounds;
+}
+
+void SoundManager::activateLocked(const std::string& key, CacheEntry& e) {
+    if (e.active) return;
+    e.active = true;
+    cacheLru.erase(e.lruIt);
+    activeCacheKeys.push_back(key);
+}
+
+void SoundManager::deactivateLocked(const std::string& key, CacheEntry& e) {
+    if (!e.active) return;
+    e.active = false;
+    cacheLru.push_front(key);
+    e.lruIt = cacheLru.begin();
+}
+
+void SoundManager::releaseActiveCache() {
+    for (const auto& key : activeCacheKeys) {
+        auto it = decodedCache.find(key);
+        if (it != decodedCache.end()) deactivateLocked(key, it->second);
+    }
+    activeCacheKeys.clear();
+}
+
+uint64_t SoundManager::cacheBudget() const {
+    // ★キャッシュ全体 (今の譜面が使っている分を含む) を WAV Memory の予算の内側に収める。
+    //   今の譜面の分は予算 (admitLocked) で抑えてあるので、残りを使っていないチャンクに回す
+    return std::min<uint64_t>((uint64_t)std::max(0, Config::SOUND_CACHE_MB) * 1024 * 1024, MAX_WAV_MEMORY);
+}
+
+void SoundManager::trimCache(uint64_t budget) {
+    // cacheLru には今の譜面が参照していないエントリしか無いので、末尾 (最も長く使われていない)
+    // から順に解放するだけでよい。1回の呼び出しは解放した数に比例する
+    while (cacheBytes > budget && !cacheLru.empty()) {
+        auto ce = decodedCache.find(cacheLru.back());
+        cacheLru.pop_back();
+        if (ce == decodedCache.end()) continue;
+        releaseChunkLocked(ce->second.chunk, ce->second.bytes); // 同じ内容の別名が残っていれば解放しない
+        decodedCache.erase(ce);
+    }
+}
+
+void SoundManager::purgeCache() {
+    trimCache(0);
+}
+
+// ============================================================
+//  .boxwav パートのマッピング
+// ============================================================
+
+MappedFile* SoundManager::mapPart(const std::string& path) {
+    auto it = mappedParts.find(path);
+    if (it != mappedParts.end()) return it->second.get();
+
+    auto part = std::make_unique<MappedFile>();
+    if (!part->open(path)) return nullptr;
+    MappedFile* raw = part.get();
+    mappedParts.emplace(path, std::move(part));
+    return raw;
+}
+
+void SoundManager::releaseMappings() {
+    uint64_t mappedBytes = 0, stagingPeak = 0;
+    for (const auto& [path, part] : mappedParts) {
+        mappedBytes += part->size();
+        stagingPeak  = std::max(stagingPeak, part->getStagingPeak());
+    }
+    if (!mappedParts.empty()) {
+        std::cout << "BoxWav: released " << mappedParts.size() << " parts (" << (mappedBytes >> 20)
+                  << "MB mapped, staging peak " << (stagingPeak >> 10) << "KB)" << std::endl;
+    }
+    mappedParts.clear();
+}
+
+Mix_Chunk* SoundManager::decodeBoxEntry(MappedFile& part, const BoxEntry& entry) {
+    const uint8_t* bytes = part.view(entry.offset, entry.size);
+    if (!bytes) return nullptr;
+
+    // v2 の変換済み PCM: デコーダを通さない
+    if (entry.format == BoxWav::FORMAT_S16) {
+        return chunkFromPcm(bytes, entry.size, entry.channels, entry.rate);
+    }
+
+    // ★マップ上のバイト列をそのまま読む。旧実装の
+    //   SDL_malloc → read → SDL_RWFromMem → SDL_free の一時コピーは不要になった。
+    //   (どちらのデコーダも自前のバッファへ書き出すので、
+    //    返ったチャンクはマッピングを解放した後も有効)
+    return decodeBytes(bytes, entry.size);
+}
+
+Mix_Chunk* SoundManager::decodeBytes(const uint8_t* bytes, uint32_t size) {
+    uint64_t t0 = SDL_GetPerformanceCounter();
+    Mix_Chunk* chunk = nullptr;
+
+    // ★PCM WAV は SDL_AudioCVT を通さず、最終バッファへ1回で書く
+    WavDecoder::Info info;
+    if (WavDecoder::parse(bytes, size, info)) {
+        const int rate = mixer.getSampleRate();
+        const int ch   = mixer.getChannels();
+        uint32_t  len  = WavDecoder::outputFrames(info, rate) * ch * (uint32_t)sizeof(int16_t);
+        Uint8*    buf  = len ? (Uint8*)SDL_malloc(len) : nullptr;
+        if (buf && WavDecoder::convert(info, reinterpret_cast<int16_t*>(buf), rate, ch)) {
+            chunk = wrapPcm(buf, len);
+            if (chunk) fastDecodes++;
+        } else if (buf) {
+            SDL_free(buf);
+        }
+    }
+
+    // OGG / FLAC / ADPCM WAV などは従来どおり SDL_mixer に任せる。
+    // ★デコードワーカーは複数あるので、SDL_mixer に入るのは1度に1スレッドだけにする
+    if (!chunk) {
+        SDL_RWops* rw = SDL_RWFromConstMem(bytes, (int)size);
+        if (rw) {
+            std::lock_guard<std::mutex> lock(sdlDecodeMutex);
+            chunk = Mix_LoadWAV_RW(rw, 1);
+        }
+        if (chunk) sdlDecodes++;
+    }
+
+    decodeInBytes += size;
+    decodeTicks   += SDL_GetPerformanceCounter() - t0;
+    return chunk;
+}
+
+Mix_Chunk* SoundManager::decodeExternal(const std::string& path, uint64_t& fileSize) {
+    MappedFile file;
+    fileSize = 0;
+    if (!file.open(path)) return nullptr;
+    fileSize = file.size();
+    if (fileSize > UINT32_MAX) return nullptr;
+    const uint8_t* bytes = file.view(0, (uint32_t)fileSize);
+    return bytes ? decodeBytes(bytes, (uint32_t)fileSize) : nullptr;
+}
+
+Mix_Chunk* SoundManager::wrapPcm(Uint8* buf, uint32_t len) {
+    Mix_Chunk* chunk = Mix_QuickLoad_RAW(buf, len);
+    if (!chunk) {
+        SDL_free(buf);
+        return nullptr;
+    }
+    chunk->allocated = 1; // Mix_FreeChunk に abuf も解放させる
+    return chunk;
+}
+
+// ============================================================
+//  trimSilence — 前後の無音の切り落とし
+//  フレーム単位で切り、先頭から切ったフレーム数を onsetFrames に返す。
+//  バッファは前に詰めてから縮める (切った分は実際にヒープへ返る)。
+//  数 ms 分しか減らない音は、詰め直しの手間に見合わないのでそのまま使う。
+// ============================================================
+void SoundManager::trimSilence(Mix_Chunk* chunk, uint32_t& onsetFrames, uint32_t& untrimmedLen) {
+    onsetFrames  = 0;
+    untrimmedLen = 0;
+    if (Config::SILENCE_TRIM_DB >= 0 || !chunk->allocated || !chunk->abuf) return;
+
+    const uint32_t ch         = (uint32_t)mixer.getChannels();
+    const uint32_t frameBytes = ch * (uint32_t)sizeof(int16_t);
+    const uint32_t frames     = chunk->alen / frameBytes;
+    if (frames == 0) return;
+
+    size_t first = 0, last = 0;
+    const int16_t* pcm = reinterpret_cast<const int16_t*>(chunk->abuf);
+    if (!SilenceTrimmer::findAudible(pcm, (size_t)frames * ch, SilenceTrimmer::thresholdFromDb(Config::SILENCE_TRIM_DB),
+                                     first, last)) {
+        last = first = 0; // 全て無音: 1フレームだけ残す (空のチャンクはミキサーが受け付けない)
+    }
+    uint32_t head = (uint32_t)(first / ch);
+    uint32_t keep = (uint32_t)(last / ch) + 1 - head;
+    uint32_t len  = keep * frameBytes;
+    const uint32_t minSaving = (uint32_t)mixer.getSampleRate() / 200 * frameBytes; // 5ms
+    if (chunk->alen - len < minSaving) return;
+
+    if (head > 0) std::memmove(chunk->abuf, chunk->abuf + (size_t)head * frameBytes, len);
+    if (Uint8* shrunk = (Uint8*)SDL_realloc(chunk->abuf, len)) chunk->abuf = shrunk;
+    untrimmedLen = chunk->alen;
+    onsetFrames  = head;
+    chunk->alen  = len;
+}
+
+bool SoundManager::shouldCompress(uint32_t id) const {
+    if (!Config::KEYSOUND_ADPCM) return false;
+    auto it = soundUsage.find(id);
+    if (it == soundUsage.end()) return true; // 譜面で鳴らない音
+    return !it->second.player || it->second.uses <= (uint32_t)std::max(0, Config::ADPCM_RARE_USES);
+}
+
+bool SoundManager::compressible(const Mix_Chunk* chunk) const {
+    const uint32_t frames = chunk->alen / (uint32_t)(mixer.getChannels() * sizeof(int16_t));
+    // 1ブロックに満たない短い音は縮めてもほとんど変わらない
+    return chunk->allocated && frames >= AdpcmCodec::BLOCK_FRAMES;
+}
+
+bool SoundManager::wantsAdpcm(uint32_t id, Mix_Chunk* chunk) const {
+    if (!shouldCompress(id)) return false;
+    // 既に ADPCM なら展開後の長さは十分。PCM なら compressChunk が縮める長さか
+    return chunkAdpcm.count(chunk) > 0 || compressible(chunk);
+}
+
+uint32_t SoundManager::compressChunk(Mix_Chunk* chunk) {
+    const int      ch      = mixer.getChannels();
+    const uint32_t frames  = chunk->alen / (uint32_t)(ch * sizeof(int16_t));
+    if (!compressible(chunk)) return 0;
+
+    size_t bytes = AdpcmCodec::encodedBytes(frames, ch);
+    Uint8* packed = (Uint8*)SDL_malloc(bytes);
+    if (!packed) return 0;
+    AdpcmCodec::encode(reinterpret_cast<const int16_t*>(chunk->abuf), frames, ch, packed);
+    SDL_free(chunk->abuf);
+    chunk->abuf = packed;
+    chunk->alen = (Uint32)bytes; // 以降 alen は圧縮後のサイズ (WAV Memory もこれで数える)
+    return frames * (uint32_t)ch;
+}
+
+SoundManager::TrimReport SoundManager::getTrimReport(const std::vector<PlayableNote>& notes, bool includeBgm) {
+    TrimReport r;
+    r.trimmedSounds = trimmedSounds.load(std::memory_order_relaxed);
+    r.savedBytes    = trimSavedBytes.load(std::memory_order_relaxed);
+    r.adpcmSounds     = adpcmSounds.load(std::memory_order_relaxed);
+    r.adpcmSavedBytes = adpcmSavedBytes.load(std::memory_order_relaxed);
+
+    // 発音ごとのボイス占有時間の合計 ÷ 曲の長さ。オンセットの遅延中もボイスは埋まっているので
+    // 切った後の長さ = オンセット + 残した長さ (= 末尾を切った分だけ短くなる)
+    const double framesPerMs = mixer.getSampleRate() / 1000.0;
+    const double frameBytes  = (double)mixer.getChannels() * sizeof(int16_t);
+    double before = 0.0, after = 0.0, endMs = 0.0;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (const auto& n : notes) {
+        if (n.isBGM && !includeBgm) continue;
+        auto it = residents.find(n.soundId);
+        if (it == residents.end()) continue;
+        Mix_Chunk* chunk = it->second.chunk;
+        auto ad = chunkAdpcm.find(chunk);
+        double pcmLen = ad != chunkAdpcm.end() ? (double)ad->second * sizeof(int16_t) : (double)chunk->alen;
+        double full = pcmLen / frameBytes / framesPerMs;
+        double used = full;
+        auto tr = chunkTrims.find(chunk);
+        if (tr != chunkTrims.end()) {
+            full = tr->second.untrimmedLen / frameBytes / framesPerMs;
+            used = tr->second.onsetFrames / framesPerMs + used;
+        }
+        before += full;
+        after  += used;
+        endMs   = std::max(endMs, n.target_ms + full);
+    }
+    if (endMs > 0.0) {
+        r.voicesBefore = before / endMs;
+        r.voicesAfter  = after / endMs;
+    }
+    return r;
+}
+
+void SoundManager::logDecodeStats() {
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    double   sec  = freq ? (double)decodeTicks.load() / (double)freq : 0.0;
+    double   mb   = (double)decodeInBytes.load() / (1024.0 * 1024.0);
+    std::cout << "WAV decode: " << fastDecodes << " fast (" << WavDecoder::kernelName() << "), "
+              << sdlDecodes << " via SDL_mixer, " << mb << "MB in " << (sec * 1000.0) << "ms ("
+              << (sec > 0.0 ? mb / sec : 0.0) << " MB/s)" << std::endl;
+    fastDecodes   = 0;
+    sdlDecodes    = 0;
+    decodeInBytes = 0;
+    decodeTicks   = 0;
+}
+
+Mix_Chunk* SoundManager::chunkFromPcm(const uint8_t* pcm, uint32_t bytes, uint16_t channels, uint32_t rate) {
+    // チャンクはキャッシュに残ってマッピングより長生きするので、マップを直接指さずにコピーする
+    const int devRate = mixer.getSampleRate();
+    const int devCh   = mixer.getChannels();
+    Uint8*    buf     = nullptr;
+    uint32_t  len     = 0;
+
+    if ((int)rate == devRate && (int)channels == devCh) {
+        buf = (Uint8*)SDL_malloc(bytes);
+        if (!buf) return nullptr;
+        memcpy(buf, pcm, bytes);
+        len = bytes;
+    } else {
+        // パック時と違う形式でデバイスが開かれた場合だけ SDL に変換させる
+        SDL_AudioCVT cvt;
+        if (SDL_BuildAudioCVT(&cvt, AUDIO_S16LSB, (Uint8)channels, (int)rate,
+                              AUDIO_S16SYS, (Uint8)devCh, devRate) < 0) return nullptr;
+        cvt.len = (int)bytes;
+        buf = (Uint8*)SDL_malloc((size_t)bytes * cvt.len_mult);
+        if (!buf) return nullptr;
+        memcpy(buf, pcm, bytes);
+        cvt.buf = buf;
+        if (SDL_ConvertAudio(&cvt) < 0) {
+            SDL_free(buf);
+            return nullptr;
+        }
+        len = (uint32_t)cvt.len_cvt;
+    }
+
+    return wrapPcm(buf, len);
+}
+
 void SoundManager::loadSingleSound(const std::string& filename, const std::string& rootPath, const std::string& bmsonName) {
     uint32_t id = getHash(filename);
     if (sounds.find(id) != sounds.end()) return;
+    soundNames[id] = filename;
 
     if (boxIndex.count(filename)) {
         auto& entry = boxIndex[filename];
+        std::string key = makeCacheKey(entry.pckPath, filename, entry.offset, entry.size);
+        if (acquireCached(key, id)) return;
 
-        std::ifstream ifs(entry.pckPath, std::ios::binary);
-        if (ifs) {
-            uint8_t* tempBuf = (uint8_t*)SDL_malloc(entry.size);
-            if (tempBuf) {
-                ifs.seekg(entry.offset);
-                ifs.read((char*)tempBuf, entry.size);
-
-                // ★修正：freesrc=0 にして RWops を手動解放する。
-                // freesrc=1 は SDL_RWops 構造体のみを解放し、SDL_RWFromMem が指す
-                // tempBuf の元メモリは解放しない。これがメモリリークの根本原因だった。
-                // Mix_LoadWAV_RW(PCM WAV) は内部でデータをコピーするため、
-                // SDL_RWclose 後に tempBuf を SDL_free しても安全。
-                SDL_RWops* rw = SDL_RWFromMem(tempBuf, (int)entry.size);
-                Mix_Chunk* chunk = Mix_LoadWAV_RW(rw, 0); // ← 0 に変更
-                SDL_RWclose(rw);                           // ← 手動で close
-
-                if (chunk) {
-                    sounds[id] = chunk;
-                    currentTotalMemory += entry.size;
-                } else {
-                    // デバッグ用：ロード失敗の原因を出力
-                    // fprintf(stderr, "Mix_LoadWAV_RW failed for %s: %s\n", filename.c_str(), Mix_GetError());
-                }
-                SDL_free(tempBuf); // chunk の成否に関わらず必ず解放
+        MappedFile* part = mapPart(entry.pckPath);
+        if (part) {
+            Mix_Chunk* chunk = decodeBoxEntry(*part, entry);
+            if (chunk) {
+                uint32_t onset = 0, untrimmed = 0;
+                trimSilence(chunk, onset, untrimmed);
+                uint32_t adpcm = shouldCompress(id) ? compressChunk(chunk) : 0;
+                insertCached(key, id, chunk, entry.size, onset, untrimmed, adpcm);
+            } else {
+                // デバッグ用：ロード失敗の原因を出力
+                // fprintf(stderr, "Mix_LoadWAV_RW failed for %s: %s\n", filename.c_str(), Mix_GetError());
             }
             return;
         }
@@ -94,22 +853,16 @@ void SoundManager::loadSingleSound(const std::string& filename, const std::strin
 
     // 外部ファイル読み込み
     std::string path = rootPath + (rootPath.empty() || rootPath.back() == '/' ? "" : "/") + filename;
-    SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "rb");
-    if (!rw) return;
+    std::string key = makeCacheKey(path, "", 0, 0);
+    if (acquireCached(key, id)) return;
 
-    uint64_t fileSize = SDL_RWsize(rw);
-    if (currentTotalMemory + fileSize > MAX_WAV_MEMORY) {
-        SDL_RWclose(rw);
-        return;
-    }
-
-    // 外部ファイルは Mix_LoadWAV_RW(freesrc=1) で問題なし。
-    // SDL_RWFromFile で開いた RWops は SDL が内部でファイルハンドルを持つため、
-    // freesrc=1 で正しく閉じられる。
-    Mix_Chunk* chunk = Mix_LoadWAV_RW(rw, 1);
+    uint64_t fileSize = 0;
+    Mix_Chunk* chunk = decodeExternal(path, fileSize);
     if (chunk) {
-        sounds[id] = chunk;
-        currentTotalMemory += fileSize;
+        uint32_t onset = 0, untrimmed = 0;
+        trimSilence(chunk, onset, untrimmed);
+        uint32_t adpcm = shouldCompress(id) ? compressChunk(chunk) : 0;
+        insertCached(key, id, chunk, fileSize, onset, untrimmed, adpcm);
     }
 }
 
@@ -117,90 +870,682 @@ void SoundManager::loadSoundsInBulk(const std::vector<std::string>& filenames,
                                     const std::string& rootPath,
                                     const std::string& bmsonName,
                                     std::function<void(int, const std::string&)> onProgress) {
+    (void)bmsonName; // 外部ファイルは rootPath 直下 (loadSingleSound と同じ)
 
-    std::unordered_map<std::string, std::vector<std::string>> groupPerBox;
-    std::vector<std::string> externalFiles;
+    std::vector<LoadJob> jobs;
+    jobs.reserve(filenames.size());
+    int processedCount = 0;
 
     for (const auto& name : filenames) {
-        if (sounds.find(getHash(name)) != sounds.end()) continue;
-        if (boxIndex.count(name)) {
-            groupPerBox[boxIndex[name].pckPath].push_back(name);
+        uint32_t id = getHash(name);
+        if (sounds.find(id) != sounds.end()) continue;
+
+        LoadJob job;
+        job.name = name;
+        soundNames[id] = name;
+        auto box = boxIndex.find(name);
+        if (box != boxIndex.end()) {
+            job.path  = box->second.pckPath;
+            job.part  = mapPart(job.path); // マップの追加はメインスレッドだけで行う
+            if (!job.part) continue;
+            job.box   = box->second;
+            job.inBox = true;
+            job.key   = makeCacheKey(job.path, name, job.box.offset, job.box.size);
         } else {
-            externalFiles.push_back(name);
+            job.path  = rootPath + (rootPath.empty() || rootPath.back() == '/' ? "" : "/") + name;
+            job.part  = nullptr;
+            job.box   = BoxEntry{job.path, 0, 0};
+            job.inBox = false;
+            job.key   = makeCacheKey(job.path, "", 0, 0);
         }
+        // キャッシュにあれば SD に触らずに済む
+        if (acquireCached(job.key, id)) {
+            processedCount++;
+            if (onProgress) onProgress(processedCount, name);
+            continue;
+        }
+        job.id         = id;
+        job.required   = true;
+        job.firstUseMs = 0.0;
+        jobs.push_back(std::move(job));
     }
 
-    int processedCount = 0;
+    // ファイル・オフセット順にソートしてシーク回数を最小化 (I/O スレッドはこの順に読む)
+    std::sort(jobs.begin(), jobs.end(), [](const LoadJob& a, const LoadJob& b) {
+        if (a.path != b.path) return a.path < b.path;
+        return a.box.offset < b.box.offset;
+    });
 
-    for (auto& [pckPath, list] : groupPerBox) {
-        // オフセット順にソートしてシーク回数を最小化
-        std::sort(list.begin(), list.end(), [&](const std::string& a, const std::string& b) {
-            return boxIndex[a].offset < boxIndex[b].offset;
+    uint32_t t0 = SDL_GetTicks();
+    uint64_t loadedBytes = 0;
+
+    // ★読み込みは I/O スレッド1本、デコードはワーカー群。メインスレッドは
+    //   完了キューを回収してキャッシュに登録し、進捗を描くだけ。
+    DecodePipeline pipeline;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> waiting; // 重複ジョブの待ち合わせ
+    startPipeline(pipeline, jobs);
+    while (!pipeline.finished()) {
+        size_t n = pipeline.drain([&](uint32_t i, void* result) {
+            const LoadJob& job = jobs[i];
+            if (result) loadedBytes += job.box.size;
+            completeJob(jobs, i, static_cast<Mix_Chunk*>(result), waiting);
+            processedCount++;
+            if (onProgress) onProgress(processedCount, job.name);
         });
+        if (n == 0) SDL_Delay(1);
+    }
+    pipeline.join();
+    lockResidents();
 
-        std::ifstream ifs(pckPath, std::ios::binary);
-        if (!ifs) continue;
+    uint32_t loadMs = SDL_GetTicks() - t0;
+    std::cout << "BoxWav load: " << (loadedBytes >> 10) << "KB in " << loadMs << "ms ("
+              << (mappedParts.empty() || mappedParts.begin()->second->isZeroCopy() ? "mmap" : "staged")
+              << ", " << pipeline.workerCount() << " decode threads)" << std::endl;
+    std::cout << "Sound cache: " << cacheHits << " hits, " << cacheMisses << " decoded, "
+              << (cacheBytes >> 20) << "MB cached, " << dedupCount << " deduplicated ("
+              << (dedupBytes >> 10) << "KB shared)" << std::endl;
+    logDecodeStats();
+}
 
-        for (const auto& name : list) {
-            auto& entry = boxIndex[name];
-            if (currentTotalMemory + entry.size > MAX_WAV_MEMORY) {
-                processedCount++;
-                if (onProgress) onProgress(processedCount, name);
-                continue;
-            }
+// ============================================================
+//  loadSoundsAsync — 初出時刻順の非同期ロード
+//
+//  旧実装 (loadSoundsInBulk) は全チャンネルを box のオフセット順に読み終えるまで
+//  ローディング画面を抜けられなかった。曲の最初の数十秒で使う音は全体の一部なので、
+//  それだけを先に揃えて開始し、残りはワーカーが初出時刻順に読む。
+//
+//  スレッド安全性:
+//    - 対象 ID は開始前にメインスレッドで sounds に nullptr として登録しておき、
+//      ワーカーは値 (atomic) を書き換えるだけ。play() は nullptr なら鳴らさない。
+//    - キャッシュへの登録は cacheMutex で守る。
+// ============================================================
 
-            uint8_t* tempBuf = (uint8_t*)SDL_malloc(entry.size);
-            if (tempBuf) {
-                ifs.seekg(entry.offset);
-                ifs.read((char*)tempBuf, entry.size);
+void SoundManager::loadSoundsAsync(const std::vector<std::string>& filenames,
+                                   const std::vector<PlayableNote>& notes,
+                                   const std::string& rootPath,
+                                   const std::string& bmsonName,
+                                   double residentMs, bool requireAllBgm,
+                                   std::function<void(int, int)> onProgress) {
+    cancelAsyncLoad();
+    loadStats      = LoadStats();
+    missedTriggers = 0;
+    asyncStartTick = SDL_GetTicks();
 
-                // ★修正：loadSingleSound と同様に freesrc=0 + 手動 RWclose
-                SDL_RWops* rwIndiv = SDL_RWFromMem(tempBuf, (int)entry.size);
-                Mix_Chunk* chunk = Mix_LoadWAV_RW(rwIndiv, 0); // ← 0 に変更
-                SDL_RWclose(rwIndiv);                           // ← 手動で close
+    // 1. 譜面から各キー音の初出時刻と、BGM レーンで使われるかを求める
+    std::unordered_map<uint32_t, double> firstUse;
+    std::unordered_set<uint32_t> usedByBgm;
+    firstUse.reserve(filenames.size());
+    for (const auto& n : notes) {
+        auto [it, inserted] = firstUse.emplace(n.soundId, n.target_ms);
+        if (!inserted) it->second = std::min(it->second, n.target_ms);
+        if (n.isBGM) usedByBgm.insert(n.soundId);
+    }
 
-                if (chunk) {
-                    sounds[getHash(name)] = chunk;
-                    currentTotalMemory += entry.size;
-                }
-                SDL_free(tempBuf); // chunk の成否に関わらず必ず解放
+    // 2. キャッシュにあるものはこの場で確定、残りをジョブにする
+    std::vector<LoadJob> jobs;
+    jobs.reserve(filenames.size());
+    for (const auto& name : filenames) {
+        uint32_t id = getHash(name);
+        if (sounds.find(id) != sounds.end()) continue;
+        loadStats.total++;
+
+        LoadJob job;
+        job.name = name;
+        soundNames[id] = name;
+        auto box = boxIndex.find(name);
+        if (box != boxIndex.end()) {
+            job.path   = box->second.pckPath;
+            job.part   = mapPart(job.path); // ワーカーはマップを触らないので、ここで開いておく
+            if (!job.part) continue;
+            job.box    = box->second;
+            job.inBox  = true;
+            job.key    = makeCacheKey(job.path, name, job.box.offset, job.box.size);
+        } else {
+            job.path   = rootPath + (rootPath.empty() || rootPath.back() == '/' ? "" : "/") + name;
+            job.part   = nullptr;
+            job.box    = BoxEntry{job.path, 0, 0};
+            job.inBox  = false;
+            job.key    = makeCacheKey(job.path, "", 0, 0);
+        }
+        if (acquireCached(job.key, id)) {
+            loadStats.cacheHits++;
+            continue;
+        }
+
+        auto fu = firstUse.find(id);
+        job.id         = id;
+        job.firstUseMs = (fu != firstUse.end()) ? fu->second : std::numeric_limits<double>::max();
+        job.required   = job.firstUseMs < residentMs || (requireAllBgm && usedByBgm.count(id));
+        jobs.push_back(std::move(job));
+
+        // 演奏中にマップの構造が変わらないよう、先に空のエントリを作っておく
+        sounds[id].chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // 3. 並び順: 開始前に必要な分 → 残り。前者はどうせ全部待つのでシークが少ない
+    //    ファイル・オフセット順、後者はプレイヘッドに追い越されないよう初出時刻順。
+    std::sort(jobs.begin(), jobs.end(), [](const LoadJob& a, const LoadJob& b) {
+        if (a.required != b.required) return a.required;
+        if (a.required) {
+            if (a.path != b.path) return a.path < b.path;
+            return a.box.offset < b.box.offset;
+        }
+        return a.firstUseMs < b.firstUseMs;
+    });
+    uint32_t required = (uint32_t)std::count_if(jobs.begin(), jobs.end(),
+                                                [](const LoadJob& j) { return j.required; });
+    loadStats.required = required;
+
+    asyncJobs = std::move(jobs);
+    asyncDone.store(0);
+    asyncRequiredDone.store(0);
+    asyncLate.store(0);
+    asyncTotalMs.store(0);
+    asyncCancel.store(false);
+    asyncLoading.store(true, std::memory_order_release);
+    loadThread = std::thread(&SoundManager::asyncLoadWorker, this);
+
+    // 4. 開始に必要な分が揃うまで待つ (メインスレッドは進捗表示だけ)
+    uint32_t lastDone = UINT32_MAX;
+    while (isAsyncLoading() && asyncRequiredDone.load(std::memory_order_acquire) < required) {
+        uint32_t done = asyncRequiredDone.load(std::memory_order_acquire);
+        if (onProgress && done != lastDone) onProgress((int)done, (int)required);
+        lastDone = done;
+        SDL_Delay(16);
+    }
+    if (onProgress) onProgress((int)required, (int)required);
+    loadStats.waitMs = SDL_GetTicks() - asyncStartTick;
+    // ここから先は演奏 (待機画面の打鍵音を含む) で鳴りうるので、常駐音は追い出さない
+    lockResidents();
+
+    std::cout << "Async load: " << loadStats.total << " sounds, " << loadStats.cacheHits << " cached, "
+              << required << " before start (" << loadStats.waitMs << "ms), "
+              << (asyncJobs.size() - required) << " streaming" << std::endl;
+}
+
+// 重複検出用の 64bit ハッシュ。8 バイトずつ乗算で混ぜる (SD の読み込みより十分速ければよい)
+static uint64_t contentHash(const uint8_t* p, size_t n, uint64_t seed) {
+    uint64_t h = seed ^ (n * 0x9E3779B97F4A7C15ull);
+    size_t   i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h  = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, n - i);
+    h = (h ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 29);
+}
+
+uint64_t SoundManager::formatTag(const LoadJob& job) {
+    // 変換済み PCM は形式も内容の一部 (同じバイト列でも元の形式が違えば別の音)
+    return job.inBox && job.box.format != BoxWav::FORMAT_FILE
+         ? ((uint64_t)job.box.format | (uint64_t)job.box.channels << 16 | (uint64_t)job.box.rate << 32)
+         : 0;
+}
+
+bool SoundManager::sameContent(const LoadJob& primary, const LoadJob& job, const uint8_t* data, uint32_t size) {
+    if (primary.box.size != size) return false;
+    if (formatTag(primary) != formatTag(job)) return false;
+
+    if (primary.inBox && primary.part->isZeroCopy()) {
+        const uint8_t* p = primary.part->view(primary.box.offset, size);
+        return p && std::memcmp(p, data, size) == 0;
+    }
+    // 先行ジョブのバイト列はワーカーに渡して解放済みでありうるので、読み直して比べる
+    // (ハッシュが一致した時だけなので、読み直しは重複の数だけ)
+    std::vector<uint8_t> bytes(size);
+    bool ok = false;
+    if (primary.inBox) {
+        ok = primary.part->read(primary.box.offset, size, bytes.data());
+    } else {
+        MappedFile file;
+        ok = file.open(primary.path) && file.size() == size && file.read(0, size, bytes.data());
+    }
+    return ok && std::memcmp(bytes.data(), data, size) == 0;
+}
+
+bool SoundManager::fetchJob(LoadJob& job, DecodePipeline::Blob& out) {
+    if (job.inBox) {
+        if (job.part->isZeroCopy()) {
+            // マップ上をそのまま渡す。ページはここで読み込ませておく
+            job.part->fault(job.box.offset, job.box.size);
+            out.data = job.part->view(job.box.offset, job.box.size);
+        } else {
+            // フォールバック版のステージングバッファは共有なので、ジョブごとにコピーする
+            out.owned = static_cast<uint8_t*>(std::malloc(job.box.size));
+            if (!out.owned || !job.part->read(job.box.offset, job.box.size, out.owned)) return false;
+            out.data = out.owned;
+        }
+        out.size = job.box.size;
+        return out.data != nullptr;
+    }
+
+    MappedFile file;
+    if (!file.open(job.path)) return false;
+    uint64_t fileSize = file.size();
+    if (fileSize > UINT32_MAX) return false;
+    job.box.size = (uint32_t)fileSize; // 消費側が sourceBytes として使う
+    out.owned = static_cast<uint8_t*>(std::malloc(job.box.size));
+    if (!out.owned || !file.read(0, job.box.size, out.owned)) return false;
+    out.data = out.owned;
+    out.size = job.box.size;
+    return true;
+}
+
+// ============================================================
+//  probeStream — 長い PCM キー音をストリーミングに回すかの判定
+//  ヘッダ (先頭 4KB) だけを読む。data チャンクの位置と長さが分かれば十分で、
+//  サンプル本体は SoundStream が鳴らしながら読む。
+//  OGG / FLAC などは SDL_mixer でしか読めず、途中から少しずつデコードする手段が
+//  無いので従来どおり常駐させる。
+// ============================================================
+bool SoundManager::probeStream(LoadJob& job) {
+    if (Config::STREAM_SOUND_SEC <= 0) return false;
+
+    WavDecoder::Info info;
+    uint64_t offset = 0;
+    if (job.inBox && job.box.format == BoxWav::FORMAT_S16) {
+        // v2 の変換済み PCM: 形式は目次にある
+        info.formatTag     = 1;
+        info.channels      = job.box.channels;
+        info.sampleRate    = job.box.rate;
+        info.bitsPerSample = 16;
+        info.blockAlign    = (uint16_t)(job.box.channels * 2);
+        if (info.blockAlign == 0) return false;
+        info.frames = job.box.size / info.blockAlign;
+        offset      = job.box.offset;
+    } else {
+        MappedFile  external;
+        MappedFile* file = job.part;
+        uint64_t    base = job.inBox ? job.box.offset : 0;
+        uint64_t    size = job.box.size;
+        if (!job.inBox) {
+            if (!external.open(job.path)) return false;
+            file = &external;
+            size = external.size();
+        }
+        uint8_t  head[4096];
+        uint32_t n = (uint32_t)std::min<uint64_t>(sizeof(head), size);
+        if (!file->read(base, n, head) || !WavDecoder::parse(head, n, info)) return false;
+
+        // parse は読んだ 4KB で data を切り詰めるので、長さは data チャンクのヘッダから取り直す
+        uint64_t dataOff  = (uint64_t)(info.data - head);
+        const uint8_t* ck = info.data - 4;
+        uint32_t declared = (uint32_t)ck[0] | ((uint32_t)ck[1] << 8) | ((uint32_t)ck[2] << 16) | ((uint32_t)ck[3] << 24);
+        info.frames = (uint32_t)(std::min<uint64_t>(declared, size - dataOff) / info.blockAlign);
+        offset      = base + dataOff;
+        if (!job.inBox) {
+            if (size > UINT32_MAX) return false;
+            job.box.size = (uint32_t)size; // 消費側が元のサイズとして使う
+        }
+    }
+    if (info.sampleRate == 0 || (double)info.frames / info.sampleRate < Config::STREAM_SOUND_SEC) return false;
+
+    info.data        = nullptr;
+    job.streamInfo   = info;
+    job.streamOffset = offset;
+    job.stream       = true;
+    return true;
+}
+
+void SoundManager::createStream(const LoadJob& job) {
+    auto stream = std::make_unique<SoundStream>();
+    if (!stream->open(job.path, job.streamOffset, job.streamInfo, mixer.getSampleRate(), mixer.getChannels())) {
+        std::cout << "Stream open failed: " << job.name << std::endl;
+        return;
+    }
+    SoundStream* raw   = stream.get();
+    uint64_t resident  = raw->bufferBytes();
+    uint64_t full      = (uint64_t)raw->totalSamples() * sizeof(int16_t);
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streams.push_back(std::move(stream));
+    }
+    streamCv.notify_one();
+
+    // 非同期ロード中はエントリが登録済み (makeResidentLocked と同じ)
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = sounds.find(job.id);
+    SoundSlot& slot = (it != sounds.end()) ? it->second : sounds[job.id];
+    slot.stream.store(raw, std::memory_order_release);
+    currentTotalMemory += resident;
+    streamedSounds++;
+    streamSavedBytes += full > resident ? full - resident : 0;
+}
+
+bool SoundManager::isStreamed(int soundId) const {
+    auto it = sounds.find(static_cast<uint32_t>(soundId));
+    return it != sounds.end() && it->second.stream.load(std::memory_order_acquire) != nullptr;
+}
+
+uint64_t SoundManager::getStreamUnderruns() {
+    std::lock_guard<std::mutex> lock(streamMutex);
+    uint64_t total = 0;
+    for (const auto& s : streams) total += s->getUnderruns();
+    return total;
+}
+
+// 読み込みスレッド: 空いた枠を順に埋める。する事が無い間は 2ms ごとに見に行く
+// (1枠 = SoundStream::SLOT_MS なので十分間に合う)
+void SoundManager::streamWorker() {
+    std::unique_lock<std::mutex> lock(streamMutex);
+    while (!streamQuit) {
+        if (streams.empty()) {
+            streamCv.wait(lock, [&] { return streamQuit || !streams.empty(); });
+            continue;
+        }
+        bool filled = false;
+        for (auto& s : streams) filled |= s->fill();
+        if (!filled) streamCv.wait_for(lock, std::chrono::milliseconds(2));
+    }
+}
+
+void SoundManager::startPipeline(DecodePipeline& pipeline, std::vector<LoadJob>& jobs) {
+    auto seen = std::make_shared<std::unordered_map<uint64_t, uint32_t>>(); // 内容ハッシュ → 最初のジョブ
+    pipeline.start((uint32_t)jobs.size(), Config::LOAD_DECODE_THREADS,
+        // I/O スレッド: 並び順どおりに1件ずつ読む。SD に触るのはここだけ
+        [this, &jobs, seen](uint32_t i, DecodePipeline::Blob& out) {
+            LoadJob& job = jobs[i];
+            if (i + PREFAULT_AHEAD < jobs.size() && jobs[i + PREFAULT_AHEAD].inBox) {
+                const LoadJob& ahead = jobs[i + PREFAULT_AHEAD];
+                ahead.part->prefault(ahead.box.offset, ahead.box.size);
             }
+            // 長い PCM はここで読まない (completeJob がストリームとして開く)
+            if (probeStream(job)) return false;
+            if (!fetchJob(job, out)) return false;
 
-            processedCount++;
-            if (onProgress) onProgress(processedCount, name);
+            // ★同じ内容を先に読んだジョブがあれば、デコードせずにそのチャンクを共有させる。
+            //   変換済み PCM は形式もハッシュに含める
+            auto [it, fresh] = seen->emplace(contentHash(out.data, out.size, formatTag(job)), i);
+            // ハッシュの一致だけで共有すると、衝突した別の音に化ける。中身まで同じ時だけ共有する。
+            // 保持形式 (ADPCM / PCM) の判定が違う id どうしも共有しない
+            if (!fresh && shouldCompress(jobs[it->second].id) == shouldCompress(job.id) &&
+                sameContent(jobs[it->second], job, out.data, out.size)) {
+                job.dupOf = (int32_t)it->second;
+                return false;
+            }
+            return true;
+        },
+        // ワーカー: デコード・無音の切り落とし・圧縮のみ (キャッシュ・sounds には触らない)
+        [this, &jobs](uint32_t i, const uint8_t* data, uint32_t size) -> void* {
+            LoadJob& job = jobs[i];
+            Mix_Chunk* chunk = (job.inBox && job.box.format == BoxWav::FORMAT_S16)
+                             ? chunkFromPcm(data, size, job.box.channels, job.box.rate)
+                             : decodeBytes(data, size);
+            if (chunk) {
+                trimSilence(chunk, job.onsetFrames, job.untrimmedLen);
+                if (shouldCompress(job.id)) job.adpcmSamples = compressChunk(chunk);
+            }
+            return chunk;
+        },
+        [](void* chunk) { Mix_FreeChunk(static_cast<Mix_Chunk*>(chunk)); });
+}
+
+void SoundManager::asyncLoadWorker() {
+    // このスレッドはパイプラインの消費側。完了順はワーカー数次第で前後する
+    DecodePipeline pipeline;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> waiting; // 重複ジョブの待ち合わせ
+    startPipeline(pipeline, asyncJobs);
+
+    while (!pipeline.finished()) {
+        if (asyncCancel.load(std::memory_order_relaxed)) {
+            pipeline.cancel();
+            break;
         }
+        size_t n = pipeline.drain([&](uint32_t i, void* result) {
+            const LoadJob& job = asyncJobs[i];
+            completeJob(asyncJobs, i, static_cast<Mix_Chunk*>(result), waiting);
+            if (result) {
+                // 届いた時点でプレイヘッドが初出時刻を過ぎていたら遅刻
+                double songMs;
+                if (!job.required && mixer.getSongTimeMs(songMs) && songMs >= job.firstUseMs)
+                    asyncLate.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (job.required) asyncRequiredDone.fetch_add(1, std::memory_order_release);
+            asyncDone.fetch_add(1, std::memory_order_release);
+        });
+        if (n == 0) SDL_Delay(1);
     }
+    pipeline.join();
 
-    for (const auto& name : externalFiles) {
-        loadSingleSound(name, rootPath, bmsonName);
-        processedCount++;
-        if (onProgress) onProgress(processedCount, name);
+    if (!asyncCancel.load(std::memory_order_relaxed)) {
+        asyncTotalMs.store(SDL_GetTicks() - asyncStartTick, std::memory_order_relaxed);
+        logDecodeStats();
     }
+    asyncLoading.store(false, std::memory_order_release);
+}
+
+void SoundManager::cancelAsyncLoad() {
+    asyncCancel.store(true);
+    if (loadThread.joinable()) loadThread.join();
+    asyncLoading.store(false);
+    asyncJobs.clear();
+}
+
+SoundManager::LoadStats SoundManager::getLoadStats() const {
+    LoadStats s = loadStats;
+    uint32_t done  = asyncDone.load(std::memory_order_acquire);
+    uint32_t req   = asyncRequiredDone.load(std::memory_order_acquire);
+    s.streamed       = done > req ? done - req : 0;
+    s.lateArrivals   = asyncLate.load(std::memory_order_relaxed);
+    s.missedTriggers = missedTriggers;
+    s.totalMs        = asyncTotalMs.load(std::memory_order_relaxed);
+    return s;
 }
 
-void SoundManager::play(int soundId) {
+void SoundManager::play(int soundId, AudioMixer::Priority priority, int lane) {
     uint32_t id = static_cast<uint32_t>(soundId);
+    uint16_t choke = (Config::LANE_CHOKE && lane > 0) ? (uint16_t)lane : 0;
     // ★修正: sounds.count(id) + sounds[id] の二重ハッシュ計算を廃止。
     //        find() でイテレータを1回取得し、以降はイテレータ経由で直接アクセスする。
     //        1音再生ごとにハッシュ計算が2→1回になる。
+    const uint32_t probe = latency.currentHit(); // 遅延計測中の打鍵 (無ければ 0)
     auto it = sounds.find(id);
-    if (it != sounds.end() && it->second != nullptr) {
-        Mix_Chunk* targetChunk = it->second;
-        int newChannel = Mix_PlayChannel(-1, targetChunk, 0);
-
-        if (newChannel == -1) {
-            static int nextVictim = 0;
-            newChannel = nextVictim;
-            Mix_HaltChannel(newChannel);
-            Mix_PlayChannel(newChannel, targetChunk, 0);
-            nextVictim = (nextVictim + 1) % 256;
+    if (it == sounds.end()) return;
+    if (SoundStream* stream = it->second.stream.load(std::memory_order_acquire)) {
+        if (mixer.triggerStream(stream, id, KEYSOUND_GAIN, priority, choke, probe)) latency.mark(probe, LatencyProbe::PLAY);
+        return;
+    }
+    Mix_Chunk* chunk = it->second.chunk.load(std::memory_order_acquire);
+    if (chunk != nullptr) {
+        // ★チャンネル確保・victim 停止・Mix_Volume は不要。ミキサーのキューに積むだけ。
+        //   ボイスが埋まっている場合の奪い方はオーディオスレッド側で優先度と発音順から決める。
+        uint32_t onset = it->second.onsetFrames.load(std::memory_order_relaxed);
+        uint32_t adpcm = it->second.adpcmSamples.load(std::memory_order_relaxed);
+        bool queued = adpcm
+            ? mixer.triggerAdpcm(chunk->abuf, adpcm, id, KEYSOUND_GAIN, priority, onset, choke, probe)
+            : mixer.trigger(reinterpret_cast<const int16_t*>(chunk->abuf),
+                            chunk->alen / sizeof(int16_t), id, KEYSOUND_GAIN, priority, onset, choke, probe);
+        if (queued) latency.mark(probe, LatencyProbe::PLAY);
+    } else if (isAsyncLoading()) {
+        missedTriggers++; // まだワーカーが読んでいない
+    }
+}
+
+void SoundManager::schedule(int soundId, double songMs, AudioMixer::Priority priority) {
+    auto it = sounds.find(static_cast<uint32_t>(soundId));
+    if (it == sounds.end()) return;
+    if (SoundStream* stream = it->second.stream.load(std::memory_order_acquire)) {
+        mixer.scheduleStream(stream, it->first, KEYSOUND_GAIN, priority, songMs);
+        return;
+    }
+    Mix_Chunk* chunk = it->second.chunk.load(std::memory_order_acquire);
+    if (chunk != nullptr) {
+        uint32_t onset = it->second.onsetFrames.load(std::memory_order_relaxed);
+        uint32_t adpcm = it->second.adpcmSamples.load(std::memory_order_relaxed);
+        if (adpcm) mixer.scheduleAdpcm(chunk->abuf, adpcm, it->first, KEYSOUND_GAIN, priority, songMs, onset);
+        else       mixer.schedule(reinterpret_cast<const int16_t*>(chunk->abuf),
+                                  chunk->alen / sizeof(int16_t), it->first, KEYSOUND_GAIN, priority, songMs, onset);
+    } else if (isAsyncLoading()) {
+        missedTriggers++;
+    }
+}
+
+// ============================================================
+//  premixBgm — BGM 専用キー音の事前ミックス
+//
+//  bmson の多くはノーツの大半が BGM レーンで、1ノーツ = 1ボイス + 1トリガーを
+//  演奏中に消費していた。ロード時に1本のトラックへ焼き込んでおけば、演奏中は
+//  そのトラック1ボイスだけで済み、ミキサーのボイスはプレイヤーのキー音に回せる。
+//
+//  並列化: トラックを時間方向にスレッド数で等分し、各スレッドは自分の区間だけを
+//  書く (書き込み先が重ならないので同期不要)。区間内は 64K サンプル単位の
+//  float バッファに積算し、ミキサーと同じ飽和カーネルで int16 に落とす。
+// ============================================================
+
+bool SoundManager::premixBgm(const std::vector<PlayableNote>& notes, const std::string& cacheKey,
+                             std::function<void(int, int)> onProgress) {
+    // ★同じ譜面のリトライなら前回のトラックをそのまま使う
+    //   (残っている間は currentTotalMemory に計上したまま。clear() 参照)
+    if (premixTrack && !cacheKey.empty() && cacheKey == premixKey) {
+        if (onProgress) onProgress(100, 100);
+        std::cout << "BGM premix reused (" << ((uint64_t)premixSamples * sizeof(int16_t) >> 10) << "KB)" << std::endl;
+        return true;
+    }
+    freePremix();
+
+    const int rate = mixer.getSampleRate();
+    const int ch   = mixer.getChannels();
+
+    struct Event {
+        uint64_t       start; // トラック内のサンプル位置 (インターリーブ後)
+        uint64_t       end;
+        const int16_t* pcm;
+        const uint8_t* adpcm; // 圧縮して持っている音 (pcm は nullptr)
+    };
+    std::vector<Event> events;
+    events.reserve(notes.size());
+    uint64_t totalSamples = 0;
+
+    for (const auto& n : notes) {
+        if (!n.isBGM) continue;
+        auto it = sounds.find(n.soundId);
+        if (it == sounds.end()) continue;
+        Mix_Chunk* chunk = it->second.chunk.load(std::memory_order_acquire);
+        if (!chunk) continue;
+        // 先頭の無音を切った音はその分だけ後ろに置く
+        uint64_t onset = it->second.onsetFrames.load(std::memory_order_relaxed);
+        uint64_t start = ((uint64_t)std::llround(std::max(0.0, n.target_ms) * rate / 1000.0) + onset) * ch;
+        uint32_t adpcm = it->second.adpcmSamples.load(std::memory_order_relaxed);
+        uint64_t len   = adpcm ? adpcm : chunk->alen / sizeof(int16_t);
+        if (len == 0) continue;
+        if (adpcm) events.push_back({start, start + len, nullptr, chunk->abuf});
+        else       events.push_back({start, start + len, reinterpret_cast<const int16_t*>(chunk->abuf), nullptr});
+        totalSamples = std::max(totalSamples, start + len);
+    }
+    if (events.empty() || totalSamples > UINT32_MAX) return false;
+
+    // ★フォールバック: 予算を超えるなら焼き込まない (ノーツごとのボイスで鳴らす)
+    uint64_t bytes = totalSamples * sizeof(int16_t);
+    if (currentTotalMemory + bytes > MAX_WAV_MEMORY) {
+        std::cout << "BGM premix skipped: needs " << (bytes >> 20) << "MB over budget" << std::endl;
+        return false;
+    }
+    int16_t* track = (int16_t*)SDL_malloc((size_t)bytes);
+    if (!track) {
+        std::cout << "BGM premix skipped: allocation of " << (bytes >> 20) << "MB failed" << std::endl;
+        return false;
+    }
+
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+
+    uint32_t t0 = SDL_GetTicks();
+    unsigned hw = std::thread::hardware_concurrency();
+    int workers = std::clamp((int)(hw ? hw : PREMIX_MAX_THREADS), 1, PREMIX_MAX_THREADS);
+
+    // 区間境界はチャンネル数の倍数に揃える (フレームを跨がない)
+    uint64_t segment = (totalSamples / workers + ch - 1) / ch * ch;
+    std::atomic<uint64_t> progress{0};
+
+    auto renderRange = [&](uint64_t segA, uint64_t segB) {
+        const uint64_t BLOCK = 65536; // ch=1,2 どちらでもフレーム境界
+        std::vector<float> buf(BLOCK);
+        std::vector<int16_t> unpacked(BLOCK); // ADPCM の音をこの区間の分だけ展開する
+        std::vector<const Event*> active;
+
+        // 区間開始時点で既に鳴っているイベントと、次に始まるイベントの位置
+        size_t next = 0;
+        while (next < events.size() && events[next].start < segA) {
+            if (events[next].end > segA) active.push_back(&events[next]);
+            next++;
         }
 
-        if (newChannel != -1) {
-            Mix_Volume(newChannel, 96);
-            activeChannels[id] = newChannel;
+        for (uint64_t a = segA; a < segB; a += BLOCK) {
+            uint64_t b = std::min(a + BLOCK, segB);
+            int      n = (int)(b - a);
+            while (next < events.size() && events[next].start < b) active.push_back(&events[next++]);
+
+            std::fill(buf.begin(), buf.begin() + n, 0.0f);
+            for (const Event* e : active) {
+                uint64_t from = std::max(e->start, a);
+                uint64_t to   = std::min(e->end, b);
+                if (from >= to) continue;
+                const int16_t* src;
+                if (e->adpcm) { // pcm は nullptr なので位置を足さない
+                    AdpcmCodec::Cursor cur;
+                    AdpcmCodec::seek(e->adpcm, ch, cur, (uint32_t)((from - e->start) / ch));
+                    AdpcmCodec::decode(e->adpcm, ch, cur, unpacked.data(), (uint32_t)((to - from) / ch));
+                    src = unpacked.data();
+                } else {
+                    src = e->pcm + (from - e->start);
+                }
+                AudioMixer::accumulate(buf.data() + (from - a), src, (int)(to - from), KEYSOUND_GAIN);
+            }
+            active.erase(std::remove_if(active.begin(), active.end(),
+                                        [b](const Event* e) { return e->end <= b; }), active.end());
+
+            AudioMixer::store(track + a, buf.data(), n);
+            progress.fetch_add((uint64_t)n, std::memory_order_relaxed);
         }
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; w++) {
+        uint64_t segA = std::min(totalSamples, segment * w);
+        uint64_t segB = (w == workers - 1) ? totalSamples : std::min(totalSamples, segment * (w + 1));
+        if (segA < segB) threads.emplace_back(renderRange, segA, segB);
     }
+
+    // メインスレッドは進捗表示だけ行う
+    while (progress.load(std::memory_order_relaxed) < totalSamples) {
+        if (onProgress)
+            onProgress((int)(progress.load(std::memory_order_relaxed) * 100 / totalSamples), 100);
+        SDL_Delay(16);
+    }
+    for (auto& t : threads) t.join();
+    if (onProgress) onProgress(100, 100);
+
+    premixTrack   = track;
+    premixSamples = (uint32_t)totalSamples;
+    premixKey     = cacheKey;
+    currentTotalMemory += bytes;
+
+    std::cout << "BGM premix: " << events.size() << " notes -> " << (bytes >> 10) << "KB, "
+              << workers << " threads, " << (SDL_GetTicks() - t0) << "ms" << std::endl;
+    return true;
+}
+
+void SoundManager::startPremixedBgm() {
+    if (!premixTrack) return;
+    mixer.schedule(premixTrack, premixSamples, 0, 1.0f, AudioMixer::PRIORITY_STREAM, 0.0);
+}
+
+void SoundManager::freePremix() {
+    if (!premixTrack) return;
+    // 再生中のボイスがトラックを指している可能性があるので、先にミキサーを空にする
+    withAudioStopped([this]() { mixer.resetVoices(); });
+    SDL_free(premixTrack);
+    currentTotalMemory -= std::min<uint64_t>(currentTotalMemory, (uint64_t)premixSamples * sizeof(int16_t));
+    premixTrack   = nullptr;
+    premixSamples = 0;
+    premixKey.clear();
+}
+
+void SoundManager::keepPremixFor(const std::string& cacheKey) {
+    if (premixTrack && (cacheKey.empty() || cacheKey != premixKey)) freePremix();
 }
 
 void SoundManager::playByName(const std::string& name) {
@@ -208,59 +1553,202 @@ void SoundManager::playByName(const std::string& name) {
 }
 
 void SoundManager::playPreview(const std::string& fullPath) {
-    static std::string lastPath = "";
-    if (lastPath == fullPath && currentPreviewChunk != nullptr) return;
-    stopPreview();
+    playPreview(fullPath, [fullPath]() { return fullPath; });
+}
 
-    SDL_RWops* rw = SDL_RWFromFile(fullPath.c_str(), "rb");
-    if (!rw) return;
+void SoundManager::playPreview(const std::string& key, std::function<std::string()> resolvePath) {
+    if (!previewKey.empty() && previewKey == key) return; // 同じ曲なら鳴らし続ける
+    requestPreview(key, std::move(resolvePath), true);
+}
+
+void SoundManager::playEffect(const std::string& fullPath) {
+    // 同じ音でも押すたびに鳴らし直す
+    requestPreview(fullPath, [fullPath]() { return fullPath; }, false);
+}
 
-    Mix_Chunk* previewChunk = Mix_LoadWAV_RW(rw, 1);
-    if (previewChunk) {
-        Mix_PlayChannel(255, previewChunk, -1);
-        Mix_Volume(255, 80);
-        currentPreviewChunk = previewChunk;
-        lastPath = fullPath;
+void SoundManager::requestPreview(const std::string& key, std::function<std::string()> resolvePath, bool loop) {
+    previewKey = key;
+    uint32_t gen = preview.request();
+    {
+        std::lock_guard<std::mutex> lock(previewMutex);
+        previewResolve    = std::move(resolvePath);
+        previewRequestGen = gen;
+        previewLoop       = loop;
     }
+    previewCv.notify_one();
 }
 
 void SoundManager::stopPreview() {
-    Mix_HaltChannel(255);
-    if (currentPreviewChunk) {
-        Mix_FreeChunk(currentPreviewChunk);
-        currentPreviewChunk = nullptr;
+    // ★旧実装は Mix_HaltChannel + Mix_FreeChunk。今は世代を進めるだけで、
+    //   オーディオスレッドが絞り切ってから捨てる (UI スレッドは待たない)
+    if (previewKey.empty()) return;
+    previewKey.clear();
+    preview.request();
+}
+
+void SoundManager::previewWorker() {
+    uint32_t handled = 0;
+    for (;;) {
+        std::function<std::string()> resolve;
+        uint32_t gen;
+        bool     loop;
+        {
+            std::unique_lock<std::mutex> lock(previewMutex);
+            previewCv.wait(lock, [&] { return previewQuit || previewRequestGen != handled; });
+            if (previewQuit) return;
+            gen     = handled = previewRequestGen;
+            resolve = std::move(previewResolve);
+            loop    = previewLoop;
+        }
+        if (!resolve || previewStale(gen)) continue;
+
+        // 譜面ヘッダの読み込みなど、パスの解決もここ (UI スレッドの外) で行う
+        std::string path = resolve();
+        if (path.empty() || previewStale(gen)) continue;
+        streamPreview(path, gen, loop);
     }
 }
 
+void SoundManager::streamPreview(const std::string& path, uint32_t gen, bool loop) {
+    // 前の曲がフェードアウトし終わるまで待つ (数十 ms)
+    while (!preview.ready(gen)) {
+        if (previewStale(gen) || previewQuit) return;
+        SDL_Delay(2);
+    }
+
+    const int rate = mixer.getSampleRate();
+    const int ch   = mixer.getChannels();
+    std::vector<int16_t> block;
+
+    // リングが空くのを待ちながら全部書く。世代が変わったら false
+    auto pump = [&](const int16_t* pcm, size_t samples) {
+        size_t off = 0;
+        while (off < samples) {
+            if (previewStale(gen) || previewQuit) return false;
+            size_t n = preview.write(gen, pcm + off, samples - off);
+            off += n;
+            if (n == 0) SDL_Delay(5);
+        }
+        return true;
+    };
+
+    // PCM WAV: ファイルのバイト列から少しずつ変換して流す (変換後の全体は持たない)
+    MappedFile file;
+    WavDecoder::Info info;
+    const uint8_t* bytes = nullptr;
+    if (file.open(path) && file.size() <= UINT32_MAX) bytes = file.view(0, (uint32_t)file.size());
+    if (bytes && WavDecoder::parse(bytes, (size_t)file.size(), info) && info.frames > 0) {
+        const uint32_t BLOCK_FRAMES = 4096; // 融合カーネルの 2:1 / 4:1 に合うよう 4 の倍数
+        do {
+            for (uint32_t f = 0; f < info.frames; f += BLOCK_FRAMES) {
+                WavDecoder::Info part = info;
+                part.data   = info.data + (size_t)f * info.blockAlign;
+                part.frames = std::min(BLOCK_FRAMES, info.frames - f);
+                block.resize((size_t)WavDecoder::outputFrames(part, rate) * ch);
+                if (block.empty() || !WavDecoder::convert(part, block.data(), rate, ch)) return;
+                if (!pump(block.data(), block.size())) return;
+            }
+        } while (loop);
+        return;
+    }
+    file.close();
+
+    // OGG / FLAC など: SDL_mixer に増分デコードの API が無いため、このスレッドで全体を
+    // デコードしてからリング経由で流す。UI は止まらず、途中で切り替わったら結果は捨てる
+    SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "rb");
+    if (!rw) return;
+    Mix_Chunk* chunk = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(sdlDecodeMutex); // ロード中のデコードワーカーと重なりうる
+        chunk = Mix_LoadWAV_RW(rw, 1);
+    }
+    if (!chunk) return;
+    const int16_t* pcm     = reinterpret_cast<const int16_t*>(chunk->abuf);
+    const size_t   samples = chunk->alen / sizeof(int16_t);
+    const size_t   STEP    = 4096;
+    bool playing = samples > 0;
+    while (playing) {
+        for (size_t off = 0; off < samples && playing; off += STEP)
+            playing = pump(pcm + off, std::min(STEP, samples - off));
+        if (!loop) break;
+    }
+    Mix_FreeChunk(chunk);
+}
+
 void SoundManager::stopAll() {
-    Mix_HaltChannel(-1);
-    activeChannels.clear();
+    // ボイスが指す PCM はこの後 clear() で解放されうるため、キューごと同期的に破棄する
+    withAudioStopped([this]() { mixer.resetVoices(); });
+    mixer.clearSongClock();
     stopPreview();
 }
 
 void SoundManager::clear() {
+    // ワーカーが sounds / キャッシュを触っている間は片付けられない
+    cancelAsyncLoad();
     stopAll();
-    for (auto& pair : sounds) {
-        if (pair.second) Mix_FreeChunk(pair.second);
+    releaseMappings(); // 曲が終わったらパートのマッピングも返す (次の曲では開き直す)
+    // ★チャンクはキャッシュが所有する。ここでは参照を外して予算まで削るだけ。
+    //   boxIndex と事前ミックス済みトラックも、次に同じ譜面が来た時のために残す。
+    std::unordered_map<uint32_t, SoundSlot>().swap(sounds);
+    {
+        // ボイスは stopAll() で止めたので、もう誰もストリームを読んでいない
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streams.clear();
     }
-    std::unordered_map<uint32_t, Mix_Chunk*>().swap(sounds);
-    std::unordered_map<uint32_t, int>().swap(activeChannels);
+    streamedSounds   = 0;
+    streamSavedBytes = 0;
+    releaseActiveCache();
+    trimCache(cacheBudget());
+    fileTagCache.clear();
+    residents.clear();
+    residentOrder.clear();
+    songChunkRefs.clear();
+    dedupBytes = 0;
+    dedupCount = 0;
+    trimmedSounds   = 0;
+    trimSavedBytes  = 0;
+    adpcmSounds     = 0;
+    adpcmSavedBytes = 0;
+    droppedSounds.clear();
+    soundNames.clear();
+    soundUsage.clear();
+    residentLocked = false;
+    mixer.setPolyphony(Config::KEYSOUND_MAX_POLY); // オプションでの変更は次の曲から
+    cacheHits     = 0;
+    cacheMisses   = 0;
 
-    boxIndex.clear();
-    currentTotalMemory = 0;
+    // ★残した事前ミックスのトラックは確保されたままなので、計上も残す
+    //   (別の譜面なら keepPremixFor() で、キー音を読む前に解放する)
+    currentTotalMemory = premixTrack ? (uint64_t)premixSamples * sizeof(int16_t) : 0;
     sounds.reserve(4000);
 
     // ★修正: Mix_CloseAudio()/Mix_OpenAudio() を廃止する。
     // Switch では OpenAudio の再呼び出しがドライバ側の解放完了前に実行されると
-    // -1 を返し、以降の Mix_PlayChannel が全て失敗して 2曲目以降が無音になる。
-    // オーディオデバイスはアプリ起動から終了まで開きっぱなしにし、
-    // チャンネルの再割り当てだけ行えば十分。
-    Mix_AllocateChannels(256);
+    // -1 を返し、以降の再生が全て失敗して 2曲目以降が無音になる。
+    // オーディオデバイスはアプリ起動から終了まで開きっぱなしにする。
 }
 
 void SoundManager::cleanup() {
     clear();
+    freePremix();
+    purgeCache();
+    boxIndex.clear();
+    boxIndexKey.clear();
+    {
+        std::lock_guard<std::mutex> lock(previewMutex);
+        previewQuit.store(true);
+    }
+    previewCv.notify_one();
+    if (previewThread.joinable()) previewThread.join();
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streamQuit.store(true);
+    }
+    streamCv.notify_one();
+    if (streamThread.joinable()) streamThread.join();
+    Mix_HookMusic(nullptr, nullptr);
     Mix_CloseAudio();
+    audioOpened = false;
 }
 
 
@@ -6,7 +6,22 @@
 #include <unordered_map>
 #include <cstdint> 
 #include <vector>
+#include <list>
+#include <map>
 #include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "AudioMixer.hpp"
+#include "CommonTypes.hpp"
+#include "MappedFile.hpp"
+#include "BoxWavFormat.hpp"
+#include "PreviewStream.hpp"
+#include "SoundStream.hpp"
+#include "DecodePipeline.hpp"
+
 
 class SoundManager {
 public:
@@ -26,48 +41,458 @@ public:
 
     void preloadBoxIndex(const std::string& rootPath, const std::string& bmsonName);
 
+    // ============================================================
+    //  【追加】初出時刻順の非同期ロード
+    //
+    //  譜面から各キー音の初出時刻を求め、residentMs より前に使う音 (requireAllBgm なら
+    //  BGM レーンで使う音も全て) だけを揃えた時点で戻る。残りはワーカースレッドが
+    //  初出時刻順に読み続け、演奏中にプレイヘッドより先に届くようにする。
+    //  onProgress(done, total) は「開始前に必要な分」についてメインスレッドから呼ばれる。
+    // ============================================================
+    struct LoadStats {
+        uint32_t total          = 0; // 譜面が使うキー音の数 (キャッシュヒット含む)
+        uint32_t cacheHits      = 0;
+        uint32_t required       = 0; // 開始前に揃えた数
+        uint32_t streamed       = 0; // 開始後にワーカーが読んだ数
+        uint32_t lateArrivals   = 0; // 初出時刻を過ぎてから届いた数
+        uint32_t missedTriggers = 0; // 未ロードのため鳴らせなかった発音
+        uint32_t waitMs         = 0; // ロード開始 → 開始可能まで
+        uint32_t totalMs        = 0; // ロード開始 → 全て完了まで (未完了なら 0)
+    };
+    void loadSoundsAsync(const std::vector<std::string>& filenames,
+                         const std::vector<PlayableNote>& notes,
+                         const std::string& rootPath,
+                         const std::string& bmsonName,
+                         double residentMs, bool requireAllBgm,
+                         std::function<void(int, int)> onProgress = nullptr);
+    bool isAsyncLoading() const { return asyncLoading.load(std::memory_order_acquire); }
+    void cancelAsyncLoad();
+    LoadStats getLoadStats() const;
+
     // --- 既存ロジック100%継承: 数値IDによる再生 ---
-    void play(int soundId); 
+    // priority: ボイスが埋まった時にどちらを残すか (プレイヤーのキー音 > BGM)
+    // 【追加】lane: 1 以上ならそのレーンのチョークグループで鳴らす (LANE_CHOKE)
+    void play(int soundId, AudioMixer::Priority priority = AudioMixer::PRIORITY_PLAYER, int lane = 0);
     void playByName(const std::string& name);
+    // 曲内時刻 songMs のサンプル位置から鳴らす (BGM の先行スケジュール用)
+    void schedule(int soundId, double songMs, AudioMixer::Priority priority = AudioMixer::PRIORITY_BGM);
+    // ゲームループの cur_ms と同じ時計で「今が曲内の何 ms か」を渡す
+    void setSongClock(double songMsNow) { mixer.setSongClock(songMsNow); }
     
     void clear();
     void stopAll();
     void cleanup();
 
+    // --- BGM 事前ミックス ---
+    // isBGM のノーツ (レーン 1〜8 以外) を、ロード済みのキー音から1本の PCM トラックに
+    // ワーカースレッドで並列レンダリングする。メモリ予算を超える・確保に失敗する場合は
+    // false を返し、従来どおりノーツごとにボイスを使う経路にフォールバックする。
+    // onProgress(done, total) はメインスレッドから呼ばれる。
+    // cacheKey (譜面パス) が前回と同じならトラックを作り直さずに再利用する (リトライ用)。
+    bool premixBgm(const std::vector<PlayableNote>& notes, const std::string& cacheKey,
+                   std::function<void(int, int)> onProgress = nullptr);
+    bool hasPremixedBgm() const { return premixTrack != nullptr; }
+    // 事前ミックス済みトラックを曲内 0ms にスケジュールする (setSongClock の後に呼ぶ)
+    void startPremixedBgm();
+    void freePremix();
+    // 残っているトラックが cacheKey の譜面のものでなければ解放する (キー音を読む前に呼ぶ。
+    // 空文字列なら必ず解放)。clear() の後もトラックは currentTotalMemory に計上されたまま
+    void keepPremixFor(const std::string& cacheKey);
+
+    // ============================================================
+    //  【追加】プレビューはバックグラウンドで読みながら鳴らす (PreviewStream 参照)
+    //  どちらも待たずに戻る。カーソル移動で stopPreview() すると 30ms で絞って止まる。
+    //  resolvePath を渡すと、再生するファイルのパスをプレビュー用スレッドで求める
+    //  (譜面ヘッダの読み込みを UI スレッドから外すため)。key は同じ曲の再要求を
+    //  無視するための識別子。
+    // ============================================================
     void playPreview(const std::string& fullPath);
+    void playPreview(const std::string& key, std::function<std::string()> resolvePath);
     void stopPreview();
+    // 【追加】フォルダの決定音など、1回だけ鳴らす効果音。プレビューと同じ経路
+    //         (読み込み・デコードはプレビュー用スレッド) を使い、待たずに戻る。
+    //         鳴っているプレビューは絞って止まり、次のプレビューが来れば効果音の方が止まる
+    void playEffect(const std::string& fullPath);
 
-    uint64_t getCurrentMemory() const { return currentTotalMemory; }
+    uint64_t getCurrentMemory() const { return currentTotalMemory.load(std::memory_order_relaxed); }
     uint64_t getMaxMemory() const { return MAX_WAV_MEMORY; }
 
+    // ============================================================
+    //  【追加】デコード後サイズでの予算管理と優先度付きの追い出し
+    //
+    //  WAV Memory は読み込み元のサイズではなくチャンクの実サイズ (alen) で数える。
+    //  予算 (MAX_WAV_MEMORY) を超える音が届いたら、それより重要度の低い常駐音を
+    //  追い出して空ける。空けられなければ届いた方を捨てる。
+    //    重要度: プレイヤーレーンで使う音 > BGM レーンだけの音 > 譜面で使われない音。
+    //            同じ区分では 使用回数 / 長さ(秒) が大きいほど重要 (短くてよく鳴る音を残す)
+    //  追い出しはロード関数が戻るまで (= まだ1音も鳴らしていない間) だけ行う。
+    //  以降に届いた音 (演奏中のストリーミング分) は、鳴っている音を消せないので捨てる。
+    //  ロード前に setSoundUsage() で譜面の使われ方を渡しておくこと。
+    // ============================================================
+    void setSoundUsage(const std::vector<PlayableNote>& notes);
+    struct DroppedSound {
+        std::string name;
+        uint64_t    bytes   = 0;     // デコード後のサイズ
+        bool        player  = false; // プレイヤーレーンで使う音
+        bool        evicted = false; // 一度常駐してから追い出した (false = 届いた時点で捨てた)
+    };
+    std::vector<DroppedSound> getDroppedSounds();
+
+    // --- デコード済みキャッシュの統計 (clear() 以降のロード分) ---
+    uint32_t getCacheHits()   const { return cacheHits.load(std::memory_order_relaxed); }
+    uint32_t getCacheMisses() const { return cacheMisses.load(std::memory_order_relaxed); }
+    uint64_t getCacheBytes()  const { return cacheBytes.load(std::memory_order_relaxed); }
+    // 同じ内容のサンプルを共有したことで WAV Memory に計上せずに済んだバイト数 / 共有した数
+    uint64_t getDedupBytes()  const { return dedupBytes.load(std::memory_order_relaxed); }
+    uint32_t getDedupCount()  const { return dedupCount.load(std::memory_order_relaxed); }
+    // 今の譜面が使っていないキャッシュを全て破棄する (終了時・メモリ逼迫時)
+    void purgeCache();
+
+    // ============================================================
+    //  【追加】前後の無音の切り落とし (SilenceTrimmer 参照)
+    //  デコード直後に SILENCE_TRIM_DB 以下の先頭・末尾を切り、先頭を切った分は
+    //  オンセットとして発音時に遅らせる (聞こえるタイミングは変わらない)。
+    //  末尾を切った分だけボイスが早く空く。
+    // ============================================================
+    struct TrimReport {
+        uint32_t trimmedSounds = 0; // 今の譜面で切り落とした音の数
+        uint64_t savedBytes    = 0; // それで WAV Memory から減った分
+        double   voicesBefore  = 0.0; // 譜面どおり鳴らした時の平均同時発音数 (切る前の長さで見積もり)
+        double   voicesAfter   = 0.0; // 同 (切った後の長さ)
+        uint32_t adpcmSounds     = 0; // ADPCM で持っている音の数 (KEYSOUND_ADPCM)
+        uint64_t adpcmSavedBytes = 0; // それで WAV Memory から減った分
+    };
+    // notes の発音で見積もる。includeBgm = false なら BGM レーン (事前ミックス時) を除く
+    TrimReport getTrimReport(const std::vector<PlayableNote>& notes, bool includeBgm);
+
+    // ============================================================
+    //  【追加】長いキー音のディスクストリーミング (SoundStream 参照)
+    //  STREAM_SOUND_SEC 以上の PCM WAV は常駐させず、先頭だけ読んでおいて残りを
+    //  読み込みスレッドが鳴らしながら読む。play() / schedule() からはそのまま鳴らせる
+    //  (1音につき同時に1ボイス。再発音は頭から)。事前ミックスには焼き込まない。
+    // ============================================================
+    bool isStreamed(int soundId) const;
+    uint32_t getStreamedSounds() const { return streamedSounds.load(std::memory_order_relaxed); }
+    // 常駐させずに済んだ分 (変換後の全長 - 先読み・ダブルバッファ)
+    uint64_t getStreamSavedBytes() const { return streamSavedBytes.load(std::memory_order_relaxed); }
+    // 読み込みが間に合わず無音で埋めた回数 (今の譜面の分)
+    uint64_t getStreamUnderruns();
+
+    // ============================================================
+    //  【追加】オーディオ形式の自動選択と途切れの監視 (AudioCalibrator 参照)
+    //  初回の init() で AUDIO_AUTO なら候補を計測して選び、デバイスを1回だけ開く。
+    //  演奏中の途切れは getMixerStats().underruns。演奏後に adaptBufferAfterSong() を
+    //  呼ぶと、途切れた曲が何曲か続いた場合に次回起動時のバッファ (AUDIO_MIN_BUFFER) を広げ、
+    //  途切れない曲が続けば少しずつ戻す (続いた曲数は AUDIO_BUFFER_STREAK に保存)。
+    // ============================================================
+    struct AudioSettings {
+        int    rate       = 22050;
+        int    channels   = 1;
+        int    buffer     = 512;
+        bool   calibrated = false; // AudioCalibrator で選んだ
+        double worstUs    = 0.0;   // その時の最悪ケースのコールバック時間
+        double periodUs   = 0.0;
+    };
+    const AudioSettings& getAudioSettings() const { return audioSettings; }
+    void adaptBufferAfterSong();
+
+    AudioMixer::Stats getMixerStats() const { return mixer.getStats(); } // メインスレッドから
+    void resetMixerStats() { mixer.resetStats(); }
+
+    // 【追加】打鍵 → 音 → 画面の遅延計測 (LatencyProbe 参照)。
+    //         play() は処理中の打鍵 (currentHit) をボイスに結び付け、PLAY 段階を書く
+    LatencyProbe& getLatencyProbe() { return latency; }
+
     // --- ヘルパー: 文字列からのID生成（一貫性維持用） ---
     inline uint32_t getHash(const std::string& name) const {
         return std::hash<std::string>{}(name);
     }
 
 private:
-    SoundManager() : currentPreviewChunk(nullptr), currentTotalMemory(0) {} 
+    SoundManager() : currentTotalMemory(0) { mixer.setLatencyProbe(&latency); }
     ~SoundManager() { cleanup(); }
     SoundManager(const SoundManager&) = delete;
     SoundManager& operator=(const SoundManager&) = delete;
 
+    // SDL_mixer の音楽フック経由で呼ばれるオーディオコールバック
+    static void mixCallback(void* udata, Uint8* stream, int len);
+    // オーディオスレッドを一時的に止めて mixer を直接触るための同期点
+    void withAudioStopped(const std::function<void()>& fn);
+
     struct BoxEntry {
         std::string pckPath;
         uint32_t offset;
         uint32_t size;
+        // v2 のみ: FORMAT_S16 なら変換済み PCM (v1 は常に FORMAT_FILE)
+        uint16_t format   = BoxWav::FORMAT_FILE;
+        uint16_t channels = 0;
+        uint32_t rate     = 0;
     };
 
     // --- 最適化: キーを std::string から uint32_t (ハッシュID) に変更 ---
     // これにより PlayableNote のコピーから std::string が消え、演奏中の検索が高速化されます
-    std::unordered_map<uint32_t, Mix_Chunk*> sounds;
-    std::unordered_map<uint32_t, int> activeChannels;
+    // ★非同期ロード中はワーカーが値を書き込むため atomic。エントリの追加・削除
+    //   (= マップの構造変更) はワーカーが止まっている時にメインスレッドだけが行う。
+    // 【追加】onsetFrames: 先頭の無音を切った分。adpcmSamples: 0 以外なら chunk->abuf は
+    //         AdpcmCodec の圧縮データで、展開後のサンプル数を表す。
+    //         どちらも chunk より先に書き、chunk の acquire で読む
+    struct SoundSlot {
+        std::atomic<Mix_Chunk*> chunk{nullptr};
+        std::atomic<uint32_t>   onsetFrames{0};
+        std::atomic<uint32_t>   adpcmSamples{0};
+        std::atomic<SoundStream*> stream{nullptr}; // ディスクから流す音 (chunk は nullptr のまま)
+    };
+    std::unordered_map<uint32_t, SoundSlot> sounds;
     
     // ロード時にファイル名で検索する必要があるため、ここは string を維持
     std::unordered_map<std::string, BoxEntry> boxIndex;
+    std::string boxIndexKey; // boxIndex を作った (rootPath, bmsonName)。同じ譜面なら再走査しない
+
+    // ============================================================
+    //  曲をまたぐデコード済み PCM キャッシュ
+    //
+    //  旧実装は ScenePlay::run の前後で clear() し、リトライや同じ曲の別難易度でも
+    //  SD から全サンプルを読み直してデコードしていた。
+    //  clear() は「今の譜面が使っている」参照を外すだけにし、チャンクはキャッシュに
+    //  残す。キャッシュは SOUND_CACHE_MB の予算を超えた分を、使われていないものから
+    //  LRU 順に解放する。予算は今の譜面の分も含めて数え、MAX_WAV_MEMORY で頭打ちにする
+    //  (曲の常駐分とキャッシュの合計が WAV Memory の予算を超えないように)。
+    //
+    //  キー = ファイルパス | box エントリ名 | オフセット | サイズ | 内容タグ
+    //  内容タグはコンテナファイルのサイズと更新時刻から作る。ヒット判定のために
+    //  サンプル本体を読むと、キャッシュで省きたい SD アクセスそのものが発生するため。
+    // ============================================================
+    struct CacheEntry {
+        Mix_Chunk* chunk       = nullptr;
+        uint64_t   bytes       = 0;  // デコード後のサイズ (キャッシュ予算の計算用)
+        uint64_t   sourceBytes = 0;  // 読み込み元のサイズ (WAV Memory 表示の計算用)
+        bool       active      = false;
+        std::list<std::string>::iterator lruIt; // active でない間だけ有効 (cacheLru 内の位置)
+    };
+    std::unordered_map<std::string, CacheEntry> decodedCache;
+    std::list<std::string> cacheLru;              // 追い出し候補 (今の譜面が参照していないエントリ)。先頭 = 最近使った
+    std::vector<std::string> activeCacheKeys;     // 今の譜面が参照しているキー
+    std::unordered_map<std::string, uint64_t> fileTagCache; // パス → 内容タグ (曲ごとに作り直す)
+    std::atomic<uint64_t> cacheBytes{0};
+    std::atomic<uint32_t> cacheHits{0};
+    std::atomic<uint32_t> cacheMisses{0};
+    std::mutex cacheMutex; // insertCached はワーカーからも呼ばれる
+
+    std::string makeCacheKey(const std::string& path, const std::string& entryName,
+                             uint32_t offset, uint32_t size);
+    // ヒットしたら sounds に登録して true
+    bool acquireCached(const std::string& key, uint32_t id);
+    void insertCached(const std::string& key, uint32_t id, Mix_Chunk* chunk, uint64_t sourceBytes,
+                      uint32_t onsetFrames = 0, uint32_t untrimmedLen = 0, uint32_t adpcmSamples = 0);
+    void releaseActiveCache();
+    // 今の譜面が参照し始めたら追い出し候補から外し、外したら戻す。cacheMutex を持って呼ぶ
+    void activateLocked(const std::string& key, CacheEntry& e);
+    void deactivateLocked(const std::string& key, CacheEntry& e);
+    uint64_t cacheBudget() const;
+    void trimCache(uint64_t budget); // cacheMutex を持っているか、ワーカー停止中に呼ぶ
+
+    // --- WAV Memory の予算管理 (setSoundUsage 参照) ---
+    struct SoundUsage {
+        uint32_t uses   = 0;
+        bool     player = false;
+    };
+    struct Resident {
+        std::string key;   // キャッシュキー
+        uint64_t    bytes; // チャンクのサイズ (共有されていれば計上は1回だけ)
+        Mix_Chunk*  chunk;
+        std::multimap<double, uint32_t>::iterator orderIt; // residentOrder 内の位置
+    };
+    std::unordered_map<uint32_t, SoundUsage>  soundUsage;  // ロード中は読むだけ
+    std::unordered_map<uint32_t, std::string> soundNames;  // 報告用。ワーカー起動前に登録する
+    std::unordered_map<uint32_t, Resident>    residents;   // 今の譜面に登録した音 (cacheMutex)
+    // 常駐音を重要度の低い順に並べたもの (追い出し候補)。登録・追い出しの度に1件ずつ更新する (cacheMutex)
+    std::multimap<double, uint32_t>           residentOrder;
+    std::vector<DroppedSound> droppedSounds;               // cacheMutex
+    bool residentLocked = false; // true 以降は追い出さない (cacheMutex)
+    // 重要度 = 使用回数 / 長さ。長さは展開・無音カット前の PCM のバイト数 (pcmBytesLocked) から求める
+    double importance(uint32_t id, uint64_t pcmBytes) const;
+    // ★ADPCM の alen は圧縮後のサイズなので、長さには使えない
+    uint64_t pcmBytesLocked(Mix_Chunk* chunk) const;
+    // id (bytes) を計上できるなら true。必要なら重要度の低い常駐音を追い出す。cacheMutex を持って呼ぶ
+    bool admitLocked(uint32_t id, uint64_t bytes, uint64_t pcmBytes);
+    void lockResidents();
+    // id として今の譜面に登録する (予算に入らなければ false)。cacheMutex を持って呼ぶ
+    bool makeResidentLocked(const std::string& key, CacheEntry& e, uint32_t id);
+
+    // ============================================================
+    //  【追加】内容の重複排除
+    //  パックには同じサンプルが別名 (難易度ごとのコピー・リネーム) で何度も入っている。
+    //  I/O スレッドが読んだバイト列のハッシュで重複を見つけ、2つ目以降はデコードせず
+    //  最初のチャンクを共有する (キャッシュには別名のエントリとして入れ、chunkRefs で
+    //  参照を数える。最後のエントリが削られた時にだけ解放する)。
+    //  WAV Memory は同じチャンクを1回だけ計上し、共有で浮いた分を dedupBytes に数える。
+    // ============================================================
+    std::unordered_map<Mix_Chunk*, uint32_t> chunkRefs;     // キャッシュのエントリ数 (cacheMutex)
+    std::unordered_map<Mix_Chunk*, uint32_t> songChunkRefs; // 今の譜面で登録している id 数 (cacheMutex)
+    std::atomic<uint64_t> dedupBytes{0};
+    std::atomic<uint32_t> dedupCount{0};
+    // 無音を切ったチャンクの元の情報 (切っていないチャンクは載らない)。cacheMutex
+    struct TrimInfo {
+        uint32_t onsetFrames;
+        uint32_t untrimmedLen; // 切る前の alen
+    };
+    std::unordered_map<Mix_Chunk*, TrimInfo> chunkTrims;
+    std::atomic<uint32_t> trimmedSounds{0}; // 今の譜面の分
+    std::atomic<uint64_t> trimSavedBytes{0};
+    // 前後の無音を切り詰める (ワーカーから呼ばれる)。切らなければ onsetFrames = untrimmedLen = 0
+    void trimSilence(Mix_Chunk* chunk, uint32_t& onsetFrames, uint32_t& untrimmedLen);
+    // ============================================================
+    //  【追加】めったに鳴らない音・BGM レーンだけの音の ADPCM 保持
+    //  デコード後の PCM を AdpcmCodec で約 1/4 に縮めて持ち、ミキサーのボイスが
+    //  鳴らしながら展開する (事前ミックスはロード時に展開して焼き込む)。
+    //  プレイヤーレーンでよく鳴る音は PCM のまま。判定はロード時の譜面 (soundUsage) で行う。
+    //  キャッシュに残った音の形式が次の譜面での判定と合わなければ、ミス扱いでデコードし直す。
+    // ============================================================
+    std::unordered_map<Mix_Chunk*, uint32_t> chunkAdpcm; // チャンク → 展開後のサンプル数 (cacheMutex)
+    std::atomic<uint32_t> adpcmSounds{0};     // 今の譜面の分
+    std::atomic<uint64_t> adpcmSavedBytes{0};
+    bool shouldCompress(uint32_t id) const;
+    bool compressible(const Mix_Chunk* chunk) const; // compressChunk が縮める長さの PCM か
+    // id として使う時に chunk は ADPCM で持つべきか (cacheMutex を持って呼ぶ)
+    bool wantsAdpcm(uint32_t id, Mix_Chunk* chunk) const;
+    // chunk を ADPCM に置き換える (ワーカーから呼ばれる)。戻り値 = 展開後のサンプル数、しなければ 0
+    uint32_t compressChunk(Mix_Chunk* chunk);
+    // 常駐の計上・取り消しに合わせて trimSavedBytes / adpcmSavedBytes を増減する。cacheMutex を持って呼ぶ
+    void chargeSavingsLocked(Mix_Chunk* chunk, bool add);
+    void retainChunkLocked(Mix_Chunk* chunk, uint64_t bytes);
+    void releaseChunkLocked(Mix_Chunk* chunk, uint64_t bytes);
+    // primaryKey のチャンクを key / id でも使う。元が無くなっていれば false
+    bool insertAlias(const std::string& primaryKey, const std::string& key, uint32_t id, uint64_t sourceBytes);
+
+    // ============================================================
+    //  .boxwav パートのマッピング
+    //  パートは曲の間だけ1回ずつ開き (mapPart)、clear() で解放する。
+    //  マップの追加・削除はメインスレッドだけが行い、ワーカーには
+    //  LoadJob::part としてポインタを渡す。
+    // ============================================================
+    std::unordered_map<std::string, std::unique_ptr<MappedFile>> mappedParts;
+    MappedFile* mapPart(const std::string& path);
+    void releaseMappings();
+    static constexpr size_t PREFAULT_AHEAD = 8; // 何エントリ先までページインしておくか
+
+    // .boxwav 内の1エントリをマップ上のバイト列から直接デコードする (失敗時 nullptr)
+    Mix_Chunk* decodeBoxEntry(MappedFile& part, const BoxEntry& entry);
+    // v2 の変換済み PCM からチャンクを作る (デバイスと同じ形式ならコピーのみ)
+    Mix_Chunk* chunkFromPcm(const uint8_t* pcm, uint32_t bytes, uint16_t channels, uint32_t rate);
+    // ファイルのバイト列をデコードする。PCM WAV は WavDecoder、それ以外は SDL_mixer
+    Mix_Chunk* decodeBytes(const uint8_t* bytes, uint32_t size);
+    // 外部ファイル (box に無い音)。開けなければ nullptr
+    Mix_Chunk* decodeExternal(const std::string& path, uint64_t& fileSize);
+    // SDL_malloc したデバイス形式の PCM を、解放責任ごとチャンクに渡す
+    static Mix_Chunk* wrapPcm(Uint8* buf, uint32_t len);
+
+    // WAV デコードの統計 (ワーカーからも更新する)
+    std::atomic<uint32_t> fastDecodes{0};    // WavDecoder で変換した数
+    std::atomic<uint32_t> sdlDecodes{0};     // Mix_LoadWAV_RW にフォールバックした数
+    // Mix_LoadWAV_RW (SDL_mixer のデコーダ) はスレッドセーフを保証していないので、
+    // デコードワーカーとプレビュースレッドからの呼び出しをこれで1本に並べる
+    std::mutex sdlDecodeMutex;
+    std::atomic<uint64_t> decodeInBytes{0};
+    std::atomic<uint64_t> decodeTicks{0};    // SDL_GetPerformanceCounter 単位
+    void logDecodeStats();
+    // v2: 先頭パートの目次を読む。v1 なら false (呼び出し側が従来の走査を行う)
+    bool loadIndexV2(const std::string& rootPath, const std::string& bmsonName, MappedFile& first,
+                     const std::string& firstPath);
+
+    // --- 非同期ロードのワーカー側 ---
+    struct LoadJob {
+        std::string key;        // キャッシュキー
+        std::string name;       // 進捗表示用
+        std::string path;       // .boxwav または外部ファイル
+        MappedFile* part;       // inBox の時のみ
+        BoxEntry    box;        // inBox の時のみ (外部ファイルは I/O スレッドが size だけ埋める)
+        uint32_t    id;
+        bool        inBox;
+        bool        required;
+        double      firstUseMs;
+        int32_t     dupOf   = -1;    // 同じ内容の先行ジョブ (I/O スレッドが書く)
+        uint32_t    onsetFrames  = 0; // 無音の切り落とし・圧縮の結果 (ワーカーが書く)
+        uint32_t    untrimmedLen = 0;
+        uint32_t    adpcmSamples = 0;
+        bool        stream  = false;  // ディスクから流す (I/O スレッドが書く。読み込み・デコードはしない)
+        uint64_t    streamOffset = 0; // path 内の data チャンクの位置
+        WavDecoder::Info streamInfo;
+        bool        done    = false; // 以下は消費側のみ
+        bool        decoded = false;
+    };
+    void asyncLoadWorker();
+    // 【追加】jobs をこの順に I/O スレッドで読み、ワーカー群でデコードさせる。
+    //        結果は呼び出し側が pipeline.drain() で受け取り、insertCached する。
+    //        jobs は pipeline が止まるまで生かしておくこと
+    void startPipeline(DecodePipeline& pipeline, std::vector<LoadJob>& jobs);
+    // I/O スレッド: job のバイト列を用意する
+    bool fetchJob(LoadJob& job, DecodePipeline::Blob& out);
+    static uint64_t formatTag(const LoadJob& job); // 変換済み PCM の形式 (それ以外は 0)
+    // I/O スレッド: 内容ハッシュが一致した先行ジョブ primary と、job のバイト列が本当に同じか
+    bool sameContent(const LoadJob& primary, const LoadJob& job, const uint8_t* data, uint32_t size);
+    // I/O スレッド: ヘッダだけ読み、STREAM_SOUND_SEC 以上の PCM なら job.stream を立てて true
+    bool probeStream(LoadJob& job);
+    // 消費側: job のストリームを開いて sounds に登録する
+    void createStream(const LoadJob& job);
+    // 消費側: 完了1件をキャッシュへ登録し、重複として待たせていたジョブにもチャンクを共有させる
+    void completeJob(std::vector<LoadJob>& jobs, uint32_t i, Mix_Chunk* chunk,
+                     std::unordered_map<uint32_t, std::vector<uint32_t>>& waiting);
+
+    std::vector<LoadJob>  asyncJobs;
+    std::thread           loadThread;
+    std::atomic<bool>     asyncLoading{false};
+    std::atomic<bool>     asyncCancel{false};
+    std::atomic<uint32_t> asyncDone{0};
+    std::atomic<uint32_t> asyncRequiredDone{0}; // 完了順は前後するので必須分は別に数える
+    std::atomic<uint32_t> asyncLate{0};
+    std::atomic<uint32_t> asyncTotalMs{0};
+    uint32_t asyncStartTick = 0;
+    uint32_t missedTriggers = 0; // play/schedule (メインスレッド) からのみ更新
+    LoadStats loadStats;         // メインスレッド側で確定する分
+
+    // --- プレビュー ---
+    PreviewStream preview;                 // オーディオコールバックが mixInto する
+    std::thread   previewThread;
+    std::mutex    previewMutex;
+    std::condition_variable previewCv;
+    std::string   previewKey;              // メインスレッドのみ: 今鳴らしている (鳴らそうとしている) 曲
+    std::function<std::string()> previewResolve; // previewMutex
+    uint32_t      previewRequestGen = 0;   // previewMutex
+    bool          previewLoop = true;      // previewMutex: false なら1回鳴らして終わる (playEffect)
+    std::atomic<bool> previewQuit{false};
+    static constexpr float PREVIEW_GAIN = 80.0f / 128.0f; // 旧プレビューチャンネルの Mix_Volume(80) 相当
+    void requestPreview(const std::string& key, std::function<std::string()> resolvePath, bool loop);
+    void previewWorker();
+    // gen の間、path をデバイス形式に変換しながら preview へ流し続ける (loop なら繰り返す)
+    void streamPreview(const std::string& path, uint32_t gen, bool loop);
+    bool previewStale(uint32_t gen) const { return preview.currentGeneration() != gen; }
+
+    AudioSettings audioSettings;
+    bool          audioOpened = false;
+    void openAudio();
+
+    // --- 長いキー音のストリーミング ---
+    std::vector<std::unique_ptr<SoundStream>> streams; // streamMutex (clear() でボイスを止めてから破棄)
+    std::thread             streamThread;
+    std::mutex              streamMutex;
+    std::condition_variable streamCv;
+    std::atomic<bool>       streamQuit{false};
+    std::atomic<uint32_t>   streamedSounds{0};
+    std::atomic<uint64_t>   streamSavedBytes{0};
+    void streamWorker();
+
+    // キー音はすべて自前ミキサーで鳴らす (SDL_mixer のチャンネルは使わない)
+    AudioMixer mixer;
+    LatencyProbe latency;
+    static constexpr float KEYSOUND_GAIN   = 96.0f / 128.0f; // 旧 Mix_Volume(ch, 96) 相当
 
-    Mix_Chunk* currentPreviewChunk = nullptr;
+    // 事前ミックス済み BGM トラック (デバイスと同じフォーマット、SDL_malloc で確保)
+    int16_t* premixTrack   = nullptr;
+    uint32_t premixSamples = 0;
+    std::string premixKey;
+    static constexpr int PREMIX_MAX_THREADS = 3; // Switch のアプリ用コア数
 
-    uint64_t currentTotalMemory = 0;
+    std::atomic<uint64_t> currentTotalMemory{0};
     const uint64_t MAX_WAV_MEMORY = 512 * 1024 * 1024; 
 };
 
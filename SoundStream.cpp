@@ -0,0 +1,162 @@
+#include "SoundStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+bool SoundStream::open(const std::string& path, uint64_t offset, const WavDecoder::Info& info,
+                       int dstRate, int dstChannels) {
+    if (!file.open(path) || info.frames == 0 || info.blockAlign == 0) return false;
+    if (offset + (uint64_t)info.frames * info.blockAlign > file.size()) return false;
+    dataOffset = offset;
+    src        = info;
+    src.data   = nullptr;
+    rate       = dstRate;
+    channels   = dstChannels;
+    total      = WavDecoder::outputFrames(info, dstRate) * (uint32_t)dstChannels;
+    slotSamples = (uint32_t)((uint64_t)dstRate * SLOT_MS / 1000) * (uint32_t)dstChannels;
+    headSamples = std::min(total, (uint32_t)((uint64_t)dstRate * HEAD_MS / 1000) * (uint32_t)dstChannels);
+    if (total == 0 || slotSamples == 0) return false;
+
+    head.resize(headSamples);
+    if (!convertRange(0, headSamples, head.data())) return false;
+    for (Slot& s : slots) s.pcm.resize(slotSamples);
+    nextFill = headSamples;
+    return true;
+}
+
+uint64_t SoundStream::bufferBytes() const {
+    return ((uint64_t)head.size() + 2ull * slotSamples) * sizeof(int16_t);
+}
+
+// ============================================================
+//  convertRange — 出力サンプル [from, from + n) に当たる元データだけを読んで変換する
+//  同じレート・丁度 2 倍のレートは元のフレームと1対1 / 2対1 で対応するので境界は正確。
+//  それ以外は元の位置を切り捨てで求めるため、ブロック境界で1サンプル未満の位相ずれが出る
+//  (ブロックごとに合わせ直すので累積はしない)。
+// ============================================================
+bool SoundStream::convertRange(uint32_t from, uint32_t n, int16_t* dst) {
+    const uint32_t outFrom = from / (uint32_t)channels;
+    const uint32_t outN    = n / (uint32_t)channels;
+    if (outN == 0) return true;
+
+    uint64_t srcStart, srcEnd;
+    if ((int)src.sampleRate == rate || (int)src.sampleRate == rate * 2) {
+        const uint64_t k = (uint64_t)src.sampleRate / (uint64_t)rate;
+        srcStart = outFrom * k;
+        srcEnd   = (uint64_t)(outFrom + outN) * k;
+    } else {
+        srcStart = (uint64_t)outFrom * src.sampleRate / (uint64_t)rate;
+        srcEnd   = ((uint64_t)(outFrom + outN) * src.sampleRate + rate - 1) / (uint64_t)rate + 1;
+    }
+    srcEnd = std::min<uint64_t>(srcEnd, src.frames);
+    if (srcStart >= srcEnd) {
+        std::memset(dst, 0, (size_t)n * sizeof(int16_t));
+        return true;
+    }
+
+    const uint32_t bytes = (uint32_t)((srcEnd - srcStart) * src.blockAlign);
+    readBuf.resize(bytes);
+    if (!file.read(dataOffset + srcStart * src.blockAlign, bytes, readBuf.data())) return false;
+
+    WavDecoder::Info part = src;
+    part.data   = readBuf.data();
+    part.frames = (uint32_t)(srcEnd - srcStart);
+    uint32_t produced = WavDecoder::outputFrames(part, rate);
+    convBuf.resize((size_t)produced * channels);
+    if (produced > 0 && !WavDecoder::convert(part, convBuf.data(), rate, channels)) return false;
+
+    uint32_t copy = std::min(produced, outN) * (uint32_t)channels;
+    std::memcpy(dst, convBuf.data(), (size_t)copy * sizeof(int16_t));
+    std::memset(dst + copy, 0, (size_t)(n - copy) * sizeof(int16_t)); // 末尾の端数
+    return true;
+}
+
+// ============================================================
+//  読み込みスレッド
+// ============================================================
+
+bool SoundStream::fill() {
+    // 空き枠を先に確かめる (restart() が枠を返した後なら、新しい世代が必ず見える)
+    Slot* slot = nullptr;
+    for (Slot& s : slots) {
+        if (s.state.load(std::memory_order_acquire) == EMPTY) {
+            slot = &s;
+            break;
+        }
+    }
+    if (!slot) return false;
+
+    uint32_t g = gen.load(std::memory_order_acquire);
+    if (g != fillGen) {
+        fillGen  = g;
+        nextFill = headSamples;
+    }
+    // 読み込みが遅れて再生位置に追い越されていたら、その先から読む
+    uint32_t played = playPos.load(std::memory_order_relaxed);
+    if (played > nextFill) nextFill = played - played % (uint32_t)channels;
+    if (nextFill >= total) return false;
+
+    uint32_t n = std::min(slotSamples, total - nextFill);
+    if (!convertRange(nextFill, n, slot->pcm.data())) {
+        nextFill = total; // 読めなくなったファイルはこの世代ではもう読まない
+        return false;
+    }
+    slot->start = nextFill;
+    slot->count = n;
+    slot->gen   = g;
+    slot->state.store(FULL, std::memory_order_release);
+    nextFill += n;
+    return true;
+}
+
+// ============================================================
+//  オーディオスレッド
+// ============================================================
+
+void SoundStream::restart() {
+    playPos.store(0, std::memory_order_relaxed);
+    if (!touched) return; // head の中しか鳴らしていなければ、先読み済みの枠をそのまま使える
+    touched = false;
+    gen.fetch_add(1, std::memory_order_release);
+    for (Slot& s : slots) {
+        if (s.state.load(std::memory_order_acquire) == FULL) release(s);
+    }
+}
+
+void SoundStream::read(uint32_t pos, int16_t* dst, uint32_t n) {
+    playPos.store(pos + n, std::memory_order_relaxed);
+    const uint32_t g = gen.load(std::memory_order_relaxed);
+    uint32_t done = 0;
+    while (done < n) {
+        const uint32_t p = pos + done;
+        if (p >= total) break;
+        if (p < headSamples) {
+            uint32_t k = std::min(n - done, headSamples - p);
+            std::memcpy(dst + done, head.data() + p, (size_t)k * sizeof(int16_t));
+            done += k;
+            continue;
+        }
+
+        touched = true;
+        Slot* hit = nullptr;
+        for (Slot& s : slots) {
+            if (s.state.load(std::memory_order_acquire) != FULL) continue;
+            if (s.gen != g || s.start + s.count <= p) {
+                release(s); // 前の世代の枠・追い越した枠
+                continue;
+            }
+            if (s.start <= p) {
+                hit = &s;
+                break;
+            }
+        }
+        if (!hit) {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        uint32_t k = std::min(n - done, hit->start + hit->count - p);
+        std::memcpy(dst + done, hit->pcm.data() + (p - hit->start), (size_t)k * sizeof(int16_t));
+        done += k;
+        if (p + k >= hit->start + hit->count) release(*hit);
+    }
+    if (done < n) std::memset(dst + done, 0, (size_t)(n - done) * sizeof(int16_t));
+}
@@ -0,0 +1,98 @@
+#ifndef SOUNDSTREAM_HPP
+#define SOUNDSTREAM_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "MappedFile.hpp"
+#include "WavDecoder.hpp"
+#include "AudioMixer.hpp"
+
+// ============================================================
+//  SoundStream — 長いキー音 (BGM 1本丸ごとの WAV など) をディスクから流す
+//
+//  【旧実装の問題点】
+//    数分ある WAV チャンネルも他のキー音と同じく全体をデコードして常駐させており、
+//    1本で数十 MB の WAV Memory を使っていた。
+//
+//  【構成】
+//    head  : 先頭 HEAD_MS 分の変換済み PCM。ロード時に用意し、発音と同時に鳴らせる
+//    slots : SLOT_MS 分ずつの2枠 (ダブルバッファ)。読み込みスレッドが空き枠に
+//            続きを変換して書き、オーディオスレッドが読み終えた枠を返す。
+//            枠ごとの state (EMPTY → FULL は読み込み側、FULL → EMPTY はオーディオ側) が
+//            受け渡しの唯一の同期なので、ロックは使わない。
+//  同時に鳴らせるのは1ボイスだけ (再発音は頭から鳴らし直す。AudioMixer が前のボイスを止める)。
+//  頭から鳴らし直すと世代 (gen) が進み、前の世代で読んだ枠は捨てられる。
+//  読み込みが間に合わなかった分は無音で埋め、位置は進める (曲とのずれを作らない)。
+//
+//  対象は WavDecoder で変換できる PCM WAV (と boxwav v2 の変換済み PCM) だけ。
+//  変換はブロックごとに WavDecoder::convert を呼ぶ (プレビューの WAV ストリーミングと同じ)。
+//  SDL に依存しない。
+// ============================================================
+class SoundStream : public AudioMixer::StreamSource {
+public:
+    static constexpr uint32_t HEAD_MS = 1000;
+    static constexpr uint32_t SLOT_MS = 1000;
+
+    SoundStream() = default;
+    SoundStream(const SoundStream&) = delete;
+    SoundStream& operator=(const SoundStream&) = delete;
+
+    // path の dataOffset から始まる音声データ (形式は info。info.data は使わない) を
+    // dstRate / dstChannels に変換しながら流す。先頭 HEAD_MS 分はここで読む
+    bool open(const std::string& path, uint64_t dataOffset, const WavDecoder::Info& info,
+              int dstRate, int dstChannels);
+
+    uint32_t totalSamples() const override { return total; } // 変換後のインターリーブ総サンプル数
+    uint64_t bufferBytes()  const;                     // 常駐する分 (head + 2枠)
+
+    // --- 読み込みスレッド ---
+    // 空き枠を1つ埋めたら true。することが無ければ false
+    bool fill();
+
+    // --- オーディオスレッド ---
+    // 頭から鳴らし直す (ボイスの開始時)
+    void restart() override;
+    // 発音開始からのサンプル位置 pos から n サンプルを dst へ。届いていない分は 0
+    void read(uint32_t pos, int16_t* dst, uint32_t n) override;
+
+    uint64_t getUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+private:
+    enum : uint32_t { EMPTY = 0, FULL = 1 };
+    struct Slot {
+        std::vector<int16_t>  pcm;
+        std::atomic<uint32_t> state{EMPTY};
+        uint32_t start = 0; // 以下は FULL の間だけオーディオスレッドが読む
+        uint32_t count = 0;
+        uint32_t gen   = 0;
+    };
+
+    // 出力サンプル [from, from + n) を変換して dst へ (読み込みスレッド / open)
+    bool convertRange(uint32_t from, uint32_t n, int16_t* dst);
+    void release(Slot& s) { s.state.store(EMPTY, std::memory_order_release); }
+
+    MappedFile           file;       // open 後は読み込みスレッドのみ
+    uint64_t             dataOffset = 0;
+    WavDecoder::Info     src;
+    int                  rate     = 22050;
+    int                  channels = 1;
+    uint32_t             total    = 0;
+    uint32_t             headSamples = 0;
+    uint32_t             slotSamples = 0;
+    std::vector<int16_t> head;
+    std::vector<uint8_t> readBuf;    // 読み込みスレッド
+    std::vector<int16_t> convBuf;
+    Slot                 slots[2];
+
+    std::atomic<uint32_t> gen{0};         // オーディオスレッドのみ書く
+    std::atomic<uint32_t> playPos{0};     // オーディオスレッドのみ書く (読み込み側の追いつき用)
+    std::atomic<uint64_t> underruns{0};
+    bool     touched  = false;            // オーディオスレッド: この世代で枠を読んだか
+    uint32_t fillGen  = 0;                // 読み込みスレッド
+    uint32_t nextFill = 0;
+};
+
+#endif // SOUNDSTREAM_HPP
@@ -0,0 +1,61 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// ============================================================
+//  SpscQueue — 固定長ロックフリーリングバッファ
+//
+//  BgaManager のフレームスロットと同じ head/tail プロトコルを汎用化したもの。
+//    Producer: tail のみ書く、head のみ読む
+//    Consumer: head のみ書く、tail のみ読む
+//  インデックスは単調増加させ、Capacity (2 の冪) でマスクして使う。
+//  push/pop 自体はアロケーションなし (要素をコピーするだけ)。オーディオコールバック内で安全に使える。
+//  ★ただしコピーでアロケーションする型 (std::string など) を T にすればその限りではない。
+//    そういう値は読み取り専用の表に置き、添字を渡す (BgaManager の ImageRequest)
+// ============================================================
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+public:
+    // Producer 側。満杯なら false
+    bool push(const T& value) {
+        size_t tail = qTail.load(std::memory_order_relaxed);
+        if (tail - qHead.load(std::memory_order_acquire) >= Capacity) return false;
+        buffer[tail & (Capacity - 1)] = value;
+        qTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer 側。空なら false
+    bool pop(T& out) {
+        size_t head = qHead.load(std::memory_order_relaxed);
+        if (head == qTail.load(std::memory_order_acquire)) return false;
+        out = buffer[head & (Capacity - 1)];
+        qHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return qHead.load(std::memory_order_acquire) == qTail.load(std::memory_order_acquire);
+    }
+
+    size_t sizeApprox() const {
+        return qTail.load(std::memory_order_acquire) - qHead.load(std::memory_order_acquire);
+    }
+
+    // 両側が停止していることを呼び出し側が保証できる場合のみ使う
+    void reset() {
+        qHead.store(0, std::memory_order_relaxed);
+        qTail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> qHead{0};
+    alignas(64) std::atomic<size_t> qTail{0};
+    T buffer[Capacity];
+};
+
+#endif // SPSCQUEUE_HPP
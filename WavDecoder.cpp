@@ -0,0 +1,245 @@
+#include "WavDecoder.hpp"
+#include "AudioMixer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define WAV_USE_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WAV_USE_SSE2 1
+#endif
+
+static bool forceScalar = false;
+
+static uint16_t rd16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// ============================================================
+//  parse
+// ============================================================
+
+bool WavDecoder::parse(const uint8_t* bytes, size_t size, Info& out) {
+    if (size < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0) return false;
+
+    bool haveFmt = false;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* ck = bytes + pos;
+        uint32_t ckSize = rd32(ck + 4);
+        size_t   body   = pos + 8;
+        // data チャンクのサイズが実ファイルより大きい WAV は珍しくないので切り詰める
+        size_t   avail  = std::min<size_t>(ckSize, size - body);
+
+        if (std::memcmp(ck, "fmt ", 4) == 0 && avail >= 16) {
+            out.formatTag     = rd16(bytes + body);
+            out.channels      = rd16(bytes + body + 2);
+            out.sampleRate    = rd32(bytes + body + 4);
+            out.blockAlign    = rd16(bytes + body + 12);
+            out.bitsPerSample = rd16(bytes + body + 14);
+            // WAVE_FORMAT_EXTENSIBLE: サブフォーマット GUID の先頭 2 バイトが実際の形式
+            if (out.formatTag == 0xFFFE && avail >= 26) out.formatTag = rd16(bytes + body + 24);
+            haveFmt = true;
+        } else if (std::memcmp(ck, "data", 4) == 0) {
+            if (!haveFmt || out.blockAlign == 0) return false;
+            out.data   = bytes + body;
+            out.frames = (uint32_t)(avail / out.blockAlign);
+            break;
+        }
+        pos = body + ckSize + (ckSize & 1); // チャンクは偶数境界
+    }
+    if (!out.data || out.channels == 0 || out.sampleRate == 0) return false;
+
+    bool pcm   = out.formatTag == 1 && (out.bitsPerSample == 8 || out.bitsPerSample == 16 ||
+                                        out.bitsPerSample == 24 || out.bitsPerSample == 32);
+    bool fl32  = out.formatTag == 3 && out.bitsPerSample == 32;
+    if (!pcm && !fl32) return false;
+    return out.blockAlign == out.channels * (out.bitsPerSample / 8);
+}
+
+uint32_t WavDecoder::outputFrames(const Info& in, int dstRate) {
+    if (dstRate <= 0 || in.sampleRate == 0) return 0;
+    if ((int)in.sampleRate == dstRate)     return in.frames;
+    if ((int)in.sampleRate == dstRate * 2) return in.frames / 2;
+    return (uint32_t)((uint64_t)in.frames * (uint64_t)dstRate / in.sampleRate);
+}
+
+// ============================================================
+//  融合カーネル (int16 → int16)
+//    avgPairs: out[i] = (in[2i] + in[2i+1] + 1) >> 1
+//    avgQuads: out[i] = (in[4i] + … + in[4i+3] + 2) >> 2
+//  SIMD 版とスカラー版は同じ丸めで、結果はビット単位で一致する。
+// ============================================================
+
+static void avgPairsScalar(const int16_t* in, int16_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = (int16_t)((in[2 * i] + in[2 * i + 1] + 1) >> 1);
+}
+
+static void avgQuadsScalar(const int16_t* in, int16_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int32_t s = in[4 * i] + in[4 * i + 1] + in[4 * i + 2] + in[4 * i + 3];
+        out[i] = (int16_t)((s + 2) >> 2);
+    }
+}
+
+#if defined(WAV_USE_NEON)
+static void avgPairsSimd(const int16_t* in, int16_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t a = vpaddlq_s16(vld1q_s16(in + 2 * i));     // 4 組の和
+        int32x4_t b = vpaddlq_s16(vld1q_s16(in + 2 * i + 8));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vrshrq_n_s32(a, 1)), vqmovn_s32(vrshrq_n_s32(b, 1))));
+    }
+    avgPairsScalar(in + 2 * i, out + i, n - i);
+}
+
+static void avgQuadsSimd(const int16_t* in, int16_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t a = vpaddlq_s16(vld1q_s16(in + 4 * i));     // フレームごとの L+R
+        int32x4_t b = vpaddlq_s16(vld1q_s16(in + 4 * i + 8));
+        int32x4_t s = vpaddq_s32(a, b);                         // 隣接フレームの和
+        vst1_s16(out + i, vqmovn_s32(vrshrq_n_s32(s, 2)));
+    }
+    avgQuadsScalar(in + 4 * i, out + i, n - i);
+}
+#elif defined(WAV_USE_SSE2)
+static void avgPairsSimd(const int16_t* in, int16_t* out, size_t n) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i bias = _mm_set1_epi32(1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i)), ones);
+        __m128i b = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 8)), ones);
+        a = _mm_srai_epi32(_mm_add_epi32(a, bias), 1);
+        b = _mm_srai_epi32(_mm_add_epi32(b, bias), 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+    avgPairsScalar(in + 2 * i, out + i, n - i);
+}
+
+static void avgQuadsSimd(const int16_t* in, int16_t* out, size_t n) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i bias = _mm_set1_epi32(2);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // madd で隣接 2 サンプル (= 1 フレームの L+R) の和、シャッフルで隣接フレームを足す
+        __m128 a = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i)), ones));
+        __m128 b = _mm_castsi128_ps(_mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i + 8)), ones));
+        __m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i odd  = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128i s    = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), bias), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(s, s));
+    }
+    avgQuadsScalar(in + 4 * i, out + i, n - i);
+}
+#else
+static void avgPairsSimd(const int16_t* in, int16_t* out, size_t n) { avgPairsScalar(in, out, n); }
+static void avgQuadsSimd(const int16_t* in, int16_t* out, size_t n) { avgQuadsScalar(in, out, n); }
+#endif
+
+// ============================================================
+//  汎用経路: 元のサンプル形式 → float (int16 スケール) → 線形補間 → int16
+// ============================================================
+
+static float sampleToFloat(const uint8_t* p, const WavDecoder::Info& in) {
+    switch (in.bitsPerSample) {
+        case 8:  return ((float)p[0] - 128.0f) * 256.0f;
+        case 16: return (float)(int16_t)rd16(p);
+        case 24: return (float)((int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8) / 256.0f;
+        default: {
+            uint32_t u = rd32(p);
+            if (in.formatTag == 3) {
+                float f;
+                std::memcpy(&f, &u, 4);
+                return f * 32768.0f;
+            }
+            return (float)(int32_t)u / 65536.0f;
+        }
+    }
+}
+
+// 1 フレームを出力チャンネル数に合わせて取り出す (モノラル化は全チャンネル平均)
+static void frameToFloat(const WavDecoder::Info& in, uint32_t frame, int dstCh, float* out) {
+    const uint8_t* p   = in.data + (size_t)frame * in.blockAlign;
+    const int      bps = in.bitsPerSample / 8;
+    if (dstCh == 1) {
+        float sum = 0.0f;
+        for (int c = 0; c < in.channels; c++) sum += sampleToFloat(p + c * bps, in);
+        out[0] = sum / (float)in.channels;
+    } else {
+        out[0] = sampleToFloat(p, in);
+        out[1] = (in.channels >= 2) ? sampleToFloat(p + bps, in) : out[0];
+    }
+}
+
+static void convertGeneric(const WavDecoder::Info& in, int16_t* dst, uint32_t outFrames, int dstRate, int dstCh) {
+    // 入力位置は 32.32 固定小数点で進める
+    const uint64_t step = ((uint64_t)in.sampleRate << 32) / (uint64_t)dstRate;
+    const uint32_t last = in.frames - 1;
+    constexpr uint32_t BLOCK = 512; // 出力フレーム単位
+
+    float block[BLOCK * 2];
+    uint64_t pos = 0;
+    for (uint32_t o = 0; o < outFrames; o += BLOCK) {
+        uint32_t n = std::min(BLOCK, outFrames - o);
+        for (uint32_t k = 0; k < n; k++, pos += step) {
+            uint32_t idx  = (uint32_t)(pos >> 32);
+            float    frac = (float)(pos & 0xFFFFFFFFu) * (1.0f / 4294967296.0f);
+            float a[2], b[2];
+            frameToFloat(in, std::min(idx, last), dstCh, a);
+            if (frac != 0.0f) {
+                frameToFloat(in, std::min(idx + 1, last), dstCh, b);
+                for (int c = 0; c < dstCh; c++) a[c] += (b[c] - a[c]) * frac;
+            }
+            for (int c = 0; c < dstCh; c++) block[k * dstCh + c] = a[c];
+        }
+        AudioMixer::store(dst + (size_t)o * dstCh, block, (int)(n * dstCh));
+    }
+}
+
+// ============================================================
+//  convert
+// ============================================================
+
+bool WavDecoder::convert(const Info& in, int16_t* dst, int dstRate, int dstChannels) {
+    if (!dst || dstRate <= 0 || (dstChannels != 1 && dstChannels != 2)) return false;
+    uint32_t outFrames = outputFrames(in, dstRate);
+    if (outFrames == 0) return true;
+
+    // 16bit の data はリトルエンディアン int16 の配列としてそのまま読める
+    const int16_t* s16 = reinterpret_cast<const int16_t*>(in.data);
+    const bool is16     = in.formatTag == 1 && in.bitsPerSample == 16 &&
+                          ((uintptr_t)in.data & 1) == 0; // 奇数番地の data は汎用経路で読む
+    const bool sameRate = (int)in.sampleRate == dstRate;
+    const bool halfRate = (int)in.sampleRate == dstRate * 2;
+    auto pairs = forceScalar ? avgPairsScalar : avgPairsSimd;
+    auto quads = forceScalar ? avgQuadsScalar : avgQuadsSimd;
+
+    if (is16) {
+        if (sameRate && in.channels == dstChannels) {
+            std::memcpy(dst, s16, (size_t)outFrames * dstChannels * sizeof(int16_t));
+            return true;
+        }
+        if (sameRate && in.channels == 2 && dstChannels == 1) { pairs(s16, dst, outFrames); return true; }
+        if (halfRate && in.channels == 1 && dstChannels == 1) { pairs(s16, dst, outFrames); return true; }
+        if (halfRate && in.channels == 2 && dstChannels == 1) { quads(s16, dst, outFrames); return true; }
+    }
+
+    convertGeneric(in, dst, outFrames, dstRate, dstChannels);
+    return true;
+}
+
+void WavDecoder::setForceScalar(bool v) { forceScalar = v; }
+
+const char* WavDecoder::kernelName() {
+#if defined(WAV_USE_NEON)
+    return "NEON";
+#elif defined(WAV_USE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
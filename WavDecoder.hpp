@@ -0,0 +1,55 @@
+#ifndef WAVDECODER_HPP
+#define WAVDECODER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// ============================================================
+//  WavDecoder — キー音専用の WAV パーサ + 形式変換
+//
+//  【旧実装の問題点】
+//    全キー音が Mix_LoadWAV_RW → SDL_LoadWAV_RW → SDL_AudioCVT を通っていた。
+//    SDL の汎用パイプラインは段ごとに中間バッファを確保し、
+//    44.1kHz ステレオ 16bit (キー音の大半) → 22050Hz モノラルに何段も掛けていた。
+//
+//  【構成】
+//    parse()   : RIFF/WAVE を読み、fmt / data チャンクの位置だけ取り出す (コピーなし)
+//    convert() : 出力先 (最終的なチャンクのバッファ) へ1回だけ書く
+//      - 16bit で、レートが同じか丁度 2 倍、かつチャンネルがそのまま/2→1 の組み合わせは
+//        int16 → int16 の融合カーネル (NEON / SSE2) で1パス
+//          44.1k ステレオ → 22.05k モノラル : 4 サンプル平均 (ダウンミックス + 2:1 間引き)
+//          2ch → 1ch / 44.1k → 22.05k モノラル : 2 サンプル平均
+//      - それ以外 (8/24/32bit・float・任意レート) はブロック単位で float に展開し、
+//        線形補間でリサンプルして AudioMixer::store (SIMD 飽和変換) で書き出す。
+//        SDL_AUDIO_RESAMPLING_MODE=linear と同じ品質。
+//
+//  SDL に依存しないため tools/ のベンチマークからもそのまま使える。
+//  出力はネイティブエンディアンの int16 (Switch / x86 はリトルエンディアン)。
+// ============================================================
+class WavDecoder {
+public:
+    struct Info {
+        uint16_t       formatTag     = 0;  // 1 = PCM, 3 = IEEE float (EXTENSIBLE はサブフォーマットで解決済み)
+        uint16_t       channels      = 0;
+        uint32_t       sampleRate    = 0;
+        uint16_t       bitsPerSample = 0;
+        uint16_t       blockAlign    = 0;
+        const uint8_t* data          = nullptr; // 元のバイト列内の data チャンク
+        uint32_t       frames        = 0;
+    };
+
+    // 対応外 (圧縮形式・壊れたヘッダ等) なら false。呼び出し側は SDL 経由にフォールバックする
+    static bool parse(const uint8_t* bytes, size_t size, Info& out);
+
+    // 変換後のフレーム数
+    static uint32_t outputFrames(const Info& in, int dstRate);
+
+    // dst に outputFrames(in, dstRate) × dstChannels 個の int16 を書く
+    static bool convert(const Info& in, int16_t* dst, int dstRate, int dstChannels);
+
+    // ベンチマーク用: 融合カーネルの SIMD を無効化する
+    static void setForceScalar(bool v);
+    static const char* kernelName();
+};
+
+#endif // WAVDECODER_HPP
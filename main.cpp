@@ -215,13 +215,22 @@ int main(int argc, char* argv[]) {
                     SDL_Delay(500); 
 
                     // プレイ実行
-                    bool playFinishedNormal = scenePlay.run(ren, SoundManager::getInstance(), renderer, selectedPath);
-                    PlayStatus status = scenePlay.getStatus();
+                    // 【追加】フリープレイではリザルトから同じ譜面をリトライできる
+                    bool playFinishedNormal = false;
+                    PlayStatus status;
+                    bool retry = false;
+                    do {
+                        playFinishedNormal = scenePlay.run(ren, SoundManager::getInstance(), renderer, selectedPath);
+                        status = scenePlay.getStatus();
+                        retry = false;
+                        if (playFinishedNormal) {
+                            // リザルト表示
+                            retry = sceneResult.run(ren, renderer, status, scenePlay.getHeader(), isFreePlay);
+                        }
+                    } while (retry);
+                    scenePlay.releaseBga();
 
                     if (playFinishedNormal) {
-                        // リザルト表示
-                        sceneResult.run(ren, renderer, status, scenePlay.getHeader());
-
                         if (isFreePlay) {
                             // フリープレイ時は解禁状態(6)を維持して即選曲へ戻る
                             sceneSelect.init(false, ren, renderer, 6);
@@ -0,0 +1,45 @@
+#ifndef WAVFIXTURE_HPP
+#define WAVFIXTURE_HPP
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+//  WavFixture — ベンチマーク用の WAV (PCM, 44 バイトヘッダ) を組み立てる (ホスト用)
+//
+//  beginWav() でヘッダを書いたあと、呼び出し側が putSample() で
+//  frames × channels 個のサンプルを書き足す。
+//  wav_decode_bench / decode_pipeline_bench / sound_stream_bench が使う。
+// ============================================================
+namespace WavFixture {
+
+inline void put16(std::vector<uint8_t>& v, uint16_t x) { v.push_back(x & 0xFF); v.push_back(x >> 8); }
+inline void put32(std::vector<uint8_t>& v, uint32_t x) { put16(v, x & 0xFFFF); put16(v, x >> 16); }
+
+// 16bit はそのまま、24bit は下位バイトを 0 にして書く
+inline void putSample(std::vector<uint8_t>& v, int bits, int16_t s) {
+    if (bits == 24) v.push_back(0);
+    put16(v, (uint16_t)s);
+}
+
+inline void beginWav(std::vector<uint8_t>& v, int rate, int channels, int bits, uint32_t frames) {
+    const uint32_t blockAlign = (uint32_t)channels * (bits / 8);
+    const uint32_t dataBytes  = frames * blockAlign;
+    v.reserve(v.size() + 44 + dataBytes);
+    v.insert(v.end(), {'R', 'I', 'F', 'F'});
+    put32(v, 36 + dataBytes);
+    v.insert(v.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    put32(v, 16);
+    put16(v, 1);
+    put16(v, (uint16_t)channels);
+    put32(v, (uint32_t)rate);
+    put32(v, (uint32_t)rate * blockAlign);
+    put16(v, (uint16_t)blockAlign);
+    put16(v, (uint16_t)bits);
+    v.insert(v.end(), {'d', 'a', 't', 'a'});
+    put32(v, dataBytes);
+}
+
+} // namespace WavFixture
+
+#endif // WAVFIXTURE_HPP
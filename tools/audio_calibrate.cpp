@@ -0,0 +1,44 @@
+// ============================================================
+//  audio_calibrate — AudioCalibrator の候補と計測結果の一覧 (ホスト用)
+//
+//  ゲームの起動時と同じ合成負荷 (MAX_VOICES 本 + 毎コールバック 8 発の奪い合い) を
+//  全候補に掛け、最悪のコールバック時間と周期に対する割合を出す。
+//  最後に、起動時の選び方 (短い遅延から順に試して最初に収まったもの) の結果を出す。
+//
+//  使い方: make -C tools audio_calibrate && tools/audio_calibrate [--max-rate 48000] [--max-ch 2] [--min-buffer 256] [--limit 0.3]
+// ============================================================
+#include "../AudioCalibrator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    AudioCalibrator::Limits limits;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--max-rate"   && i + 1 < argc) limits.maxRate     = std::atoi(argv[++i]);
+        else if (a == "--max-ch"     && i + 1 < argc) limits.maxChannels = std::atoi(argv[++i]);
+        else if (a == "--min-buffer" && i + 1 < argc) limits.minBuffer   = std::atoi(argv[++i]);
+        else if (a == "--limit"      && i + 1 < argc) limits.loadLimit   = std::atof(argv[++i]);
+    }
+    if (limits.maxRate < 8000 || limits.maxChannels < 1 || limits.loadLimit <= 0.0) {
+        std::fprintf(stderr, "usage: %s [--max-rate 48000] [--max-ch 2] [--min-buffer 256] [--limit 0.3]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%-7s %-3s %-7s %9s %10s %10s %7s\n", "rate", "ch", "buffer", "latency", "worst us", "period us", "load");
+    for (const auto& c : AudioCalibrator::candidates(limits)) {
+        AudioCalibrator::Measurement m = AudioCalibrator::measure(c, limits.loadLimit);
+        std::printf("%-7d %-3d %-7d %7.1fms %10.0f %10.0f %6.1f%%%s\n", c.rate, c.channels, c.buffer, c.latencyMs(),
+                    m.worstUs, m.periodUs, 100.0 * m.worstUs / m.periodUs, m.ok ? "" : "  over");
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<AudioCalibrator::Measurement> tested;
+    AudioCalibrator::Measurement pick = AudioCalibrator::choose(limits, &tested);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("chosen: %dHz %dch %d frames (%.1fms)%s, %zu tried in %.1fms\n", pick.c.rate, pick.c.channels,
+                pick.c.buffer, pick.c.latencyMs(), pick.ok ? "" : " [none within limit]", tested.size(), ms);
+    return 0;
+}
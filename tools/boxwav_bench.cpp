@@ -0,0 +1,155 @@
+// ============================================================
+//  boxwav_bench — .boxwav 読み込み経路の比較 (ホスト用)
+//
+//  旧経路と MappedFile 経路で、全エントリを「デコーダが1回なめる」まで読む
+//  時間とピークメモリを比べる。デコード (Mix_LoadWAV_RW) 自体はどちらも同じ
+//  なので含めない。
+//    reopen : エントリごとに ifstream を開き直し、SDL_malloc 相当の一時バッファへ read
+//             (旧 loadSingleSound)
+//    stream : 1本の ifstream を seek → 一時バッファへ read (旧 loadSoundsInBulk)
+//    mmap   : MappedFile::view が返すマップ上のバイト列を直接読む
+//
+//  各モードは fork した子プロセスで走らせ、ru_maxrss (ピーク RSS) を個別に取る。
+//  mmap の RSS にはページキャッシュから貼られたページが含まれる点に注意
+//  (ヒープの一時コピーと違い、メモリが逼迫すればカーネルが捨てられる)。
+//  2回目以降はページキャッシュに載った状態 (warm) での比較になる。
+//
+//  使い方: make -C tools boxwav_bench && tools/boxwav_bench [file.boxwav]
+//          引数なしなら /tmp に 2000 エントリ (計 ~200MB) の合成ファイルを作る
+// ============================================================
+#include "../MappedFile.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct Entry { uint32_t offset, size; };
+
+static std::vector<Entry> readIndex(const std::string& path) {
+    std::vector<Entry> entries;
+    std::ifstream ifs(path, std::ios::binary);
+    uint32_t count = 0, d1, d2;
+    if (!ifs.read((char*)&count, 4)) return entries;
+    ifs.read((char*)&d1, 4);
+    ifs.read((char*)&d2, 4);
+    for (uint32_t i = 0; i < count; ++i) {
+        char name[32];
+        uint32_t size;
+        if (!ifs.read(name, 32) || !ifs.read((char*)&size, 4)) break;
+        entries.push_back({(uint32_t)ifs.tellg(), size});
+        ifs.seekg(size, std::ios::cur);
+    }
+    return entries;
+}
+
+static void writeSynthetic(const std::string& path, int count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> sizeDist(8 * 1024, 192 * 1024);
+    std::ofstream ofs(path, std::ios::binary);
+    uint32_t c = (uint32_t)count, zero = 0;
+    ofs.write((char*)&c, 4);
+    ofs.write((char*)&zero, 4);
+    ofs.write((char*)&zero, 4);
+    std::vector<char> data;
+    for (int i = 0; i < count; ++i) {
+        char name[32] = {};
+        std::snprintf(name, sizeof(name), "sound%04d.wav", i);
+        uint32_t size = sizeDist(rng);
+        data.resize(size);
+        for (auto& b : data) b = (char)rng();
+        ofs.write(name, 32);
+        ofs.write((char*)&size, 4);
+        ofs.write(data.data(), size);
+    }
+}
+
+// デコーダの代わりに全バイトを1回読む
+static uint64_t consume(const uint8_t* p, uint32_t n) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < n; i += 64) sum += p[i];
+    return sum;
+}
+
+static uint64_t runMode(const std::string& mode, const std::string& path,
+                        const std::vector<Entry>& entries, uint64_t& stagingPeak) {
+    uint64_t sum = 0;
+    stagingPeak = 0;
+    if (mode == "reopen" || mode == "stream") {
+        std::ifstream shared(path, std::ios::binary);
+        for (const auto& e : entries) {
+            std::ifstream own;
+            std::ifstream* ifs = &shared;
+            if (mode == "reopen") {
+                own.open(path, std::ios::binary);
+                ifs = &own;
+            }
+            uint8_t* tmp = (uint8_t*)std::malloc(e.size);
+            ifs->seekg(e.offset);
+            ifs->read((char*)tmp, e.size);
+            sum += consume(tmp, e.size);
+            std::free(tmp);
+            if (e.size > stagingPeak) stagingPeak = e.size;
+        }
+    } else {
+        MappedFile part;
+        if (!part.open(path)) return 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (i + 8 < entries.size()) part.prefault(entries[i + 8].offset, entries[i + 8].size);
+            const uint8_t* p = part.view(entries[i].offset, entries[i].size);
+            if (p) sum += consume(p, entries[i].size);
+        }
+        stagingPeak = part.getStagingPeak();
+    }
+    return sum;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = (argc > 1) ? argv[1] : "/tmp/boxwav_bench.boxwav";
+    if (argc <= 1) {
+        std::printf("writing synthetic %s ...\n", path.c_str());
+        writeSynthetic(path, 2000);
+    }
+
+    std::vector<Entry> entries = readIndex(path);
+    uint64_t total = 0;
+    for (const auto& e : entries) total += e.size;
+    std::printf("%zu entries, %.1f MB\n", entries.size(), total / (1024.0 * 1024.0));
+    std::printf("%-8s %10s %10s %14s %14s\n", "mode", "ms", "MB/s", "peak RSS MB", "staging KB");
+
+    const char* modes[] = {"reopen", "stream", "mmap"};
+    for (const char* mode : modes) {
+        int fds[2];
+        if (pipe(fds) != 0) return 1;
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            uint64_t staging = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            volatile uint64_t sum = runMode(mode, path, entries, staging);
+            (void)sum;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            struct rusage ru;
+            getrusage(RUSAGE_SELF, &ru);
+            char line[128];
+            int n = std::snprintf(line, sizeof(line), "%-8s %10.1f %10.1f %14.1f %14.1f\n", mode, ms,
+                                  total / (1024.0 * 1024.0) / (ms / 1000.0), ru.ru_maxrss / 1024.0,
+                                  staging / 1024.0);
+            if (write(fds[1], line, (size_t)n) < 0) _exit(1);
+            _exit(0);
+        }
+        close(fds[1]);
+        char buf[256] = {};
+        ssize_t n = read(fds[0], buf, sizeof(buf) - 1);
+        close(fds[0]);
+        waitpid(pid, nullptr, 0);
+        if (n > 0) std::fputs(buf, stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,372 @@
+// ============================================================
+//  boxwav_pack — boxwav v2 パッカー (ホスト用)
+//
+//  WAV/OGG/FLAC のフォルダ、または既存の v1 .boxwav (name2.boxwav… も含む) から
+//  v2 パックを作る。各サンプルをミキサーの出力形式 (既定: 22050Hz モノラル int16、
+//  本体の Mix_OpenAudio と同じ) に変換済みの PCM として格納する。
+//    PCM WAV       : 本体と同じ WavDecoder で変換
+//    それ以外      : boxwav_pack_sdl (make sdl) なら SDL_mixer でデコード
+//  変換できなかったファイルは元のバイト列のまま (FORMAT_FILE) 入れ、本体側で
+//  従来どおりデコードさせる。
+//
+//  書き終えたら、本体の loadIndexV2 と同じ手順 (MappedFile + BoxWavFormat.hpp の検証関数)
+//  で全パートを読み戻し、目次の位置・形式と中身が書いたとおりか確かめる。
+//
+//  使い方:
+//    boxwav_pack [--rate 22050] [--channels 1] [--part-mb 1024] <入力フォルダ|v1.boxwav> <出力.boxwav>
+//  出力が 1 パートに収まらない場合は 出力2.boxwav, 出力3.boxwav… に分割する。
+//  SDL 版もオーディオデバイスは使わない (SDL の dummy ドライバで開く)。
+// ============================================================
+#include "../BoxWavFormat.hpp"
+#include "../MappedFile.hpp"
+#include "../WavDecoder.hpp"
+#ifdef BOXWAV_PACK_SDL
+#include <SDL.h>
+#include <SDL_mixer.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// PCM を SIMD で読みやすいよう、エントリの先頭を揃える
+static constexpr uint64_t DATA_ALIGN = 16;
+
+struct Source {
+    std::string name;    // パック内の名前 (譜面の sound_channels の name と一致させる)
+    std::string path;    // 読み込み元ファイル
+    uint64_t    offset;  // path 内の位置 (フォルダ入力なら 0)
+    uint32_t    size;    // 0 ならファイル全体
+};
+
+static std::string lower(std::string s) {
+    for (auto& c : s) c = (char)std::tolower((unsigned char)c);
+    return s;
+}
+
+static bool readBytes(const Source& src, std::vector<uint8_t>& out) {
+    std::ifstream ifs(src.path, std::ios::binary);
+    if (!ifs) return false;
+    uint64_t size = src.size;
+    if (size == 0) {
+        ifs.seekg(0, std::ios::end);
+        size = (uint64_t)ifs.tellg();
+    }
+    out.resize(size);
+    ifs.seekg((std::streamoff)src.offset);
+    return (bool)ifs.read((char*)out.data(), (std::streamsize)size);
+}
+
+// v1: count, d1, d2, count × {name[32], size, data}。name2.boxwav… も辿る
+static void collectV1(const std::string& firstPath, std::vector<Source>& out) {
+    std::string base = firstPath.substr(0, firstPath.size() - std::strlen(".boxwav"));
+    for (int partIdx = 1; partIdx <= 128; ++partIdx) {
+        std::string path = (partIdx == 1) ? firstPath : base + std::to_string(partIdx) + ".boxwav";
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs) break;
+        uint32_t count, d1, d2;
+        if (!ifs.read((char*)&count, 4)) break;
+        if (count == BoxWav::MAGIC_V2) {
+            std::fprintf(stderr, "%s is already v2\n", path.c_str());
+            break;
+        }
+        ifs.read((char*)&d1, 4);
+        ifs.read((char*)&d2, 4);
+        for (uint32_t i = 0; i < count; ++i) {
+            char name[BoxWav::NAME_LEN];
+            uint32_t size;
+            if (!ifs.read(name, sizeof(name)) || !ifs.read((char*)&size, 4)) break;
+            out.push_back({std::string(name, strnlen(name, sizeof(name))), path, (uint64_t)ifs.tellg(), size});
+            ifs.seekg(size, std::ios::cur);
+        }
+    }
+}
+
+// 読み戻し確認用のダイジェスト (64bit FNV-1a)
+static uint64_t digest(const uint8_t* p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// bytes をパックの形式の PCM にする。できなければ false (元のバイト列のまま入れる)
+static bool decodeToPcm(const std::vector<uint8_t>& bytes, int rate, int channels, std::vector<uint8_t>& pcm) {
+    WavDecoder::Info info;
+    if (WavDecoder::parse(bytes.data(), bytes.size(), info)) {
+        uint32_t frames = WavDecoder::outputFrames(info, rate);
+        pcm.resize((size_t)frames * channels * sizeof(int16_t));
+        if (frames > 0 && WavDecoder::convert(info, reinterpret_cast<int16_t*>(pcm.data()), rate, channels))
+            return true;
+    }
+#ifdef BOXWAV_PACK_SDL
+    Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(bytes.data(), (int)bytes.size()), 1);
+    if (chunk && chunk->alen > 0) {
+        pcm.assign(chunk->abuf, chunk->abuf + chunk->alen);
+        Mix_FreeChunk(chunk);
+        return true;
+    }
+    if (chunk) Mix_FreeChunk(chunk);
+#endif
+    return false;
+}
+
+// ============================================================
+//  verifyPack — 書いたパックを本体と同じ経路で読み戻す
+//  written / digests は書いた目次と各エントリの中身のダイジェスト
+//  (読み込みに失敗して size = 0 のエントリは、本体でも使われないことを確かめる)
+// ============================================================
+static bool verifyPack(const std::string& base, const std::vector<BoxWav::TocEntryV2>& written,
+                       const std::vector<uint64_t>& digests) {
+    MappedFile first;
+    if (!first.open(BoxWav::partPath(base, 0))) {
+        std::fprintf(stderr, "verify: cannot open %s\n", BoxWav::partPath(base, 0).c_str());
+        return false;
+    }
+    const uint8_t* hp = first.view(0, sizeof(BoxWav::HeaderV2));
+    BoxWav::HeaderV2 header;
+    if (!hp || !BoxWav::readHeaderV2(hp, header) || !BoxWav::isSupportedV2(header)) {
+        std::fprintf(stderr, "verify: not a readable v2 header\n");
+        return false;
+    }
+    if (header.entryCount != written.size()) {
+        std::fprintf(stderr, "verify: entryCount %u, wrote %zu\n", header.entryCount, written.size());
+        return false;
+    }
+    // フォールバック版の view() は次の view() で無効になるので、目次は写しておく
+    std::vector<BoxWav::TocEntryV2> toc(header.entryCount);
+    const uint8_t* tp = first.view(header.tocOffset, (uint32_t)(toc.size() * sizeof(BoxWav::TocEntryV2)));
+    if (!tp) {
+        std::fprintf(stderr, "verify: TOC out of range\n");
+        return false;
+    }
+    std::memcpy(toc.data(), tp, toc.size() * sizeof(BoxWav::TocEntryV2));
+
+    std::vector<std::unique_ptr<MappedFile>> parts(header.partCount);
+    std::vector<uint64_t> partSizes(header.partCount, 0);
+    for (uint32_t p = 0; p < header.partCount; ++p) {
+        if (p > 0) {
+            parts[p] = std::make_unique<MappedFile>();
+            if (!parts[p]->open(BoxWav::partPath(base, p))) parts[p].reset();
+        }
+        MappedFile* mf = p == 0 ? &first : parts[p].get();
+        partSizes[p] = mf ? mf->size() : 0;
+    }
+
+    uint32_t bad = 0, usable = 0;
+    for (size_t i = 0; i < toc.size(); ++i) {
+        const BoxWav::TocEntryV2& e = toc[i];
+        const BoxWav::TocEntryV2& w = written[i];
+        const bool ok = BoxWav::entryUsable(e, header, partSizes.data());
+        const char* why = nullptr;
+        if (std::memcmp(e.name, w.name, BoxWav::NAME_LEN) != 0) why = "name";
+        else if (w.size == 0) { if (ok) why = "failed entry is usable"; }
+        else if (!ok) why = "out of range";
+        else if (e.format == BoxWav::FORMAT_S16 &&
+                 (e.channels != header.channels || e.sampleRate != header.sampleRate ||
+                  (uint64_t)e.frames * e.channels * sizeof(int16_t) != e.size)) why = "PCM format";
+        else {
+            MappedFile* mf = e.part == 0 ? &first : parts[e.part].get();
+            const uint8_t* bytes = mf->view(e.offset, e.size);
+            if (!bytes || digest(bytes, e.size) != digests[i]) why = "content";
+        }
+        if (ok) usable++;
+        if (why) {
+            std::fprintf(stderr, "verify: %.*s: %s\n", (int)strnlen(w.name, BoxWav::NAME_LEN), w.name, why);
+            bad++;
+        }
+    }
+    std::printf("verify: %u / %zu entries readable in %u part(s) (%s)%s\n", usable, toc.size(), header.partCount,
+                first.isZeroCopy() ? "mmap" : "staging", bad ? ", MISMATCH" : ", OK");
+    return bad == 0;
+}
+
+static void collectFolder(const std::string& dir, std::vector<Source>& out) {
+    for (const auto& de : fs::directory_iterator(dir)) {
+        if (!de.is_regular_file()) continue;
+        std::string ext = lower(de.path().extension().string());
+        if (ext != ".wav" && ext != ".ogg" && ext != ".flac") continue;
+        std::string name = de.path().filename().string();
+        if (name.size() > BoxWav::NAME_LEN) {
+            std::fprintf(stderr, "skip (name longer than %zu): %s\n", BoxWav::NAME_LEN, name.c_str());
+            continue;
+        }
+        out.push_back({name, de.path().string(), 0, 0});
+    }
+    std::sort(out.begin(), out.end(), [](const Source& a, const Source& b) { return a.name < b.name; });
+}
+
+int main(int argc, char* argv[]) {
+    int      rate     = 22050;
+    int      channels = 1;
+    uint64_t partMB   = 1024;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--rate"     && i + 1 < argc) rate     = std::atoi(argv[++i]);
+        else if (a == "--channels" && i + 1 < argc) channels = std::atoi(argv[++i]);
+        else if (a == "--part-mb"  && i + 1 < argc) partMB   = std::strtoull(argv[++i], nullptr, 10);
+        else args.push_back(a);
+    }
+    if (args.size() != 2 || rate <= 0 || channels < 1 || channels > 2 || partMB == 0) {
+        std::fprintf(stderr, "usage: %s [--rate 22050] [--channels 1] [--part-mb 1024] <input dir|v1.boxwav> <output.boxwav>\n", argv[0]);
+        return 1;
+    }
+    const std::string input = args[0], output = args[1];
+    if (output.size() < 8 || lower(output.substr(output.size() - 7)) != ".boxwav") {
+        std::fprintf(stderr, "output must end with .boxwav\n");
+        return 1;
+    }
+    // BoxEntry::offset は uint32 なので、パートは 4GB 未満に収める
+    const uint64_t partLimit = std::min<uint64_t>(partMB * 1024 * 1024, 0xF0000000ull);
+
+    std::vector<Source> sources;
+    if (fs::is_directory(input)) collectFolder(input, sources);
+    else                         collectV1(input, sources);
+    if (sources.empty()) {
+        std::fprintf(stderr, "no input sounds found in %s\n", input.c_str());
+        return 1;
+    }
+
+#ifdef BOXWAV_PACK_SDL
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+        std::fprintf(stderr, "SDL_Init: %s\n", SDL_GetError());
+        return 1;
+    }
+    Mix_Init(MIX_INIT_OGG | MIX_INIT_FLAC);
+    if (Mix_OpenAudio(rate, AUDIO_S16LSB, channels, 512) < 0) {
+        std::fprintf(stderr, "Mix_OpenAudio: %s\n", Mix_GetError());
+        return 1;
+    }
+    int qRate = 0, qCh = 0;
+    Uint16 qFmt = 0;
+    Mix_QuerySpec(&qRate, &qFmt, &qCh);
+    if (qRate != rate || qCh != channels || qFmt != AUDIO_S16LSB) {
+        std::fprintf(stderr, "mixer opened as %dHz %dch fmt=%04x, expected %dHz %dch S16LSB\n",
+                     qRate, qCh, qFmt, rate, channels);
+        return 1;
+    }
+#endif
+
+    // 先頭パート: ヘッダ + 目次の場所を空けてからデータを書き、最後に目次を書き戻す
+    std::string base = output.substr(0, output.size() - 7);
+    std::vector<BoxWav::TocEntryV2> toc(sources.size());
+    std::vector<uint64_t> digests(sources.size(), 0);
+    uint64_t tocOffset = sizeof(BoxWav::HeaderV2);
+    uint64_t dataStart = (tocOffset + toc.size() * sizeof(BoxWav::TocEntryV2) + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+
+    uint32_t partIdx = 0;
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::fprintf(stderr, "cannot open %s\n", output.c_str());
+        return 1;
+    }
+    std::vector<uint8_t> zeros(dataStart, 0);
+    out.write((const char*)zeros.data(), (std::streamsize)dataStart);
+    uint64_t pos = dataStart;
+
+    uint64_t inBytes = 0, outBytes = 0;
+    uint32_t converted = 0, kept = 0, failed = 0;
+    std::vector<uint8_t> bytes, pcm;
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const Source& src = sources[i];
+        BoxWav::TocEntryV2& e = toc[i];
+        std::memset(&e, 0, sizeof(e));
+        std::memcpy(e.name, src.name.data(), std::min(src.name.size(), BoxWav::NAME_LEN));
+
+        if (!readBytes(src, bytes)) {
+            std::fprintf(stderr, "read failed: %s\n", src.name.c_str());
+            failed++;
+            e.size = 0;
+            continue;
+        }
+        inBytes += bytes.size();
+
+        const uint8_t* data = bytes.data();
+        uint32_t       size = (uint32_t)bytes.size();
+        if (decodeToPcm(bytes, rate, channels, pcm)) {
+            data         = pcm.data();
+            size         = (uint32_t)pcm.size();
+            e.format     = BoxWav::FORMAT_S16;
+            e.channels   = (uint16_t)channels;
+            e.sampleRate = (uint32_t)rate;
+            e.frames     = size / (uint32_t)(sizeof(int16_t) * channels);
+            converted++;
+        } else {
+            std::fprintf(stderr, "kept as file (not decodable here): %s\n", src.name.c_str());
+            e.format = BoxWav::FORMAT_FILE;
+            kept++;
+        }
+
+        // パートが満杯なら次のパートへ (空のパートは作らない)
+        uint64_t aligned = (pos + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+        if (aligned + size > partLimit && aligned > (partIdx == 0 ? dataStart : 0)) {
+            out.close();
+            partIdx++;
+            std::string partPath = base + std::to_string(partIdx + 1) + ".boxwav";
+            out.open(partPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::fprintf(stderr, "cannot open %s\n", partPath.c_str());
+                return 1;
+            }
+            pos = aligned = 0;
+        }
+        if (aligned > pos) {
+            out.write((const char*)zeros.data(), (std::streamsize)(aligned - pos));
+            pos = aligned;
+        }
+
+        e.part   = partIdx;
+        e.offset = pos;
+        e.size   = size;
+        out.write((const char*)data, size);
+        digests[i] = digest(data, size);
+        pos      += size;
+        outBytes += size;
+
+        if ((i + 1) % 100 == 0) std::printf("  %zu / %zu\n", i + 1, sources.size());
+    }
+    out.close();
+
+    // ヘッダと目次を先頭パートへ書き戻す
+    BoxWav::HeaderV2 header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic      = BoxWav::MAGIC_V2;
+    header.version    = BoxWav::VERSION_V2;
+    header.entryCount = (uint32_t)toc.size();
+    header.partCount  = partIdx + 1;
+    header.sampleRate = (uint32_t)rate;
+    header.channels   = (uint16_t)channels;
+    header.tocOffset  = tocOffset;
+
+    std::fstream first(output, std::ios::binary | std::ios::in | std::ios::out);
+    first.write((const char*)&header, sizeof(header));
+    first.seekp((std::streamoff)tocOffset);
+    first.write((const char*)toc.data(), (std::streamsize)(toc.size() * sizeof(BoxWav::TocEntryV2)));
+    first.close();
+
+    std::printf("%s: %zu entries (%u converted to %dHz %dch S16, %u kept as file, %u failed), %u part(s)\n",
+                output.c_str(), sources.size(), converted, rate, channels, kept, failed, header.partCount);
+    std::printf("input %.1f MB -> output %.1f MB\n", inBytes / (1024.0 * 1024.0), outBytes / (1024.0 * 1024.0));
+    const bool verified = verifyPack(base, toc, digests);
+
+#ifdef BOXWAV_PACK_SDL
+    Mix_CloseAudio();
+    Mix_Quit();
+    SDL_Quit();
+#endif
+    if (!verified) return 3;
+    return failed ? 2 : 0;
+}
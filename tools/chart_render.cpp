@@ -0,0 +1,198 @@
+// ============================================================
+//  chart_render — 譜面1曲分の音を WAV に書き出す / ミキサーのベンチマーク (ホスト用)
+//
+//  ChartRenderer (演奏中と同じ AudioMixer) で BGM とオートプレイのキー音を
+//  実時間より速く混ぜる。サウンドデバイスは使わない。
+//    - 出力 PCM のハッシュ: 同じ譜面・同じ設定なら常に同じ値 (回帰テストの基準)
+//    - 速さ: CPU 1 秒あたり何秒分の音を作れたか
+//  --repeat N で N 回描画し、ハッシュが変わらないこと (決定的であること) も確かめる。
+//
+//  キー音は PCM WAV だけを WavDecoder で読む。OGG などは chart_render_sdl
+//  (make -C tools sdl。SDL2_mixer が必要) で SDL_mixer に任せる。
+//  --synth は譜面ファイル無しで、合成したキー音と譜面 (密な BGM + 8 レーン) を使う。
+//
+//  使い方: make -C tools chart_render
+//          tools/chart_render path/to/chart.bmson [-o out.wav] [--rate 22050] [--ch 1] [--block 512]
+//                             [--poly 2] [--no-choke] [--bgm-only] [--repeat 1]
+//          tools/chart_render --synth [--sec 120] [--density 40] [...]
+// ============================================================
+#include "../ChartRenderer.hpp"
+#include "../BmsonLoader.hpp"
+#include "../WavDecoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef CHART_RENDER_SDL
+#include <SDL.h>
+#include <SDL_mixer.h>
+#endif
+
+struct LoadedSound {
+    std::vector<int16_t> pcm;
+    ChartRenderer::Sound sound;
+};
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// WAV は WavDecoder、それ以外は (SDL 版なら) SDL_mixer。ゲームの decodeBytes と同じ順
+static bool loadSound(const std::string& path, int rate, int ch, std::vector<int16_t>& pcm) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) return false;
+    WavDecoder::Info info;
+    if (WavDecoder::parse(bytes.data(), bytes.size(), info)) {
+        pcm.resize((size_t)WavDecoder::outputFrames(info, rate) * ch);
+        return WavDecoder::convert(info, pcm.data(), rate, ch);
+    }
+#ifdef CHART_RENDER_SDL
+    Mix_Chunk* c = Mix_LoadWAV_RW(SDL_RWFromConstMem(bytes.data(), (int)bytes.size()), 1);
+    if (!c) return false;
+    const int16_t* s = reinterpret_cast<const int16_t*>(c->abuf);
+    pcm.assign(s, s + c->alen / sizeof(int16_t));
+    Mix_FreeChunk(c);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 合成譜面: 長さの違う減衰音 16 種。BGM は density 発/秒、プレイヤーは 8 レーンで計 12 発/秒
+static void makeSynth(int sec, int density, int rate, int ch, std::vector<ChartRenderer::Event>& events,
+                      std::unordered_map<uint32_t, LoadedSound>& sounds) {
+    for (uint32_t id = 1; id <= 16; id++) {
+        uint32_t frames = (uint32_t)(rate * (0.1 + 0.1 * id));
+        LoadedSound& ls = sounds[id];
+        ls.pcm.resize((size_t)frames * ch);
+        double f0 = 110.0 * id;
+        for (uint32_t i = 0; i < frames; i++) {
+            double env = std::exp(-4.0 * i / frames);
+            for (int c = 0; c < ch; c++)
+                ls.pcm[(size_t)i * ch + c] = (int16_t)(8000.0 * env * std::sin(2.0 * M_PI * f0 * (c + 1) * i / rate));
+        }
+    }
+    uint32_t seed = 0x2468ACEu;
+    auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int i = 0; i < sec * density; i++)
+        events.push_back({1000.0 * i / density, 1 + rnd() % 16, 0});
+    for (int i = 0; i < sec * 12; i++)
+        events.push_back({1000.0 * i / 12.0, 1 + rnd() % 16, 1 + (int)(rnd() % 8)});
+    std::stable_sort(events.begin(), events.end(), [](const ChartRenderer::Event& a, const ChartRenderer::Event& b) {
+        if (a.ms != b.ms) return a.ms < b.ms;
+        return a.lane < b.lane;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::string chart, outPath;
+    bool synth = false, autoplay = true;
+    int sec = 120, density = 40, repeat = 1;
+    ChartRenderer::Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "-o"        && i + 1 < argc) outPath         = argv[++i];
+        else if (a == "--rate"    && i + 1 < argc) opt.rate        = std::atoi(argv[++i]);
+        else if (a == "--ch"      && i + 1 < argc) opt.channels    = std::atoi(argv[++i]);
+        else if (a == "--block"   && i + 1 < argc) opt.blockFrames = std::atoi(argv[++i]);
+        else if (a == "--poly"    && i + 1 < argc) opt.polyphony   = std::atoi(argv[++i]);
+        else if (a == "--repeat"  && i + 1 < argc) repeat          = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--sec"     && i + 1 < argc) sec             = std::atoi(argv[++i]);
+        else if (a == "--density" && i + 1 < argc) density         = std::atoi(argv[++i]);
+        else if (a == "--no-choke") opt.laneChoke = false;
+        else if (a == "--bgm-only") autoplay = false;
+        else if (a == "--synth")    synth = true;
+        else if (a[0] != '-')       chart = a;
+    }
+    if ((!synth && chart.empty()) || opt.rate < 8000 || sec < 1 || density < 1) {
+        std::fprintf(stderr, "usage: %s chart.bmson|--synth [-o out.wav] [--rate 22050] [--ch 1] [--block 512]\n"
+                             "       [--poly 2] [--no-choke] [--bgm-only] [--repeat 1] [--sec 120] [--density 40]\n", argv[0]);
+        return 1;
+    }
+    opt.channels = (opt.channels == 2) ? 2 : 1;
+
+    std::vector<ChartRenderer::Event> events;
+    std::unordered_map<uint32_t, LoadedSound> sounds;
+    uint32_t failed = 0;
+    if (synth) {
+        makeSynth(sec, density, opt.rate, opt.channels, events, sounds);
+        if (!autoplay) events.erase(std::remove_if(events.begin(), events.end(),
+                                                   [](const ChartRenderer::Event& e) { return e.lane > 0; }), events.end());
+    } else {
+#ifdef CHART_RENDER_SDL
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+        SDL_Init(SDL_INIT_AUDIO);
+        SDL_SetHint("SDL_AUDIO_RESAMPLING_MODE", "linear");
+        if (Mix_OpenAudio(opt.rate, AUDIO_S16SYS, opt.channels, opt.blockFrames) < 0) {
+            std::fprintf(stderr, "Mix_OpenAudio: %s\n", Mix_GetError());
+            return 1;
+        }
+#endif
+        BMSData data = BmsonLoader::load(chart);
+        if (data.sound_channels.empty()) {
+            std::fprintf(stderr, "cannot load %s\n", chart.c_str());
+            return 1;
+        }
+        events = ChartRenderer::eventsFromChart(data, autoplay);
+        const std::string dir = chart.substr(0, chart.find_last_of("/\\") + 1);
+        for (const auto& ch : data.sound_channels) {
+            uint32_t id = std::hash<std::string>{}(ch.name);
+            if (ch.name.empty() || sounds.count(id)) continue;
+            LoadedSound& ls = sounds[id];
+            if (!loadSound(dir + ch.name, opt.rate, opt.channels, ls.pcm)) failed++;
+        }
+    }
+    for (auto& [id, ls] : sounds) {
+        ls.sound.pcm     = ls.pcm.data();
+        ls.sound.samples = (uint32_t)ls.pcm.size();
+    }
+    auto lookup = [&](uint32_t id) -> const ChartRenderer::Sound* {
+        auto it = sounds.find(id);
+        return (it != sounds.end() && it->second.sound.samples) ? &it->second.sound : nullptr;
+    };
+
+    ChartRenderer::Result first;
+    bool deterministic = true;
+    double bestSpeed = 0.0;
+    for (int r = 0; r < repeat; r++) {
+        ChartRenderer::Result res;
+        if (r == 0 && !outPath.empty()) {
+            if (!ChartRenderer::renderToWav(events, lookup, opt, outPath, res)) {
+                std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+                return 1;
+            }
+        } else {
+            res = ChartRenderer::render(events, lookup, opt, nullptr);
+        }
+        if (r == 0) first = res;
+        else if (res.hash != first.hash) deterministic = false;
+        bestSpeed = std::max(bestSpeed, res.speed());
+    }
+
+    const AudioMixer::Stats& ms = first.stats;
+    std::printf("%s: %d Hz / %d ch / %d frames, poly %d, choke %s, %s, kernel %s\n",
+                synth ? "synthetic" : chart.c_str(), opt.rate, opt.channels, opt.blockFrames, opt.polyphony,
+                opt.laneChoke ? "on" : "off", autoplay ? "BGM + autoplay" : "BGM only", AudioMixer::kernelName());
+    std::printf("sounds: %zu (%u not decoded), events: %u (%u without sound)\n",
+                sounds.size(), failed, first.events, first.missing);
+    std::printf("audio %.1f s, cpu %.3f s, wall %.3f s -> %.1fx realtime (best of %d: %.1fx)\n",
+                first.audioSec, first.cpuSec, first.wallSec, first.speed(), repeat, bestSpeed);
+    std::printf("voices avg %.1f peak %u, stolen %llu, polyCuts %llu, chokeCuts %llu, late %llu, dropped %llu\n",
+                ms.avgVoices(), ms.peakVoices, (unsigned long long)ms.stolenVoices, (unsigned long long)ms.polyCuts,
+                (unsigned long long)ms.chokeCuts, (unsigned long long)ms.lateEvents, (unsigned long long)ms.droppedTriggers);
+    std::printf("pcm hash %016llx%s%s\n", (unsigned long long)first.hash,
+                repeat > 1 ? (deterministic ? " (identical across runs)" : " (DIFFERS between runs)") : "",
+                outPath.empty() ? "" : (" -> " + outPath).c_str());
+#ifdef CHART_RENDER_SDL
+    if (!synth) { Mix_CloseAudio(); SDL_Quit(); }
+#endif
+    return deterministic ? 0 : 2;
+}
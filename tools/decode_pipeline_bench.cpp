@@ -0,0 +1,157 @@
+// ============================================================
+//  decode_pipeline_bench — DecodePipeline のスケーリング計測 (ホスト用)
+//
+//  合成した v1 .boxwav (既定: 48kHz ステレオ 24bit の WAV × 400 本) を
+//  本体のロードと同じ形 (MappedFile + オフセット順の I/O スレッド1本) で読み、
+//  デコードのワーカー数を 1〜N に変えて所要時間を比べる。
+//    serial : 旧実装と同じ「読む → デコード → 次」の1スレッドループ
+//    pipe N : DecodePipeline (I/O 1本 + デコード N 本)
+//  デコードは WavDecoder の汎用経路 (24bit → float → 22050Hz モノラル) を
+//  --passes 回繰り返したもので代用する。OGG / FLAC (SDL_mixer) と同じく
+//  CPU 律速の処理として、既定の 6 回で Vorbis のデコードと同程度の重さになる。
+//  全モードの出力のチェックサムが一致することも確認する。
+//
+//  使い方: make -C tools decode_pipeline_bench && tools/decode_pipeline_bench [--threads 4] [--passes 6]
+// ============================================================
+#include "../DecodePipeline.hpp"
+#include "../MappedFile.hpp"
+#include "../WavDecoder.hpp"
+#include "WavFixture.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int DST_RATE = 22050;
+
+struct Entry { uint32_t offset, size; };
+
+static std::vector<uint8_t> makeWav(int frames, std::mt19937& rng) {
+    const int ch = 2, bits = 24;
+    std::vector<uint8_t> v;
+    WavFixture::beginWav(v, 48000, ch, bits, (uint32_t)frames);
+    std::uniform_int_distribution<int> dist(-20000, 20000);
+    for (uint32_t i = 0; i < (uint32_t)frames * ch; i++) WavFixture::putSample(v, bits, (int16_t)dist(rng));
+    return v;
+}
+
+// v1 形式: count, d1, d2, count × {name[32], size, data}
+static std::vector<Entry> writeSynthetic(const std::string& path, int count) {
+    std::vector<Entry> entries;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> framesDist(4800, 48000); // 0.1〜1 秒
+    std::ofstream ofs(path, std::ios::binary);
+    uint32_t c = (uint32_t)count, zero = 0;
+    ofs.write((char*)&c, 4);
+    ofs.write((char*)&zero, 4);
+    ofs.write((char*)&zero, 4);
+    for (int i = 0; i < count; ++i) {
+        char name[32] = {};
+        std::snprintf(name, sizeof(name), "sound%04d.wav", i);
+        std::vector<uint8_t> wav = makeWav(framesDist(rng), rng);
+        uint32_t size = (uint32_t)wav.size();
+        ofs.write(name, 32);
+        ofs.write((char*)&size, 4);
+        entries.push_back({(uint32_t)ofs.tellp(), size});
+        ofs.write((const char*)wav.data(), size);
+    }
+    return entries;
+}
+
+// デコードの代用。結果はチェックサムだけ返す (0 は失敗扱いにしないよう 1 を足す)
+static uint64_t decodeStandIn(const uint8_t* bytes, uint32_t size, int passes) {
+    WavDecoder::Info info;
+    if (!WavDecoder::parse(bytes, size, info)) return 0;
+    std::vector<int16_t> out(WavDecoder::outputFrames(info, DST_RATE));
+    uint64_t sum = 1;
+    for (int p = 0; p < passes; ++p) WavDecoder::convert(info, out.data(), DST_RATE, 1);
+    for (int16_t s : out) sum = sum * 31 + (uint16_t)s;
+    return sum;
+}
+
+static uint64_t runSerial(MappedFile& part, const std::vector<Entry>& entries, int passes) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 8 < entries.size()) part.prefault(entries[i + 8].offset, entries[i + 8].size);
+        const uint8_t* p = part.view(entries[i].offset, entries[i].size);
+        if (p) total += decodeStandIn(p, entries[i].size, passes);
+    }
+    return total;
+}
+
+static uint64_t runPipeline(MappedFile& part, const std::vector<Entry>& entries, int passes, int workers) {
+    DecodePipeline pipeline;
+    std::vector<uint64_t> sums(entries.size(), 0);
+    pipeline.start((uint32_t)entries.size(), workers,
+        [&](uint32_t i, DecodePipeline::Blob& out) {
+            part.fault(entries[i].offset, entries[i].size);
+            out.data = part.view(entries[i].offset, entries[i].size);
+            out.size = entries[i].size;
+            return out.data != nullptr;
+        },
+        [&](uint32_t, const uint8_t* data, uint32_t size) -> void* {
+            return reinterpret_cast<void*>((uintptr_t)decodeStandIn(data, size, passes));
+        },
+        nullptr);
+    uint64_t total = 0;
+    while (!pipeline.finished()) {
+        size_t n = pipeline.drain([&](uint32_t, void* r) { total += (uint64_t)(uintptr_t)r; });
+        if (n == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    pipeline.join();
+    return total;
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = 4, passes = 6, count = 400;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--threads" && i + 1 < argc) maxThreads = std::atoi(argv[++i]);
+        else if (a == "--passes"  && i + 1 < argc) passes     = std::atoi(argv[++i]);
+        else if (a == "--count"   && i + 1 < argc) count      = std::atoi(argv[++i]);
+    }
+    if (maxThreads < 1 || passes < 1 || count < 1) {
+        std::fprintf(stderr, "usage: %s [--threads 4] [--passes 6] [--count 400]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string path = "/tmp/decode_pipeline_bench.boxwav";
+    std::printf("writing synthetic %s (%d entries) ...\n", path.c_str(), count);
+    std::vector<Entry> entries = writeSynthetic(path, count);
+    uint64_t bytes = 0;
+    for (const auto& e : entries) bytes += e.size;
+
+    MappedFile part;
+    if (!part.open(path)) return 1;
+    std::printf("%.1f MB, %u hardware threads, decode kernel %s\n", bytes / (1024.0 * 1024.0),
+                std::thread::hardware_concurrency(), WavDecoder::kernelName());
+    std::printf("%-8s %10s %10s %10s\n", "mode", "ms", "MB/s", "speedup");
+
+    auto timeIt = [](auto&& fn, uint64_t& sum) {
+        auto t0 = std::chrono::steady_clock::now();
+        sum = fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    uint64_t ref = 0;
+    runSerial(part, entries, 1); // ページキャッシュを温める
+    double base = timeIt([&] { return runSerial(part, entries, passes); }, ref);
+    std::printf("%-8s %10.1f %10.1f %10.2f\n", "serial", base, bytes / (1024.0 * 1024.0) / (base / 1000.0), 1.0);
+
+    bool ok = true;
+    for (int t = 1; t <= maxThreads; ++t) {
+        uint64_t sum = 0;
+        double ms = timeIt([&] { return runPipeline(part, entries, passes, t); }, sum);
+        char label[16];
+        std::snprintf(label, sizeof(label), "pipe %d", t);
+        std::printf("%-8s %10.1f %10.1f %10.2f%s\n", label, ms, bytes / (1024.0 * 1024.0) / (ms / 1000.0),
+                    base / ms, sum == ref ? "" : "  CHECKSUM MISMATCH");
+        ok = ok && sum == ref;
+    }
+    return ok ? 0 : 2;
+}
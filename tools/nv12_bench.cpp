@@ -0,0 +1,119 @@
+// ============================================================
+//  nv12_bench — Nv12Converter のカーネル別の速度と一致確認 (ホスト用)
+//
+//  動画 BGA でよくある解像度ごとに、この CPU で使える全カーネルについて
+//  (どれも BgaManager::render がデコーダの面からロックしたテクスチャへ書く処理)
+//    interleave : YUV420P の U / V → NV12 の UV   (FFmpeg と同じく linesize を 64 に揃えて余白付き → pitch == width)
+//    copy tight : Y + UV 面をストライド一致でコピー (linesize == pitch == width)
+//    copy pitch : Y + UV 面を pitch 付きでコピー   (pitch を 256 に揃えたテクスチャ)
+//  の MB/s (書き込んだバイト数基準) を測る。各カーネルの出力がスカラー版と
+//  全バイト一致することも確かめる。
+//
+//  使い方: make -C tools nv12_bench && tools/nv12_bench [--ms 200]
+// ============================================================
+#include "../Nv12Converter.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Size { int w, h; const char* name; };
+
+static int alignUp(int x, int a) { return (x + a - 1) / a * a; }
+
+// 1回 fn を呼んで書くバイト数 bytes。minMs 以上回して MB/s を返す
+template <class F>
+static double measure(F fn, size_t bytes, double minMs) {
+    fn(); // 暖機
+    int reps = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double ms = 0.0;
+    do {
+        for (int i = 0; i < 8; i++) fn();
+        reps += 8;
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    } while (ms < minMs);
+    return (double)bytes * reps / (1024.0 * 1024.0) / (ms / 1000.0);
+}
+
+int main(int argc, char* argv[]) {
+    double minMs = 200.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--ms" && i + 1 < argc) minMs = std::atof(argv[++i]);
+    }
+    if (minMs <= 0.0) {
+        std::fprintf(stderr, "usage: %s [--ms 200]\n", argv[0]);
+        return 1;
+    }
+
+    const Size sizes[] = {
+        {256, 256, "256x256"}, {512, 384, "512x384"}, {640, 480, "640x480"},
+        {1280, 720, "1280x720"}, {1920, 1080, "1920x1080"},
+    };
+    const Nv12Converter::Kernel startup = Nv12Converter::currentKernel();
+    std::printf("startup kernel: %s\n", Nv12Converter::kernelName(startup));
+    std::printf("%-10s %-7s %12s %12s %12s\n", "size", "kernel", "interleave", "copy tight", "copy pitch");
+
+    std::mt19937 rng(47);
+    bool ok = true;
+    for (const Size& s : sizes) {
+        const int w = s.w, h = s.h, cw = w / 2, ch = h / 2;
+        const int srcLs  = alignUp(cw, 64) + 64;   // FFmpeg の linesize (余白付き)
+        const int pitch  = alignUp(w, 256);        // ロックしたテクスチャの pitch
+        std::vector<uint8_t> u((size_t)srcLs * ch), v((size_t)srcLs * ch);
+        std::vector<uint8_t> slot((size_t)w * h * 3 / 2);
+        for (auto& b : u) b = (uint8_t)rng();
+        for (auto& b : v) b = (uint8_t)rng();
+        for (auto& b : slot) b = (uint8_t)rng();
+        std::vector<uint8_t> uv((size_t)w * ch), tight(slot.size()), pitched((size_t)pitch * (h + ch));
+        std::vector<uint8_t> refUv, refPitched;
+
+        const uint8_t* y   = slot.data();
+        const uint8_t* suv = slot.data() + (size_t)w * h;
+        auto interleave = [&]() {
+            Nv12Converter::interleaveUV(u.data(), srcLs, v.data(), srcLs, uv.data(), w, cw, ch);
+        };
+        auto copyTight = [&]() {
+            Nv12Converter::copyPlane(y,   w, tight.data(),                    w, w, h);
+            Nv12Converter::copyPlane(suv, w, tight.data() + (size_t)w * h,    w, w, ch);
+        };
+        auto copyPitch = [&]() {
+            Nv12Converter::copyPlane(y,   w, pitched.data(),                  pitch, w, h);
+            Nv12Converter::copyPlane(suv, w, pitched.data() + (size_t)pitch * h, pitch, w, ch);
+        };
+
+        for (int k = 0; k < Nv12Converter::KERNEL_COUNT; k++) {
+            const Nv12Converter::Kernel kernel = (Nv12Converter::Kernel)k;
+            if (!Nv12Converter::setKernel(kernel)) continue;
+
+            std::fill(uv.begin(), uv.end(), 0);
+            std::fill(tight.begin(), tight.end(), 0);
+            std::fill(pitched.begin(), pitched.end(), 0);
+            interleave(); copyTight(); copyPitch();
+            bool same = tight == slot;
+            if (kernel == Nv12Converter::KERNEL_SCALAR) {
+                refUv = uv;
+                refPitched = pitched;
+                for (int r = 0; r < ch && same; r++)
+                    for (int j = 0; j < cw; j++)
+                        if (uv[(size_t)r * w + 2 * j] != u[(size_t)r * srcLs + j] ||
+                            uv[(size_t)r * w + 2 * j + 1] != v[(size_t)r * srcLs + j]) { same = false; break; }
+            } else {
+                same = same && uv == refUv && pitched == refPitched;
+            }
+            if (!same) ok = false;
+
+            const double mbI = measure(interleave, uv.size(), minMs);
+            const double mbT = measure(copyTight, slot.size(), minMs);
+            const double mbP = measure(copyPitch, slot.size(), minMs);
+            std::printf("%-10s %-7s %9.0f MB/s %9.0f MB/s %9.0f MB/s%s\n", s.name, Nv12Converter::kernelName(kernel),
+                        mbI, mbT, mbP, same ? "" : "  MISMATCH");
+        }
+    }
+    Nv12Converter::setKernel(startup);
+    return ok ? 0 : 2;
+}
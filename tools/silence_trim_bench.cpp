@@ -0,0 +1,99 @@
+// ============================================================
+//  silence_trim_bench — SilenceTrimmer の検出速度と一致確認 (ホスト用)
+//
+//  キー音を模した合成 PCM (22050Hz モノラル、先頭 0〜20ms・末尾 0〜800ms の
+//  デジタル無音 + 微小ノイズ付き) を --count 本作り、SIMD 版とスカラー版で
+//  前後の無音を探す。両者の結果が全て一致することと、MB/s を確かめる。
+//  合わせて、切り落としで減るサンプルの割合も出す。
+//
+//  使い方: make -C tools silence_trim_bench && tools/silence_trim_bench [--count 2000] [--db -60]
+// ============================================================
+#include "../SilenceTrimmer.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr int RATE = 22050;
+
+struct Sound {
+    std::vector<int16_t> pcm;
+};
+
+static std::vector<Sound> makeSounds(int count) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> headDist(0, RATE * 20 / 1000);
+    std::uniform_int_distribution<int> bodyDist(RATE / 20, RATE / 2);
+    std::uniform_int_distribution<int> tailDist(0, RATE * 800 / 1000);
+    std::uniform_int_distribution<int> noise(-8, 8); // -60dBFS (32) を下回るディザ
+    std::vector<Sound> sounds(count);
+    for (auto& s : sounds) {
+        int head = headDist(rng), body = bodyDist(rng), tail = tailDist(rng);
+        s.pcm.resize((size_t)head + body + tail);
+        for (int i = 0; i < head; ++i) s.pcm[i] = (int16_t)noise(rng);
+        for (int i = 0; i < body; ++i) {
+            double env = std::exp(-6.0 * i / body);
+            s.pcm[head + i] = (int16_t)(20000.0 * env * std::sin(i * 0.07));
+        }
+        for (int i = 0; i < tail; ++i) s.pcm[(size_t)head + body + i] = (int16_t)noise(rng);
+    }
+    return sounds;
+}
+
+int main(int argc, char* argv[]) {
+    int count = 2000, db = -60, reps = 20;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--count" && i + 1 < argc) count = std::atoi(argv[++i]);
+        else if (a == "--db"    && i + 1 < argc) db    = std::atoi(argv[++i]);
+        else if (a == "--reps"  && i + 1 < argc) reps  = std::atoi(argv[++i]);
+    }
+    if (count < 1 || db >= 0 || reps < 1) {
+        std::fprintf(stderr, "usage: %s [--count 2000] [--db -60] [--reps 20]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Sound> sounds = makeSounds(count);
+    const int16_t threshold = SilenceTrimmer::thresholdFromDb(db);
+    uint64_t samples = 0;
+    for (const auto& s : sounds) samples += s.pcm.size();
+    const double mb = samples * sizeof(int16_t) / (1024.0 * 1024.0);
+
+    struct Result { size_t first, last; bool found; };
+    auto run = [&](bool scalar, std::vector<Result>& out, double& ms) {
+        SilenceTrimmer::setForceScalar(scalar);
+        out.assign(sounds.size(), Result{0, 0, false});
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r)
+            for (size_t i = 0; i < sounds.size(); ++i)
+                out[i].found = SilenceTrimmer::findAudible(sounds[i].pcm.data(), sounds[i].pcm.size(), threshold,
+                                                           out[i].first, out[i].last);
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / reps;
+    };
+
+    std::vector<Result> ref, simd;
+    double scalarMs = 0.0, simdMs = 0.0;
+    run(true, ref, scalarMs);
+    run(false, simd, simdMs);
+    const char* kernel = SilenceTrimmer::kernelName();
+
+    bool ok = true;
+    uint64_t kept = 0;
+    for (size_t i = 0; i < sounds.size(); ++i) {
+        const Result& a = ref[i];
+        const Result& b = simd[i];
+        if (a.found != b.found || (a.found && (a.first != b.first || a.last != b.last))) ok = false;
+        if (a.found) kept += a.last - a.first + 1;
+    }
+
+    std::printf("%d sounds, %.1f MB, threshold %d (%d dBFS)\n", count, mb, threshold, db);
+    std::printf("%-8s %10s %10s\n", "kernel", "ms", "MB/s");
+    std::printf("%-8s %10.2f %10.1f\n", "scalar", scalarMs, mb / (scalarMs / 1000.0));
+    std::printf("%-8s %10.2f %10.1f  (%.2fx)\n", kernel, simdMs, mb / (simdMs / 1000.0), scalarMs / simdMs);
+    std::printf("trimmed: %.1f%% of samples%s\n", 100.0 * (1.0 - (double)kept / samples),
+                ok ? "" : "  MISMATCH");
+    return ok ? 0 : 2;
+}
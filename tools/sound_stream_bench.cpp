@@ -0,0 +1,127 @@
+// ============================================================
+//  sound_stream_bench — SoundStream の一致確認と読み込みの余裕 (ホスト用)
+//
+//  長い WAV (既定 44.1kHz ステレオ 16bit、90 秒) を一時ファイルに書き、
+//  ゲームと同じ 22050Hz モノラルへ変換しながら流す。
+//  読み込みスレッドを1本立て、オーディオスレッド役は 512 フレームずつ read() する。
+//  --speed 倍の速さでコールバックを回し、
+//    - 出力が全体を WavDecoder::convert した結果と一致するか (アンダーランが無ければ。
+//      同じレート・丁度 2 倍以外はブロック境界で補間の位相がずれるので、最大誤差を出す)
+//    - アンダーランの回数
+//    - 常駐する量 (先読み + ダブルバッファ) と全体を常駐させた場合の量
+//  を出す。途中で何度か頭から鳴らし直し (再発音)、世代の切り替えも確かめる。
+//
+//  使い方: make -C tools sound_stream_bench && tools/sound_stream_bench [--sec 90] [--rate 44100] [--speed 8]
+// ============================================================
+#include "../SoundStream.hpp"
+#include "../WavDecoder.hpp"
+#include "WavFixture.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int DST_RATE = 22050;
+static constexpr int DST_CH   = 1;
+static constexpr int CALLBACK = 512;
+
+// 44 バイトのヘッダ + ステレオの掃引音
+static std::vector<uint8_t> makeWav(int rate, int sec) {
+    uint32_t frames = (uint32_t)rate * sec;
+    std::vector<uint8_t> v;
+    WavFixture::beginWav(v, rate, 2, 16, frames);
+    double ph = 0.0;
+    for (uint32_t i = 0; i < frames; ++i) {
+        ph += 2.0 * M_PI * (200.0 + 1800.0 * i / frames) / rate;
+        WavFixture::putSample(v, 16, (int16_t)(12000.0 * std::sin(ph)));
+        WavFixture::putSample(v, 16, (int16_t)(9000.0 * std::sin(ph * 1.5)));
+    }
+    return v;
+}
+
+int main(int argc, char* argv[]) {
+    int sec = 90, rate = 44100;
+    double speed = 8.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if      (a == "--sec"   && i + 1 < argc) sec   = std::atoi(argv[++i]);
+        else if (a == "--rate"  && i + 1 < argc) rate  = std::atoi(argv[++i]);
+        else if (a == "--speed" && i + 1 < argc) speed = std::atof(argv[++i]);
+    }
+    if (sec < 3 || rate < 8000 || speed <= 0.0) {
+        std::fprintf(stderr, "usage: %s [--sec 90] [--rate 44100] [--speed 8]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> wav = makeWav(rate, sec);
+    const std::string path = "/tmp/sound_stream_bench.wav";
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f || std::fwrite(wav.data(), 1, wav.size(), f) != wav.size()) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+    }
+    std::fclose(f);
+
+    WavDecoder::Info info;
+    if (!WavDecoder::parse(wav.data(), wav.size(), info)) return 1;
+    std::vector<int16_t> ref((size_t)WavDecoder::outputFrames(info, DST_RATE) * DST_CH);
+    WavDecoder::convert(info, ref.data(), DST_RATE, DST_CH);
+    const uint64_t dataOffset = (uint64_t)(info.data - wav.data());
+
+    SoundStream stream;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!stream.open(path, dataOffset, info, DST_RATE, DST_CH)) {
+        std::fprintf(stderr, "open failed\n");
+        return 1;
+    }
+    double openMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::atomic<bool> quit{false};
+    std::thread reader([&] {
+        while (!quit.load()) {
+            if (!stream.fill()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+
+    // 1回目は最後まで、2回目以降は途中で頭から鳴らし直す
+    const uint32_t total = stream.totalSamples();
+    const uint32_t plays[] = { total, total / 3, total / 7, total };
+    const auto period = std::chrono::duration<double>(CALLBACK / (double)DST_RATE / speed);
+    std::vector<int16_t> out(CALLBACK * DST_CH);
+    uint64_t mismatches = 0, callbacks = 0;
+    int maxDiff = 0;
+    auto next = std::chrono::steady_clock::now();
+    for (uint32_t len : plays) {
+        stream.restart();
+        for (uint32_t pos = 0; pos < len; pos += CALLBACK * DST_CH) {
+            uint32_t n = std::min<uint32_t>(CALLBACK * DST_CH, total - pos);
+            uint64_t before = stream.getUnderruns();
+            stream.read(pos, out.data(), n);
+            if (stream.getUnderruns() == before && std::memcmp(out.data(), ref.data() + pos, n * sizeof(int16_t)) != 0) {
+                mismatches++;
+                for (uint32_t k = 0; k < n; ++k) maxDiff = std::max(maxDiff, std::abs(out[k] - ref[pos + k]));
+            }
+            callbacks++;
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            std::this_thread::sleep_until(next);
+        }
+    }
+    quit.store(true);
+    reader.join();
+    std::remove(path.c_str());
+
+    std::printf("%d s @ %d Hz stereo -> %d Hz mono, %.1fx realtime\n", sec, rate, DST_RATE, speed);
+    std::printf("open (head %u ms): %.2f ms\n", SoundStream::HEAD_MS, openMs);
+    std::printf("resident: %.1f KB (full PCM %.1f KB)\n", stream.bufferBytes() / 1024.0,
+                total * sizeof(int16_t) / 1024.0);
+    std::printf("callbacks: %llu, underruns: %llu, mismatches: %llu (max |diff| %d)\n", (unsigned long long)callbacks,
+                (unsigned long long)stream.getUnderruns(), (unsigned long long)mismatches, maxDiff);
+    const bool exact = rate == DST_RATE || rate == DST_RATE * 2;
+    return (exact ? mismatches == 0 : maxDiff < 64) ? 0 : 2;
+}
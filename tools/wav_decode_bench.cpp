@@ -0,0 +1,112 @@
+// ============================================================
+//  wav_decode_bench — WavDecoder のホスト用ベンチマーク
+//
+//  合成した WAV (既定: 1 秒 × 200 本) を 22050Hz モノラルへ変換し、
+//  入力バイト数ベースのスループット (MB/s) を計測する。
+//    simd   : WavDecoder (融合カーネル NEON/SSE2)
+//    scalar : WavDecoder (setForceScalar)
+//    sdl    : Mix_LoadWAV_RW (従来の経路)。WAVBENCH_SDL 付きでビルドした時のみ
+//  あわせて SIMD とスカラーの出力がビット単位で一致するかを確認する。
+//
+//  使い方: make -C tools wav_decode_bench && tools/wav_decode_bench [files]
+//          SDL 比較込み: make -C tools sdl && tools/wav_decode_bench_sdl
+// ============================================================
+#include "../WavDecoder.hpp"
+#include "WavFixture.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#ifdef WAVBENCH_SDL
+#include <SDL.h>
+#include <SDL_mixer.h>
+#endif
+
+static constexpr int DST_RATE = 22050;
+static constexpr int DST_CH   = 1;
+
+static std::vector<uint8_t> makeWav(int rate, int ch, int bits, int frames, std::mt19937& rng) {
+    std::vector<uint8_t> v;
+    WavFixture::beginWav(v, rate, ch, bits, (uint32_t)frames);
+    std::uniform_int_distribution<int> dist(-20000, 20000);
+    for (uint32_t i = 0; i < (uint32_t)frames * ch; i++) WavFixture::putSample(v, bits, (int16_t)dist(rng));
+    return v;
+}
+
+static double benchDecoder(const std::vector<std::vector<uint8_t>>& files, bool scalar,
+                           std::vector<std::vector<int16_t>>& outs) {
+    WavDecoder::setForceScalar(scalar);
+    outs.resize(files.size());
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < files.size(); i++) {
+        WavDecoder::Info info;
+        if (!WavDecoder::parse(files[i].data(), files[i].size(), info)) return -1.0;
+        outs[i].resize((size_t)WavDecoder::outputFrames(info, DST_RATE) * DST_CH);
+        WavDecoder::convert(info, outs[i].data(), DST_RATE, DST_CH);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+#ifdef WAVBENCH_SDL
+static double benchSdl(const std::vector<std::vector<uint8_t>>& files) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& f : files) {
+        Mix_Chunk* c = Mix_LoadWAV_RW(SDL_RWFromConstMem(f.data(), (int)f.size()), 1);
+        if (c) Mix_FreeChunk(c);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    int count = (argc > 1) ? std::atoi(argv[1]) : 200;
+#ifdef WAVBENCH_SDL
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SDL_Init(SDL_INIT_AUDIO);
+    SDL_SetHint("SDL_AUDIO_RESAMPLING_MODE", "linear");
+    if (Mix_OpenAudio(DST_RATE, AUDIO_S16SYS, DST_CH, 512) < 0) {
+        std::fprintf(stderr, "Mix_OpenAudio: %s\n", Mix_GetError());
+        return 1;
+    }
+#endif
+
+    struct Case { const char* label; int rate, ch, bits; };
+    const Case cases[] = {
+        {"44.1k stereo 16bit", 44100, 2, 16},
+        {"44.1k mono 16bit",   44100, 1, 16},
+        {"22.05k stereo 16bit", 22050, 2, 16},
+        {"48k stereo 16bit",   48000, 2, 16},
+        {"44.1k stereo 24bit", 44100, 2, 24},
+    };
+
+    std::printf("kernel: %s, %d files x 1s -> %dHz %dch\n", WavDecoder::kernelName(), count, DST_RATE, DST_CH);
+    std::printf("%-20s %10s %10s %10s %8s\n", "input", "simd MB/s", "scalar", "sdl", "exact");
+    for (const Case& c : cases) {
+        std::mt19937 rng(7);
+        std::vector<std::vector<uint8_t>> files;
+        double mb = 0.0;
+        for (int i = 0; i < count; i++) {
+            files.push_back(makeWav(c.rate, c.ch, c.bits, c.rate, rng));
+            mb += files.back().size() / (1024.0 * 1024.0);
+        }
+
+        std::vector<std::vector<int16_t>> simdOut, scalarOut;
+        double simdMs   = benchDecoder(files, false, simdOut);
+        double scalarMs = benchDecoder(files, true, scalarOut);
+        bool exact = simdOut == scalarOut;
+        double sdlMbs = 0.0;
+#ifdef WAVBENCH_SDL
+        sdlMbs = mb / (benchSdl(files) / 1000.0);
+#endif
+        std::printf("%-20s %10.1f %10.1f %10.1f %8s\n", c.label, mb / (simdMs / 1000.0),
+                    mb / (scalarMs / 1000.0), sdlMbs, exact ? "yes" : "NO");
+    }
+
+#ifdef WAVBENCH_SDL
+    Mix_CloseAudio();
+    SDL_Quit();
+#endif
+    return 0;
+}